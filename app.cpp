@@ -1,10 +1,13 @@
 #include "app.hpp"
 #include "logger.hpp"
+#include "profile_zones.hpp"
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <iostream>
 #include <algorithm>
+#include <cstdio>
+#include <ctime>
 #include <glad/glad.h>
 #ifdef _WIN32
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -12,8 +15,7 @@
 #endif
 
 EarPerkApp::EarPerkApp() 
-    : window(nullptr)
-    , lastDeviceRefresh(std::chrono::steady_clock::now() - std::chrono::seconds(10)) { // Force initial refresh
+    : window(nullptr) {
 	try {
 		LOG_DEBUG("EarPerkApp constructor called");
 	} catch (...) {
@@ -31,11 +33,21 @@ EarPerkApp::EarPerkApp()
 EarPerkApp::~EarPerkApp() {
     try {
         LOG_DEBUG("EarPerkApp destructor called");
+
+        if (configWatcher) {
+            configWatcher->Stop();
+        }
+        if (metricsServer) {
+            metricsServer->Stop();
+        }
         
         // Save configuration before shutting down
         LOG_DEBUG("Saving configuration before shutdown");
         try {
             SaveConfiguration();
+            if (configWriter) {
+                configWriter->Stop();  // Writes the pending save now
+            }
             LOG_DEBUG("Configuration saved successfully");
         } catch (const std::exception& e) {
             LOG_ERROR_F("Exception saving configuration: %s", e.what());
@@ -160,6 +172,17 @@ bool EarPerkApp::Initialize() {
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
 
     // Setup Platform/Renderer backends
+    // Installed before the ImGui backend, which chains to them, so any
+    // input schedules a redraw
+    glfwSetWindowUserPointer(window, this);
+    glfwSetCursorPosCallback(window, [](GLFWwindow* w, double, double) { RequestRedraw(w); });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int, int, int) { RequestRedraw(w); });
+    glfwSetScrollCallback(window, [](GLFWwindow* w, double, double) { RequestRedraw(w); });
+    glfwSetKeyCallback(window, [](GLFWwindow* w, int, int, int, int) { RequestRedraw(w); });
+    glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int) { RequestRedraw(w); });
+    glfwSetWindowSizeCallback(window, [](GLFWwindow* w, int, int) { RequestRedraw(w); });
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow* w) { RequestRedraw(w); });
+
     LOG_INFO("Setting up ImGui backends");
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init(glsl_version);
@@ -171,6 +194,7 @@ bool EarPerkApp::Initialize() {
     // Initialize audio processor
     LOG_INFO("Creating audio processor");
     audioProcessor = std::make_unique<AudioProcessor>(std::ref(config));
+    publishedParams = config.GetDetectionParams();
     
     LOG_INFO("Attempting to initialize audio processor");
     if (!audioProcessor->Initialize()) {
@@ -183,8 +207,31 @@ bool EarPerkApp::Initialize() {
         audioProcessor->Start();
     }
 
+    // Reloads go straight to the audio thread; the UI adopts them on its
+    // next frame, which the empty event makes sure happens
+    configWatcher = std::make_unique<ConfigWatcher>(Config::GetDefaultConfigPath(),
+        [this](std::shared_ptr<const Config> next) {
+            audioProcessor->ReloadSettings(next);
+            glfwPostEmptyEvent();
+        });
+    configWatcher->Start();
+
+    // Tells the watcher about each write so it doesn't reload our own saves
+    const auto saveDebounce = std::chrono::milliseconds(500);
+    configWriter = std::make_unique<ConfigWriter>(Config::GetDefaultConfigPath(), saveDebounce,
+        [this](const std::string& content) { configWatcher->ExpectContent(content); });
+    configWriter->Start();
+
+    MetricsServer::Options metricsOptions;
+    metricsOptions.http_port = config.metrics_port;
+    metricsOptions.stats_address = config.stats_osc_address;
+    metricsOptions.stats_interval = std::chrono::milliseconds(std::max(100, config.stats_interval_ms));
+    metricsOptions.osc_host = config.address;
+    metricsOptions.osc_port = config.port;
+    metricsServer = std::make_unique<MetricsServer>(metricsOptions);
+    metricsServer->Start();
+
     LOG_INFO("Setting up GLFW window callbacks");
-    glfwSetWindowUserPointer(window, this);
     glfwSetWindowFocusCallback(window, WindowFocusCallback);
     glfwSetWindowIconifyCallback(window, WindowIconifyCallback);
     
@@ -194,22 +241,66 @@ bool EarPerkApp::Initialize() {
 
 void EarPerkApp::Run() {
     LOG_INFO("Starting main application loop");
+    PROFILE_THREAD("UI");
     
+    // Redraws are capped at max_fps and only happen when there is something
+    // new to show: input, new audio state, or the periodic refresh that
+    // expires status messages
+    const double idleRefreshInterval = 1.0;
+
     while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
+        // max_fps can change when config.ini is reloaded
+        const double frameInterval = 1.0 / std::max(1, config.max_fps);
 
-        // Skip rendering when minimized
+        // Nothing is visible, so sleep until the window comes back
         if (glfwGetWindowAttrib(window, GLFW_ICONIFIED) ||
             !glfwGetWindowAttrib(window, GLFW_VISIBLE)) {
+            glfwWaitEvents();
+            continue;
+        }
+
+        double now = glfwGetTime();
+        double untilNextFrame = lastFrameTime + frameInterval - now;
+        if (untilNextFrame > 0.0) {
+            glfwWaitEventsTimeout(untilNextFrame);
             continue;
         }
 
+        uint32_t snapshotVersion = audioProcessor->GetSnapshotVersion();
+        bool dirty = pendingRedrawFrames > 0
+            || snapshotVersion != drawnSnapshotVersion
+            || audioProcessor->GetDeviceListVersion() != cachedDeviceListVersion
+            || deviceSwitchPending
+            || configWatcher->Version() != adoptedConfigVersion
+            || ImGui::GetIO().WantTextInput  // Keep the text cursor blinking
+            || showPerfOverlay               // Plots move every frame
+            || now - lastFrameTime >= idleRefreshInterval;
+        if (!dirty) {
+            // New audio state doesn't raise a window event, so look again
+            // after one frame interval
+            glfwWaitEventsTimeout(frameInterval);
+            continue;
+        }
+
+        drawnSnapshotVersion = snapshotVersion;
+        lastFrameTime = now;
+        if (pendingRedrawFrames > 0) {
+            pendingRedrawFrames--;
+        }
+
+        auto frameStart = std::chrono::steady_clock::now();
+
         // Clear the background
         glClearColor(0.45f, 0.55f, 0.60f, 1.00f);
         glClear(GL_COLOR_BUFFER_BIT);
 
         RenderUI();
 
+        // Before the swap, which waits for vsync
+        auto frameEnd = std::chrono::steady_clock::now();
+        PerfMonitor::Get().ObserveFrame(frameEnd - frameStart, frameEnd);
+
+        PROFILE_ZONE("Swap buffers");
         glfwSwapBuffers(window);
     }
     
@@ -217,6 +308,23 @@ void EarPerkApp::Run() {
 }
 
 void EarPerkApp::RenderUI() {
+    PROFILE_ZONE("UI render");
+    AdoptReloadedConfig();
+
+    // Read the audio thread's state once so the whole frame is consistent
+    audioSnapshot = audioProcessor->GetSnapshot();
+    if (audioSnapshot.audio_working) {
+        // Auto thresholds are computed on the audio thread; mirror them so
+        // the sliders show them and they get saved
+        if (config.auto_volume_threshold) {
+            config.volume_threshold = audioSnapshot.volume_threshold;
+        }
+        if (config.auto_excessive_threshold) {
+            config.excessive_volume_threshold = audioSnapshot.excessive_volume_threshold;
+        }
+    }
+    TrackDeviceSwitch();
+
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -252,6 +360,12 @@ void EarPerkApp::RenderUI() {
 
     ImGui::End();
 
+    if (showPerfOverlay) {
+        DrawPerformanceOverlay();
+    }
+
+    PublishDetectionParams();
+
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
@@ -259,8 +373,8 @@ void EarPerkApp::RenderUI() {
 void EarPerkApp::DrawVolumeMeters() {
     ImGui::Text("Volume Levels");
     
-    float left_vol = audioProcessor->GetLeftVolume();
-    float right_vol = audioProcessor->GetRightVolume();
+    float left_vol = audioSnapshot.left_volume;
+    float right_vol = audioSnapshot.right_volume;
     
     // Use a scale that accommodates the max threshold range (up to 1.0)
     // This ensures threshold indicators stay within the progress bar range
@@ -378,16 +492,16 @@ void EarPerkApp::DrawStatusIndicators() {
     static const ImVec4 warning_color(1.0f, 0.0f, 0.0f, 1.0f);
 
     // Create a child window with fixed size
-    ImGui::BeginChild("StatusChild", ImVec2(TEXT_WIDTH, 100.0f), true,
+    ImGui::BeginChild("StatusChild", ImVec2(TEXT_WIDTH, 122.0f), true,
         ImGuiWindowFlags_NoMouseInputs | ImGuiWindowFlags_NoScrollbar);
 
     // Draw each status with proper spacing
     ImGui::Spacing();
 
-    bool audio_working = audioProcessor && audioProcessor->IsAudioWorking();
-    bool left_perked = audioProcessor && audioProcessor->IsLeftPerked();
-    bool right_perked = audioProcessor && audioProcessor->IsRightPerked();
-    bool overwhelmed = audioProcessor && audioProcessor->IsOverwhelmed();
+    bool audio_working = audioSnapshot.audio_working;
+    bool left_perked = audioSnapshot.left_perked;
+    bool right_perked = audioSnapshot.right_perked;
+    bool overwhelmed = audioSnapshot.overwhelmed;
 
     if (!audio_working) {
         ImGui::TextColored(warning_color, "Audio: Not Working");
@@ -403,14 +517,28 @@ void EarPerkApp::DrawStatusIndicators() {
     ImGui::Spacing();
 
     ImGui::TextColored(overwhelmed ? warning_color : inactive_color, "Overwhelmingly Loud");
+    ImGui::Spacing();
+
+    if (audioSnapshot.capture_gaps == 0) {
+        ImGui::TextColored(inactive_color, "Capture gaps: none");
+    } else {
+        auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        ImGui::TextColored(warning_color, "Capture gaps: %llu (%llu frames lost), last %lld s ago",
+            static_cast<unsigned long long>(audioSnapshot.capture_gaps),
+            static_cast<unsigned long long>(audioSnapshot.frames_lost),
+            static_cast<long long>((now_ms - audioSnapshot.last_gap_ms) / 1000));
+    }
 
     ImGui::EndChild();
     
     ImGui::Spacing();
     if (ImGui::Button("Reconnect Audio Device")) {
         if (audioProcessor && audioProcessor->RestartAudio()) {
-            statusMessage = "Audio device reconnected successfully!";
+            statusMessage = "Reconnecting audio device...";
             statusMessageTime = std::chrono::steady_clock::now();
+            deviceSwitchPending = true;
+            pendingDeviceId = audioProcessor->GetSelectedDeviceId();
         } else {
             statusMessage = "Failed to reconnect audio device!";
             statusMessageTime = std::chrono::steady_clock::now();
@@ -419,6 +547,13 @@ void EarPerkApp::DrawStatusIndicators() {
     if (ImGui::IsItemHovered()) {
         ImGui::SetTooltip("Manually restart audio processing and reconnect to the current default audio device.\nUse this if audio stops working after changing audio devices.");
     }
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Performance", &showPerfOverlay)) {
+        PerfMonitor::Get().SetEnabled(showPerfOverlay);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Show timing plots of the audio thread and the window,\nto tell whether EarPerkOSC or something else is causing lag");
+    }
     
     // Show status message if recent
     if (!statusMessage.empty()) {
@@ -446,7 +581,7 @@ void EarPerkApp::DrawAudioDeviceSelection() {
     }
     
     // Show warning if audio is not working (use a stable height to prevent UI jumping)
-    if (!audioProcessor->IsAudioWorking()) {
+    if (!audioSnapshot.audio_working) {
         ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.6f, 0.0f, 1.0f)); // Orange
         ImGui::Text("⚠ Audio initialization failed - select a different device below");
         ImGui::PopStyleColor();
@@ -456,14 +591,12 @@ void EarPerkApp::DrawAudioDeviceSelection() {
     }
     ImGui::Spacing();
     
-    // Get available devices (with caching to prevent UI flickering)
-    auto now = std::chrono::steady_clock::now();
-    auto timeSinceRefresh = std::chrono::duration_cast<std::chrono::seconds>(now - lastDeviceRefresh);
-    
-    // Refresh device list every 2 seconds or if cache is empty
-    if (cachedDevices.empty() || timeSinceRefresh.count() > 2) {
+    // The device list is enumerated in the background; only copy it when
+    // a new one is ready
+    uint32_t deviceListVersion = audioProcessor->GetDeviceListVersion();
+    if (deviceListVersion != cachedDeviceListVersion) {
         cachedDevices = audioProcessor->GetAvailableDevices();
-        lastDeviceRefresh = now;
+        cachedDeviceListVersion = deviceListVersion;
     }
     
     auto& devices = cachedDevices;
@@ -521,10 +654,11 @@ void EarPerkApp::DrawAudioDeviceSelection() {
             statusMessage = "Changing audio device...";
             statusMessageTime = std::chrono::steady_clock::now();
             
+            // The switch finishes in the background; TrackDeviceSwitch()
+            // reports the outcome and saves the selection
             if (audioProcessor->SetSelectedDevice(selectedId)) {
-                statusMessage = "Audio device changed successfully!";
-                statusMessageTime = std::chrono::steady_clock::now();
-                SaveConfiguration(); // Save the new device selection
+                deviceSwitchPending = true;
+                pendingDeviceId = selectedId;
             } else {
                 statusMessage = "Failed to change audio device! Try a different device.";
                 statusMessageTime = std::chrono::steady_clock::now();
@@ -543,10 +677,9 @@ void EarPerkApp::DrawAudioDeviceSelection() {
     
     ImGui::Spacing();
     if (ImGui::Button("Refresh Device List")) {
-        // Force immediate refresh of device cache
-        cachedDevices = audioProcessor->GetAvailableDevices();
-        lastDeviceRefresh = std::chrono::steady_clock::now();
-        statusMessage = "Device list refreshed!";
+        // Enumerated in the background; the list updates when it's done
+        audioProcessor->RefreshDevices();
+        statusMessage = "Refreshing device list...";
         statusMessageTime = std::chrono::steady_clock::now();
     }
     if (ImGui::IsItemHovered()) {
@@ -585,9 +718,9 @@ void EarPerkApp::DrawStatusText() {
     ImGui::Text("OSC Messages:");
 
     std::string status;
-    bool left_perked = audioProcessor->IsLeftPerked();
-    bool right_perked = audioProcessor->IsRightPerked();
-    bool overwhelmed = audioProcessor->IsOverwhelmed();
+    bool left_perked = audioSnapshot.left_perked;
+    bool right_perked = audioSnapshot.right_perked;
+    bool overwhelmed = audioSnapshot.overwhelmed;
 
     if (overwhelmed) {
         status += "O ";
@@ -603,6 +736,85 @@ void EarPerkApp::DrawStatusText() {
     ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "%s", status.c_str());
 }
 
+void EarPerkApp::DrawPerformanceOverlay() {
+    ImGui::SetNextWindowPos(ImVec2(WINDOW_WIDTH - 370.0f, 10.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.9f);
+    if (!ImGui::Begin("Performance", &showPerfOverlay, ImGuiWindowFlags_AlwaysAutoResize)) {
+        ImGui::End();
+        return;
+    }
+
+    const PerfMonitor& perf = PerfMonitor::Get();
+    ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Audio: peak per 50 ms");
+    PlotPerfRing("Audio loop", perf.loop_us, "us");
+    PlotPerfRing("Block processing", perf.block_us, "us");
+    PlotPerfRing("Capture queue", perf.queue_frames, "frames");
+    PlotPerfRing("OSC sent", perf.osc_per_s, "/s");
+
+    ImGui::Separator();
+    ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Window: every frame");
+    PlotPerfRing("UI frame", perf.frame_ms, "ms");
+    PlotPerfRing("Process CPU", perf.cpu_percent, "%");
+
+#ifdef EARPERK_PROFILE
+    ImGui::Separator();
+    if (ImGui::Button("Save trace")) {
+        SaveProfileTrace();
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Write the most recent timing zones of every thread to a .json file\nnext to config.ini, for ui.perfetto.dev or chrome://tracing");
+    }
+#endif
+    ImGui::End();
+
+    // Closed with the window's own button
+    if (!showPerfOverlay) {
+        PerfMonitor::Get().SetEnabled(false);
+    }
+}
+
+#ifdef EARPERK_PROFILE
+void EarPerkApp::SaveProfileTrace() {
+    std::time_t seconds = std::time(nullptr);
+    std::tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &seconds);
+#else
+    localtime_r(&seconds, &local);
+#endif
+    char name[64];
+    std::strftime(name, sizeof(name), "EarPerkOSC-%Y%m%d-%H%M%S.json", &local);
+
+    std::string path = Config::GetDefaultConfigPath();
+    size_t slash = path.find_last_of("/\\");
+    path = (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + name;
+
+    std::string error;
+    if (profiling::WriteChromeTrace(path, &error)) {
+        LOG_INFO_F("Saved profile trace to %s", path.c_str());
+        statusMessage = "Trace saved successfully to " + path;
+    } else {
+        LOG_ERROR_F("Failed to save profile trace: %s", error.c_str());
+        statusMessage = "Failed to save trace: " + error;
+    }
+    statusMessageTime = std::chrono::steady_clock::now();
+}
+#endif
+
+void EarPerkApp::PlotPerfRing(const char* label, const PerfRing& ring, const char* unit) {
+    size_t count = ring.Copy(perfPlotValues.data());
+    float latest = count > 0 ? perfPlotValues[count - 1] : 0.0f;
+    float peak = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        peak = std::max(peak, perfPlotValues[i]);
+    }
+
+    char overlay[64];
+    snprintf(overlay, sizeof(overlay), "%.1f %s (max %.1f)", latest, unit, peak);
+    ImGui::PlotLines(label, perfPlotValues.data(), static_cast<int>(count), 0, overlay,
+        0.0f, std::max(peak * 1.2f, 1.0f), ImVec2(220.0f, 40.0f));
+}
+
 
 void EarPerkApp::DrawConfigurationPanel() {
     if (ImGui::CollapsingHeader("Advanced Configuration")) {
@@ -736,15 +948,26 @@ void EarPerkApp::UpdateThresholds(float differential, float volume, float excess
     config.differential_threshold = differential;
     config.volume_threshold = volume;
     config.excessive_volume_threshold = excessive;
+    // Picked up by PublishDetectionParams() at the end of the frame
+}
 
-    // Update audio processor with new thresholds
-    if (audioProcessor) {
-        audioProcessor->UpdateThresholds(differential, volume, excessive);
+void EarPerkApp::PublishDetectionParams() {
+    DetectionParams params = config.GetDetectionParams();
+    // The mirrored auto thresholds change nearly every frame, and the
+    // audio thread keeps its own values for them anyway
+    if (!params.SameUserSettings(publishedParams)) {
+        audioProcessor->SetDetectionParams(params);
+        publishedParams = params;
     }
 }
 
 void EarPerkApp::SaveConfiguration() {
     LOG_DEBUG_F("Saving configuration with selected device ID: '%s'", config.selected_device_id.c_str());
+    if (configWriter) {
+        // Written in the background once changes stop for a moment
+        configWriter->Save(config.ToIniString());
+        return;
+    }
     bool saved = config.SaveToFile();
     if (saved) {
         LOG_DEBUG("Configuration saved successfully");
@@ -753,8 +976,60 @@ void EarPerkApp::SaveConfiguration() {
     }
 }
 
+void EarPerkApp::AdoptReloadedConfig() {
+    uint32_t version = configWatcher->Version();
+    if (version == adoptedConfigVersion) {
+        return;
+    }
+    adoptedConfigVersion = version;
+
+    auto latest = configWatcher->Latest();
+    if (!latest) {
+        return;
+    }
+
+    // The audio thread already has these; only the UI's copy is behind
+    config = *latest;
+    publishedParams = config.GetDetectionParams();
+    Logger::getInstance().SetLevel(config.log_level);
+    statusMessage = "Configuration reloaded from config.ini";
+    statusMessageTime = std::chrono::steady_clock::now();
+}
+
+void EarPerkApp::TrackDeviceSwitch() {
+    if (!deviceSwitchPending) {
+        return;
+    }
+
+    auto state = audioProcessor->GetDeviceSwitchState();
+    if (state == DeviceSwitcher::State::Warming || state == DeviceSwitcher::State::Ready) {
+        return;
+    }
+    deviceSwitchPending = false;
+
+    if (state != DeviceSwitcher::State::Failed && audioProcessor->GetSelectedDeviceId() == pendingDeviceId) {
+        statusMessage = "Audio device connected successfully!";
+        config.selected_device_id = pendingDeviceId;
+        SaveConfiguration(); // Save the new device selection
+    } else {
+        statusMessage = "Failed to change audio device! Try a different device.";
+    }
+    statusMessageTime = std::chrono::steady_clock::now();
+}
+
+void EarPerkApp::RequestRedraw(GLFWwindow* window) {
+    // ImGui needs a couple of frames to settle after input (hover state,
+    // widgets that react on release)
+    const int framesAfterInput = 3;
+    auto* app = static_cast<EarPerkApp*>(glfwGetWindowUserPointer(window));
+    if (app) {
+        app->pendingRedrawFrames = framesAfterInput;
+    }
+}
+
 void EarPerkApp::WindowFocusCallback(GLFWwindow* window, int focused) {
     auto* app = static_cast<EarPerkApp*>(glfwGetWindowUserPointer(window));
+    RequestRedraw(window);
     if (focused && app->wasMinimized) {
         // Reinitialize ImGui safely
         if (ImGui::GetCurrentContext()) {
@@ -777,6 +1052,7 @@ void EarPerkApp::WindowFocusCallback(GLFWwindow* window, int focused) {
 void EarPerkApp::WindowIconifyCallback(GLFWwindow* window, int iconified) {
     auto* app = static_cast<EarPerkApp*>(glfwGetWindowUserPointer(window));
     app->wasMinimized = iconified != 0;
+    RequestRedraw(window);
 }
 
 void EarPerkApp::SetWindowIcon() {
@@ -6,6 +6,7 @@
 #include <windows.h>
 #endif
 
+#include <array>
 #include <memory>
 #include <string>
 #include <chrono>
@@ -13,6 +14,10 @@
 #include <GLFW/glfw3.h>
 #include "audio_processor.hpp"
 #include "config.hpp"
+#include "config_watcher.hpp"
+#include "config_writer.hpp"
+#include "metrics_server.hpp"
+#include "perf_monitor.hpp"
 
 class EarPerkApp {
 public:
@@ -34,27 +39,65 @@ private:
     void DrawAudioDeviceSelection();
     void DrawConfigurationPanel();
     void UpdateThresholds(float differential, float volume, float excessive);
+    void PublishDetectionParams();
     void SaveConfiguration();
     void DrawStatusText();
+    void DrawPerformanceOverlay();
+    void PlotPerfRing(const char* label, const PerfRing& ring, const char* unit);
+#ifdef EARPERK_PROFILE
+    void SaveProfileTrace();
+#endif
+    void TrackDeviceSwitch();
+    void AdoptReloadedConfig();
     void SetWindowIcon();
 
     GLFWwindow* window;
     std::unique_ptr<AudioProcessor> audioProcessor;
     Config config;
 
+    // Audio state for the frame being drawn, and the detection settings
+    // last handed to the audio thread
+    AudioProcessor::Snapshot audioSnapshot;
+    DetectionParams publishedParams;
+
+    // Picks up edits to config.ini made while running
+    std::unique_ptr<ConfigWatcher> configWatcher;
+    uint32_t adoptedConfigVersion = 0;
+
+    // Saves config.ini in the background, coalescing bursts of changes
+    std::unique_ptr<ConfigWriter> configWriter;
+
+    // Optional Prometheus endpoint / OSC stats
+    std::unique_ptr<MetricsServer> metricsServer;
+
+    // Timing plots; the buffer is reused by every plot so drawing them
+    // doesn't allocate
+    bool showPerfOverlay = false;
+    std::array<float, PerfRing::kCapacity> perfPlotValues{};
+
     // Window settings
     const int WINDOW_WIDTH = 800;
     const int WINDOW_HEIGHT = 600;
     const char* WINDOW_TITLE = "EarPerk OSC";
     bool wasMinimized = false;
+
+    // Frame governor: redraw only when something changed, at most max_fps
+    double lastFrameTime = 0.0;
+    uint32_t drawnSnapshotVersion = 0;
+    int pendingRedrawFrames = 1;  // Frames still owed to recent input
     
     std::string statusMessage;
     std::chrono::steady_clock::time_point statusMessageTime;
+
+    // Device switch running in the background, saved to config once done
+    bool deviceSwitchPending = false;
+    std::string pendingDeviceId;
     
     // Cache for device enumeration to prevent UI flickering
     std::vector<AudioProcessor::AudioDevice> cachedDevices;
-    std::chrono::steady_clock::time_point lastDeviceRefresh;
+    uint32_t cachedDeviceListVersion = 0;  // Catalog version cachedDevices came from
 
+    static void RequestRedraw(GLFWwindow* window);
     static void WindowFocusCallback(GLFWwindow* window, int focused);
     static void WindowIconifyCallback(GLFWwindow* window, int iconified);
 };
\ No newline at end of file
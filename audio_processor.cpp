@@ -1,382 +1,203 @@
 #include "audio_processor.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
+#include "perf_monitor.hpp"
+#include "profile_zones.hpp"
+#include <algorithm>
 #include <functional>
 #include <iostream>
-#include <vector>
 #include <tuple>
+#include <vector>
+
+namespace {
+
+// Until the first block reports the device's actual rate
+const unsigned kDefaultSampleRate = 48000;
+
+float ExtraDeviceWeight(const Config& settings, const std::string& id) {
+    auto it = std::find(settings.extra_device_ids.begin(), settings.extra_device_ids.end(), id);
+    size_t index = static_cast<size_t>(it - settings.extra_device_ids.begin());
+    return index < settings.extra_device_weights.size() ? settings.extra_device_weights[index] : 1.0f;
+}
+
+} // namespace
 
 AudioProcessor::AudioProcessor(Config& config)
-    : pEnumerator(nullptr)
-    , pDevice(nullptr)
-    , pAudioClient(nullptr)
-    , pCaptureClient(nullptr)
-    , pwfx(nullptr)
-    , running(false)
+    : running(false)
     , needsReconnect(false)
     , config(config)
     , osc(config)
-    , left_perked(false)
-    , right_perked(false)
-    , overwhelmingly_loud(false)
+    , settings(std::make_shared<Config>(config))
+    , settingsPending(false)
+    , detector(config.GetDetectionParams(), kDefaultSampleRate)
+    , params_version(0)
     , current_left_vol(0.0f)
     , current_right_vol(0.0f)
+    , capture_gaps(0)
+    , frames_lost(0)
+    , last_gap_ms(-1)
+    , selectedDeviceId(config.selected_device_id)
     , currentDeviceId("")
     , currentDeviceName("No Device")
-    , currentDeviceIsRender(true)
 {
     LOG_DEBUG("AudioProcessor constructor called");
-    last_left_message_timestamp = std::chrono::steady_clock::now();
-    last_right_message_timestamp = std::chrono::steady_clock::now();
-    last_overwhelm_timestamp = std::chrono::steady_clock::now();
+    deviceWatcher = std::make_unique<MMDeviceWatcher>();
+    deviceSupervisor = std::make_unique<DeviceSupervisor>(*deviceWatcher, needsReconnect);
+    catalogWatcher = std::make_unique<MMDeviceWatcher>();
+    deviceCatalog = std::make_unique<DeviceCatalog>(*catalogWatcher, EnumerateMMDevices);
+    deviceCatalog->Start();
+    deviceSwitcher = std::make_unique<DeviceSwitcher>([this](const std::string& deviceId) {
+        WarmSource standby;
+        auto source = std::make_unique<WasapiCaptureSource>(deviceId, true);
+        if (source->Open()) {
+            auto current = Settings();
+            standby.pipeline = std::make_unique<SourcePipeline>(
+                source->SampleRate(), current->window_ms, current->hop_ms, current->GetLevelSettings(), 1.0f, nullptr);
+            standby.source = std::move(source);
+        }
+        return standby;
+    });
+    deviceSwitcher->Start();
+    if (!config.trace_file.empty()) {
+        traceRecorder = std::make_unique<TraceRecorder>(config.trace_file, config.window_ms, config.hop_ms);
+        if (!traceRecorder->Start()) {
+            traceRecorder.reset();
+        }
+    }
+    LoadRules(config.rules);
+    pending_params.Store(detector.Params());
+    params_version = pending_params.Version();
     LOG_DEBUG("AudioProcessor constructor completed");
 }
 
 AudioProcessor::~AudioProcessor() {
     LOG_DEBUG("AudioProcessor destructor called");
     Stop();
-    if (pCaptureClient) pCaptureClient->Release();
-    if (pAudioClient) pAudioClient->Release();
-    if (pDevice) pDevice->Release();
-    if (pEnumerator) pEnumerator->Release();
-    if (pwfx) CoTaskMemFree(pwfx);
+    deviceSwitcher->Stop();
+    deviceSupervisor->Stop();
+    deviceCatalog->Stop();
+    if (traceRecorder) {
+        traceRecorder->Stop();
+    }
+    CloseSources();
     LOG_DEBUG("AudioProcessor destructor completed");
 }
 
 bool AudioProcessor::Initialize() {
     LOG_INFO("Initializing AudioProcessor");
-    
-    LOG_DEBUG("Cleaning up existing audio interfaces");
-    if (pCaptureClient) pCaptureClient->Release();
-    if (pAudioClient) pAudioClient->Release();
-    if (pDevice) pDevice->Release();
-    if (pEnumerator) pEnumerator->Release();
-    if (pwfx) CoTaskMemFree(pwfx);
-    
-    // Reset pointers
-    pCaptureClient = nullptr;
-    pAudioClient = nullptr;
-    pDevice = nullptr;
-    pEnumerator = nullptr;
-    pwfx = nullptr;
-
-    const UINT32 REFTIMES_PER_SEC = 10000000;
-    const REFERENCE_TIME BUFFER_DURATION = REFTIMES_PER_SEC / 100; // 10ms buffer
-
-    LOG_DEBUG("Initializing COM");
-    HRESULT hr = CoInitializeEx(nullptr, COINIT_SPEED_OVER_MEMORY);
-    if (FAILED(hr) && hr != RPC_E_CHANGED_MODE) {
-        // RPC_E_CHANGED_MODE means COM is already initialized with a different threading model
-        // This is not a critical error, we can continue
-        LOG_ERROR_F("Failed to initialize COM: 0x%08X", hr);
-        return false;
-    }
-    LOG_DEBUG("COM initialized successfully");
 
-    LOG_DEBUG("Creating MMDeviceEnumerator");
-    hr = CoCreateInstance(
-        __uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
-        __uuidof(IMMDeviceEnumerator), (void**)&pEnumerator);
-    if (FAILED(hr)) {
-        LOG_ERROR_F("Failed to create MMDeviceEnumerator: 0x%08X", hr);
-        return false;
-    }
-    LOG_DEBUG("MMDeviceEnumerator created successfully");
+    LOG_DEBUG("Cleaning up existing audio sources");
+    CloseSources();
 
-    // Use selected device if specified, otherwise use default
-    if (!config.selected_device_id.empty()) {
-        LOG_DEBUG_F("Getting selected audio device: %s", config.selected_device_id.c_str());
-        
-        // Convert string to wide string for Windows API
-        int size_needed = MultiByteToWideChar(CP_UTF8, 0, config.selected_device_id.c_str(), -1, NULL, 0);
-        std::wstring wide_device_id(size_needed, 0);
-        MultiByteToWideChar(CP_UTF8, 0, config.selected_device_id.c_str(), -1, &wide_device_id[0], size_needed);
-        wide_device_id.resize(size_needed - 1);  // Remove null terminator
-        
-        hr = pEnumerator->GetDevice(wide_device_id.c_str(), &pDevice);
-        if (FAILED(hr)) {
-            LOG_WARN_F("Failed to get selected audio device (0x%08X), falling back to default", hr);
-            hr = pEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &pDevice);
-            if (FAILED(hr)) {
-                LOG_ERROR_F("Failed to get default audio endpoint: 0x%08X", hr);
-                return false;
-            }
-            LOG_DEBUG("Fallback to default audio endpoint successful");
-            currentDeviceIsRender = true;  // Default endpoint is always a render device
-        } else {
-            LOG_DEBUG("Selected audio device acquired successfully");
+    // Everything below is rebuilt from the settings anyway, so a pending
+    // reload only has to be adopted
+    if (auto next = TakePendingSettings()) {
+        if (next->selected_device_id != Settings()->selected_device_id) {
+            std::lock_guard<std::mutex> lock(deviceInfoMutex);
+            selectedDeviceId = next->selected_device_id;
         }
-    } else {
-        LOG_DEBUG("Getting default audio endpoint");
-        hr = pEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &pDevice);
-        if (FAILED(hr)) {
-            LOG_ERROR_F("Failed to get default audio endpoint: 0x%08X", hr);
-            return false;
+        if (next->rules != Settings()->rules) {
+            LoadRules(next->rules);
         }
-        LOG_DEBUG("Default audio endpoint acquired successfully");
-        currentDeviceIsRender = true;  // Default endpoint is always a render device
-    }
-    
-    // Store current device info for UI
-    LPWSTR deviceId = nullptr;
-    hr = pDevice->GetId(&deviceId);
-    if (SUCCEEDED(hr)) {
-        int id_size_needed = WideCharToMultiByte(CP_UTF8, 0, deviceId, -1, NULL, 0, NULL, NULL);
-        std::string deviceIdStr(id_size_needed, 0);
-        WideCharToMultiByte(CP_UTF8, 0, deviceId, -1, &deviceIdStr[0], id_size_needed, NULL, NULL);
-        currentDeviceId = deviceIdStr.c_str();  // Remove null terminator
-        
-        // Get device name
-        IPropertyStore* pPropertyStore = nullptr;
-        hr = pDevice->OpenPropertyStore(STGM_READ, &pPropertyStore);
-        if (SUCCEEDED(hr)) {
-            PROPVARIANT friendlyName;
-            PropVariantInit(&friendlyName);
-            hr = pPropertyStore->GetValue(PKEY_Device_FriendlyName, &friendlyName);
-            
-            if (SUCCEEDED(hr) && friendlyName.vt == VT_LPWSTR) {
-                int name_size_needed = WideCharToMultiByte(CP_UTF8, 0, friendlyName.pwszVal, -1, NULL, 0, NULL, NULL);
-                std::string temp(name_size_needed, 0);
-                WideCharToMultiByte(CP_UTF8, 0, friendlyName.pwszVal, -1, &temp[0], name_size_needed, NULL, NULL);
-                currentDeviceName = temp.c_str();  // Remove null terminator
-            }
-            
-            PropVariantClear(&friendlyName);
-            pPropertyStore->Release();
-        }
-        
-        if (currentDeviceName.empty()) {
-            currentDeviceName = "Unknown Device";
+        {
+            std::lock_guard<std::mutex> lock(settingsMutex);
+            settings = next;
         }
-        
-        CoTaskMemFree(deviceId);
-        LOG_DEBUG_F("Using audio device: %s", currentDeviceName.c_str());
+        detector.SetParams(next->GetDetectionParams());
+        osc.Reconfigure(*next);
     }
+    auto current = Settings();
 
-    LOG_DEBUG("Activating audio client");
-    hr = pDevice->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
-        nullptr, (void**)&pAudioClient);
-    if (FAILED(hr)) {
-        LOG_ERROR_F("Failed to activate audio client: 0x%08X", hr);
+    std::string selectedId = GetSelectedDeviceId();
+    auto primary = std::make_unique<WasapiCaptureSource>(selectedId, true);
+    if (!primary->Open()) {
         return false;
     }
-    LOG_DEBUG("Audio client activated successfully");
-
-    bool isRenderDevice = currentDeviceIsRender;
-    LOG_DEBUG_F("Using stored device type: isRenderDevice=%s", isRenderDevice ? "true" : "false");
 
-    LOG_DEBUG("Getting audio mix format");
-    hr = pAudioClient->GetMixFormat(&pwfx);
-    if (FAILED(hr)) {
-        LOG_ERROR_F("Failed to get mix format: 0x%08X", hr);
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(deviceInfoMutex);
+        currentDeviceId = primary->Id();
+        currentDeviceName = primary->Name();
     }
-    LOG_DEBUG_F("Audio format: %d channels, %d Hz, %d bits", pwfx->nChannels, pwfx->nSamplesPerSec, pwfx->wBitsPerSample);
 
-    DWORD streamFlags = 0;
-    
-    bool isVoiceMeeterDevice = (currentDeviceName.find("VoiceMeeter") != std::string::npos ||
-                                currentDeviceName.find("VAIO") != std::string::npos ||
-                                currentDeviceName.find("VB-Audio") != std::string::npos);
-    
-    if (isVoiceMeeterDevice) {
-        streamFlags = 0;
-        LOG_DEBUG("VoiceMeeter device detected - using direct capture (no loopback)");
-    } else {
-        streamFlags = isRenderDevice ? AUDCLNT_STREAMFLAGS_LOOPBACK : 0;
-    }
-    
-    LOG_DEBUG_F("Initializing audio client with flags: 0x%08X (isRenderDevice=%s, isVoiceMeeter=%s)", 
-                streamFlags, isRenderDevice ? "true" : "false", isVoiceMeeterDevice ? "true" : "false");
-    
-    hr = pAudioClient->Initialize(
-        AUDCLNT_SHAREMODE_SHARED,
-        streamFlags,
-        BUFFER_DURATION,
-        0,
-        pwfx,
-        nullptr);
-        
-    // Handle device in use error by trying with different buffer settings
-    if (hr == AUDCLNT_E_DEVICE_IN_USE) {
-        LOG_DEBUG("Device in use, trying with auto buffer duration");
-        hr = pAudioClient->Initialize(
-            AUDCLNT_SHAREMODE_SHARED,
-            streamFlags,
-            0,  // Let Windows choose buffer duration
-            0,
-            pwfx,
-            nullptr);
-            
-        if (SUCCEEDED(hr)) {
-            LOG_DEBUG("Successfully initialized with auto buffer duration");
-        }
+    // Tell the supervisor which device to watch; an explicitly selected
+    // device is kept even if the default changes
+    deviceSupervisor->SetCurrentDevice(primary->Id(), selectedId.empty());
+
+    pipelines.push_back(std::make_unique<SourcePipeline>(
+        primary->SampleRate(), current->window_ms, current->hop_ms, current->GetLevelSettings(), 1.0f,
+        [this] { OnPrimaryBlock(); }));
+    if (traceRecorder) {
+        traceRecorder->SetFraming(current->window_ms, current->hop_ms);
     }
-        
-    // If the mix format is not supported, try fallback formats
-    if (hr == AUDCLNT_E_UNSUPPORTED_FORMAT) {
-        LOG_DEBUG("Mix format not supported for loopback, trying fallback formats");
-        
-        // Free the original format
-        CoTaskMemFree(pwfx);
-        pwfx = nullptr;
-        
-        // Try common fallback formats that are usually supported
-        std::vector<std::tuple<DWORD, DWORD, WORD>> fallbackFormats = {
-            {44100, 2, 16},  // 44.1kHz, 2 channels, 16-bit
-            {48000, 2, 16},  // 48kHz, 2 channels, 16-bit  
-            {44100, 2, 24},  // 44.1kHz, 2 channels, 24-bit
-            {48000, 2, 24},  // 48kHz, 2 channels, 24-bit
-            {44100, 2, 32},  // 44.1kHz, 2 channels, 32-bit
-            {48000, 2, 32}   // 48kHz, 2 channels, 32-bit
-        };
-        
-        bool formatFound = false;
-        for (const auto& [sampleRate, channels, bitsPerSample] : fallbackFormats) {
-            // Create a new format structure
-            pwfx = (WAVEFORMATEX*)CoTaskMemAlloc(sizeof(WAVEFORMATEX));
-            if (!pwfx) {
-                LOG_ERROR("Failed to allocate memory for audio format");
-                return false;
-            }
-            
-            pwfx->wFormatTag = WAVE_FORMAT_PCM;
-            pwfx->nChannels = channels;
-            pwfx->nSamplesPerSec = sampleRate;
-            pwfx->wBitsPerSample = bitsPerSample;
-            pwfx->nBlockAlign = (channels * bitsPerSample) / 8;
-            pwfx->nAvgBytesPerSec = sampleRate * pwfx->nBlockAlign;
-            pwfx->cbSize = 0;
-            
-            LOG_DEBUG_F("Trying fallback format: %d channels, %d Hz, %d bits", 
-                       pwfx->nChannels, pwfx->nSamplesPerSec, pwfx->wBitsPerSample);
-            
-            // Check if this format is supported
-            WAVEFORMATEX* pClosestMatch = nullptr;
-            hr = pAudioClient->IsFormatSupported(
-                AUDCLNT_SHAREMODE_SHARED,
-                pwfx,
-                &pClosestMatch);
-                
-            if (hr == S_OK) {
-                // Format is supported exactly, try to initialize
-                hr = pAudioClient->Initialize(
-                    AUDCLNT_SHAREMODE_SHARED,
-                    streamFlags,
-                    BUFFER_DURATION,
-                    0,
-                    pwfx,
-                    nullptr);
-                    
-                // If device is in use, try with auto buffer duration
-                if (hr == AUDCLNT_E_DEVICE_IN_USE) {
-                    LOG_DEBUG("Device in use with fallback format, trying auto buffer duration");
-                    hr = pAudioClient->Initialize(
-                        AUDCLNT_SHAREMODE_SHARED,
-                        streamFlags,
-                        0,  // Let Windows choose buffer duration
-                        0,
-                        pwfx,
-                        nullptr);
-                }
-                    
-                if (SUCCEEDED(hr)) {
-                    LOG_DEBUG_F("Successfully initialized with fallback format: %d channels, %d Hz, %d bits", 
-                               pwfx->nChannels, pwfx->nSamplesPerSec, pwfx->wBitsPerSample);
-                    formatFound = true;
-                    break;
-                }
-            } else if (hr == S_FALSE && pClosestMatch) {
-                // Format is not supported exactly, but a close match was suggested
-                LOG_DEBUG_F("Trying closest match format: %d channels, %d Hz, %d bits", 
-                           pClosestMatch->nChannels, pClosestMatch->nSamplesPerSec, pClosestMatch->wBitsPerSample);
-                
-                // Free our format and use the suggested one
-                CoTaskMemFree(pwfx);
-                pwfx = pClosestMatch;
-                
-                hr = pAudioClient->Initialize(
-                    AUDCLNT_SHAREMODE_SHARED,
-                    streamFlags,
-                    BUFFER_DURATION,
-                    0,
-                    pwfx,
-                    nullptr);
-                    
-                // If device is in use, try with auto buffer duration
-                if (hr == AUDCLNT_E_DEVICE_IN_USE) {
-                    LOG_DEBUG("Device in use with closest match format, trying auto buffer duration");
-                    hr = pAudioClient->Initialize(
-                        AUDCLNT_SHAREMODE_SHARED,
-                        streamFlags,
-                        0,  // Let Windows choose buffer duration
-                        0,
-                        pwfx,
-                        nullptr);
-                }
-                    
-                if (SUCCEEDED(hr)) {
-                    LOG_DEBUG_F("Successfully initialized with closest match format: %d channels, %d Hz, %d bits", 
-                               pwfx->nChannels, pwfx->nSamplesPerSec, pwfx->wBitsPerSample);
-                    formatFound = true;
-                    break;
-                }
-            } else {
-                // Clean up the suggested format if any
-                if (pClosestMatch) {
-                    CoTaskMemFree(pClosestMatch);
-                }
-            }
-            
-            // This format didn't work, free it and try the next one
-            CoTaskMemFree(pwfx);
-            pwfx = nullptr;
-        }
-        
-        if (!formatFound) {
-            LOG_ERROR("No supported audio format found for loopback capture");
-            return false;
+    sources.push_back(std::move(primary));
+
+    // Extra devices are optional; a missing one is retried when the
+    // supervisor sees it come back
+    for (const std::string& id : current->extra_device_ids) {
+        if (id == sources.front()->Id()) {
+            LOG_DEBUG_F("Extra audio device %s is already the selected device, skipping", id.c_str());
+            continue;
         }
-    } else if (FAILED(hr)) {
-        if (hr == AUDCLNT_E_DEVICE_IN_USE) {
-            LOG_ERROR("Audio device is in use by another application. Please check:");
-            LOG_ERROR("1. Close other audio applications that might be using exclusive mode");
-            LOG_ERROR("2. Disable exclusive mode in Sound settings > Device Properties > Advanced");
-            LOG_ERROR("3. Disable audio enhancement software (e.g., Nahimic, Sonic Studio)");
-        } else {
-            LOG_ERROR_F("Failed to initialize audio client: 0x%08X", hr);
+
+        auto source = std::make_unique<WasapiCaptureSource>(id, false);
+        if (!source->Open()) {
+            LOG_WARN_F("Extra audio device %s is unavailable, continuing without it", id.c_str());
+            continue;
         }
-        return false;
-    }
-    LOG_DEBUG("Audio client initialized successfully");
 
-    LOG_DEBUG("Getting audio capture client service");
-    hr = pAudioClient->GetService(
-        __uuidof(IAudioCaptureClient),
-        (void**)&pCaptureClient);
-    if (FAILED(hr)) {
-        LOG_ERROR_F("Failed to get audio capture client: 0x%08X", hr);
-        return false;
+        float weight = ExtraDeviceWeight(*current, id);
+        LOG_INFO_F("Also capturing from %s (weight %.2f)", source->Name().c_str(), weight);
+        pipelines.push_back(std::make_unique<SourcePipeline>(
+            source->SampleRate(), current->window_ms, current->hop_ms, current->GetLevelSettings(), weight, nullptr));
+        sources.push_back(std::move(source));
     }
-    LOG_DEBUG("Audio capture client acquired successfully");
+    deviceSupervisor->SetExtraDevices(current->extra_device_ids);
 
     LOG_INFO("AudioProcessor initialization completed successfully");
     return true;
 }
 
+void AudioProcessor::CloseSources() {
+    pipelines.clear();
+    sources.clear();
+}
+
+bool AudioProcessor::StartSources() {
+    if (sources.empty()) {
+        return false;
+    }
+    if (!sources.front()->Start()) {
+        return false;
+    }
+    for (size_t i = 1; i < sources.size(); i++) {
+        if (!sources[i]->Start()) {
+            LOG_WARN_F("Failed to start extra audio device %s", sources[i]->Name().c_str());
+        }
+    }
+    return true;
+}
+
 void AudioProcessor::Start() {
     if (!running) {
         LOG_INFO("Starting audio processor");
         running = true;
         
-        HRESULT hr = pAudioClient->Start();
-        if (FAILED(hr)) {
-            LOG_ERROR_F("Failed to start audio client: 0x%08X", hr);
+        if (!StartSources()) {
+            LOG_ERROR("Failed to start audio capture");
             running = false;
             return;
         }
-        LOG_DEBUG("Audio client started successfully");
+        LOG_DEBUG("Audio capture started successfully");
         
+        // Device changes are pushed to the supervisor, which only raises
+        // needsReconnect for the capture loop
+        deviceSupervisor->Start();
+
         LOG_DEBUG("Starting audio processing thread");
+        auto current = Settings();
+        scheduling.realtime = current->realtime_priority;
+        scheduling.cpu_core = current->cpu_core;
         audioThread = std::thread(&AudioProcessor::ProcessAudio, this);
         LOG_INFO("Audio processor started successfully");
     }
@@ -388,14 +209,19 @@ void AudioProcessor::Stop() {
         if (audioThread.joinable()) {
             audioThread.join();
         }
-        if (pAudioClient) {
-            pAudioClient->Stop();
+        for (auto& source : sources) {
+            source->Stop();
         }
     }
 }
 
 bool AudioProcessor::RestartAudio() {
     std::cout << "Manual audio restart requested..." << std::endl;
+
+    if (running) {
+        deviceSwitcher->Request(GetSelectedDeviceId());
+        return true;
+    }
     
     // Stop current processing
     Stop();
@@ -416,177 +242,150 @@ bool AudioProcessor::RestartAudio() {
     return true;
 }
 
-bool AudioProcessor::CheckDeviceStatus() {
-    if (!pDevice || !pEnumerator) return false;
-    
-    // Check if current device is still active
-    DWORD state;
-    HRESULT hr = pDevice->GetState(&state);
-    if (FAILED(hr) || state != DEVICE_STATE_ACTIVE) {
-        LOG_DEBUG("Current audio device is no longer active");
-        return false;
-    }
-    
-    // If we have a specific selected device, only check if it's still active
-    // Don't check if it's still the default - we want to stick with the selected device
-    if (!config.selected_device_id.empty()) {
-        LOG_DEBUG("Using selected device - skipping default device check");
-        return true;
-    }
-    
-    // Only check for default device changes if we're using the default device
-    IMMDevice* pCurrentDefault = nullptr;
-    hr = pEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &pCurrentDefault);
-    if (SUCCEEDED(hr) && pCurrentDefault) {
-        LPWSTR currentDeviceId = nullptr;
-        LPWSTR defaultDeviceId = nullptr;
-        
-        hr = pDevice->GetId(&currentDeviceId);
-        HRESULT hr2 = pCurrentDefault->GetId(&defaultDeviceId);
-        
-        bool isStillDefault = true;
-        if (SUCCEEDED(hr) && SUCCEEDED(hr2)) {
-            isStillDefault = (wcscmp(currentDeviceId, defaultDeviceId) == 0);
-        }
-        
-        if (currentDeviceId) CoTaskMemFree(currentDeviceId);
-        if (defaultDeviceId) CoTaskMemFree(defaultDeviceId);
-        pCurrentDefault->Release();
-        
-        if (!isStillDefault) {
-            LOG_DEBUG("Default audio device changed, marking for reconnection");
-            return false;
-        }
-    }
-    
-    return true;
-}
-
 bool AudioProcessor::TryReconnectDevice() {
-    // Release current interfaces
-    if (pCaptureClient) {
-        pCaptureClient->Release();
-        pCaptureClient = nullptr;
-    }
-    if (pAudioClient) {
-        pAudioClient->Stop();
-        pAudioClient->Release();
-        pAudioClient = nullptr;
-    }
-    if (pDevice) {
-        pDevice->Release();
-        pDevice = nullptr;
-    }
-    if (pEnumerator) {
-        pEnumerator->Release();
-        pEnumerator = nullptr;
-    }
-    if (pwfx) {
-        CoTaskMemFree(pwfx);
-        pwfx = nullptr;
-    }
-
-    // Try to reinitialize
+    // Initialize() releases the current sources before opening new ones
     if (!Initialize()) {
         return false;
     }
 
     // Restart audio capture
-    HRESULT hr = pAudioClient->Start();
-    return SUCCEEDED(hr);
+    return StartSources();
 }
 
 void AudioProcessor::ProcessAudio() {
+    ScopedThreadScheduling thread_scheduling(scheduling);
+    PROFILE_THREAD("Audio capture");
+    PipelineMetrics& metrics = PipelineMetrics::Get();
+    PerfMonitor& perf = PerfMonitor::Get();
+    const auto jitter_report_interval = std::chrono::seconds(10);
+    auto last_jitter_report = std::chrono::steady_clock::now();
+
+    // One loop serves every source. Sources signal an event when data is
+    // ready; the timeout keeps idle loopback streams and any source
+    // without an event moving.
+    const DWORD event_timeout_ms = 10;
+    const DWORD poll_interval_ms = 1;
+    std::vector<HANDLE> wait_handles;
+    DWORD wait_timeout_ms = poll_interval_ms;
+    bool sources_changed = true;
+
     while (running) {
         // Check if we need to reconnect
         if (needsReconnect.load()) {
-            std::cout << "Audio device reconnection needed..." << std::endl;
+            LOG_INFO("Audio device reconnection needed");
+            // Clear first so a device change during the reconnect isn't lost
+            needsReconnect.store(false);
+            metrics.reconnects.Add();
             if (TryReconnectDevice()) {
-                std::cout << "Audio device reconnected successfully." << std::endl;
-                needsReconnect.store(false);
+                LOG_INFO("Audio device reconnected successfully");
+                sources_changed = true;
             } else {
-                std::cout << "Audio device reconnection failed, retrying in 1 second..." << std::endl;
+                LOG_WARN("Audio device reconnection failed, retrying in 1 second");
+                needsReconnect.store(true);
+                PublishSnapshot(false);
                 std::this_thread::sleep_for(std::chrono::seconds(1));
                 continue;
             }
         }
 
-        // Check device status and mark for reconnection if needed
-        if (!CheckDeviceStatus()) {
-            std::cout << "Audio device disconnected, marking for reconnection..." << std::endl;
-            needsReconnect.store(true);
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
+        // A device switch finished warming up in the background
+        WarmSource standby;
+        std::string standbyId;
+        if (deviceSwitcher->TakeReady(&standby, &standbyId)) {
+            SwapInStandby(std::move(standby), standbyId);
+            sources_changed = true;
         }
 
-        Sleep(1);
-        UINT32 packetLength = 0;
-        HRESULT hr = pCaptureClient->GetNextPacketSize(&packetLength);
-        
-        // Check for device disconnection errors
-        if (FAILED(hr)) {
-            if (hr == AUDCLNT_E_DEVICE_INVALIDATED || hr == AUDCLNT_E_RESOURCES_INVALIDATED) {
-                std::cout << "Audio device invalidated, marking for reconnection..." << std::endl;
-                needsReconnect.store(true);
-                continue;
-            } else {
-                std::cout << "Unexpected error in GetNextPacketSize: " << std::hex << hr << std::endl;
-                break;
+        if (sources_changed) {
+            wait_handles.clear();
+            bool polled = false;
+            for (const auto& source : sources) {
+                if (HANDLE handle = source->WaitHandle()) {
+                    wait_handles.push_back(handle);
+                } else {
+                    polled = true;
+                }
             }
+            wait_timeout_ms = (polled || wait_handles.empty()) ? poll_interval_ms : event_timeout_ms;
+            sources_changed = false;
         }
 
-        while (packetLength > 0) {
-            BYTE* data;
-            UINT32 numFramesAvailable;
-            DWORD flags;
-
-            hr = pCaptureClient->GetBuffer(
-                &data,
-                &numFramesAvailable,
-                &flags,
-                nullptr,
-                nullptr);
-            
-            if (FAILED(hr)) {
-                if (hr == AUDCLNT_E_DEVICE_INVALIDATED || hr == AUDCLNT_E_RESOURCES_INVALIDATED) {
-                    std::cout << "Audio device invalidated during GetBuffer, marking for reconnection..." << std::endl;
-                    needsReconnect.store(true);
-                    break;
-                } else {
-                    std::cout << "Unexpected error in GetBuffer: " << std::hex << hr << std::endl;
+        ApplyPendingParams();
+        ApplyPendingSettings();
+
+        auto wait_start = std::chrono::steady_clock::now();
+        DWORD wait_result = WAIT_TIMEOUT;
+        if (wait_handles.empty()) {
+            Sleep(wait_timeout_ms);
+        } else {
+            wait_result = WaitForMultipleObjects(static_cast<DWORD>(wait_handles.size()),
+                                                 wait_handles.data(), FALSE, wait_timeout_ms);
+        }
+        auto wake_time = std::chrono::steady_clock::now();
+        PROFILE_ZONE("Capture loop");
+
+        // Timed-out waits are late against the timeout; event wake-ups are
+        // measured once the sources say when their packets were ready
+        if (wait_result == WAIT_TIMEOUT) {
+            timeout_jitter.Record(std::chrono::milliseconds(wait_timeout_ms), wake_time - wait_start);
+        }
+        if (wake_time - last_jitter_report >= jitter_report_interval) {
+            const char* mode = ScopedThreadScheduling::ModeName(thread_scheduling.GetMode());
+            auto data = data_latency.TakeStats();
+            LOG_INFO_F("Capture wake-up latency after data (%s): mean %.0f us, p99 < %.0f us, max %.0f us over %llu wakeups",
+                mode, data.mean_us, data.p99_us, data.max_us, static_cast<unsigned long long>(data.wakeups));
+            auto idle = timeout_jitter.TakeStats();
+            LOG_INFO_F("Capture wake-up lateness on timeout (%s): mean %.0f us, p99 < %.0f us, max %.0f us over %llu wakeups",
+                mode, idle.mean_us, idle.p99_us, idle.max_us, static_cast<unsigned long long>(idle.wakeups));
+            last_jitter_report = wake_time;
+        }
+
+        // Drain every source, whichever one woke us; each feeds its own
+        // pipeline and the primary's blocks trigger the merged decision.
+        // The extra sources go first, so that decision sees their levels
+        // from this wake-up rather than the previous one.
+        bool failed = false;
+        for (size_t n = 0; n < sources.size(); n++) {
+            size_t i = (n + 1) % sources.size();
+            CaptureSource::ReadStatus status = sources[i]->Read(*pipelines[i]);
+            if (status == CaptureSource::ReadStatus::Invalidated) {
+                needsReconnect.store(true);
+            } else if (status == CaptureSource::ReadStatus::Failed) {
+                if (i == 0) {
+                    failed = true;
                     break;
                 }
+                // Don't let an extra device stop the main one
+                needsReconnect.store(true);
             }
 
-            if (!(flags & AUDCLNT_BUFFERFLAGS_SILENT)) {
-                size_t bytesPerFrame = pwfx->nBlockAlign;
-                for (UINT32 i = 0; i < numFramesAvailable * bytesPerFrame; i++) {
-                    sample_queue.push_back(data[i]);
-                }
+            SourcePipeline::GapCount gaps = pipelines[i]->TakeGaps();
+            if (gaps.gaps > 0) {
+                capture_gaps += gaps.gaps;
+                frames_lost += gaps.frames_lost;
+                last_gap_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count();
+                LOG_DEBUG_F("Capture gap on %s: %llu frames lost",
+                    sources[i]->Name().c_str(), static_cast<unsigned long long>(gaps.frames_lost));
             }
+        }
+        if (failed) {
+            break;
+        }
 
-            hr = pCaptureClient->ReleaseBuffer(numFramesAvailable);
-            if (FAILED(hr)) {
-                if (hr == AUDCLNT_E_DEVICE_INVALIDATED || hr == AUDCLNT_E_RESOURCES_INVALIDATED) {
-                    std::cout << "Audio device invalidated during ReleaseBuffer, marking for reconnection..." << std::endl;
-                    needsReconnect.store(true);
-                    break;
-                } else {
-                    std::cout << "Unexpected error in ReleaseBuffer: " << std::hex << hr << std::endl;
-                    break;
+        // From the earliest packet any source got, to this wake-up
+        if (wait_result - WAIT_OBJECT_0 < wait_handles.size()) {
+            bool have_ready = false;
+            std::chrono::steady_clock::time_point earliest;
+            for (const auto& source : sources) {
+                std::chrono::steady_clock::time_point ready;
+                if (source->LastPacketReady(&ready) && (!have_ready || ready < earliest)) {
+                    earliest = ready;
+                    have_ready = true;
                 }
             }
-
-            hr = pCaptureClient->GetNextPacketSize(&packetLength);
-            if (FAILED(hr)) {
-                if (hr == AUDCLNT_E_DEVICE_INVALIDATED || hr == AUDCLNT_E_RESOURCES_INVALIDATED) {
-                    std::cout << "Audio device invalidated during packet size check, marking for reconnection..." << std::endl;
-                    needsReconnect.store(true);
-                    break;
-                } else {
-                    std::cout << "Unexpected error in GetNextPacketSize loop: " << std::hex << hr << std::endl;
-                    break;
-                }
+            if (have_ready) {
+                data_latency.Record(std::chrono::steady_clock::duration::zero(), wake_time - earliest);
             }
         }
         
@@ -595,269 +394,312 @@ void AudioProcessor::ProcessAudio() {
             continue;
         }
 
-        auto [left_avg, right_avg] = CalculateAvgLR();
-
-        // std::cout << "UI auto_volume_threshold: " << config.auto_volume_threshold << std::endl;
-        // std::cout << "ProcessAudio auto_volume_threshold: " << config.auto_volume_threshold << std::endl;
-
-        // Only process volume analysis at reduced rate
-        static int processCounter = 0;
-        if (++processCounter % 10 == 0) {  // Process every 10th iteration
-            if (volume_analyzer.ShouldUpdate()) {
-                volume_analyzer.AddSample(left_avg, right_avg);
-                volume_analyzer.UpdateTimestamp();
-
-                if (config.auto_volume_threshold || config.auto_excessive_threshold) {
-                    auto [vol_threshold, excess_threshold] = 
-                        volume_analyzer.GetSuggestedThresholds(
-                            config.volume_threshold_multiplier,
-                            config.excessive_threshold_multiplier);
-
-                    if (config.auto_volume_threshold) {
-                        config.volume_threshold = vol_threshold;
-                    }
-                    if (config.auto_excessive_threshold) {
-                        config.excessive_volume_threshold = excess_threshold;
-                    }
-                }
-            }
-        }
-
-        ProcessVolOverwhelm(left_avg, right_avg);
-        if (!overwhelmingly_loud) {
-            ProcessVolPerkAndReset(left_avg, right_avg);
+        // Same order: an idle primary's silent block also makes a decision
+        for (size_t n = 0; n < pipelines.size(); n++) {
+            pipelines[(n + 1) % pipelines.size()]->FeedIdle(wake_time);
         }
+        auto work_end = std::chrono::steady_clock::now();
+        metrics.loop_time.Observe(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(work_end - wake_time).count()));
+        perf.ObserveLoop(work_end - wake_time, work_end);
     }
+
+    PublishSnapshot(false);
 }
 
-std::vector<AudioProcessor::AudioDevice> AudioProcessor::GetAvailableDevices() {
-    std::vector<AudioDevice> devices;
-    
-    IMMDeviceEnumerator* pTempEnumerator = nullptr;
-    IMMDeviceCollection* pCollection = nullptr;
-    
-    HRESULT hr = CoCreateInstance(
-        __uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
-        __uuidof(IMMDeviceEnumerator), (void**)&pTempEnumerator);
-    
-    if (FAILED(hr)) {
-        LOG_ERROR_F("Failed to create device enumerator for listing: 0x%08X", hr);
-        return devices;
+void AudioProcessor::SwapInStandby(WarmSource standby, const std::string& deviceId) {
+    standby.pipeline->SetBlockCallback([this] { OnPrimaryBlock(); });
+
+    WarmSource old;
+    if (sources.empty()) {
+        sources.push_back(std::move(standby.source));
+        pipelines.push_back(std::move(standby.pipeline));
+    } else {
+        old.source = std::move(sources.front());
+        old.pipeline = std::move(pipelines.front());
+        sources.front() = std::move(standby.source);
+        pipelines.front() = std::move(standby.pipeline);
     }
-    
-    // Get default device to mark it
-    IMMDevice* pDefaultDevice = nullptr;
-    LPWSTR defaultDeviceId = nullptr;
-    hr = pTempEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &pDefaultDevice);
-    if (SUCCEEDED(hr)) {
-        pDefaultDevice->GetId(&defaultDeviceId);
+
+    {
+        std::lock_guard<std::mutex> lock(deviceInfoMutex);
+        selectedDeviceId = deviceId;
+        currentDeviceId = sources.front()->Id();
+        currentDeviceName = sources.front()->Name();
     }
-    
-    // Enumerate both render and capture devices for comprehensive device list
-    EDataFlow dataFlows[] = { eRender, eCapture };
-    const char* flowNames[] = { "Render", "Capture" };
-    
-    for (int flowIndex = 0; flowIndex < 2; flowIndex++) {
-        EDataFlow dataFlow = dataFlows[flowIndex];
-        
-        hr = pTempEnumerator->EnumAudioEndpoints(dataFlow, DEVICE_STATE_ACTIVE, &pCollection);
-        if (SUCCEEDED(hr)) {
-            UINT deviceCount = 0;
-            hr = pCollection->GetCount(&deviceCount);
-            
-            if (SUCCEEDED(hr)) {
-                for (UINT i = 0; i < deviceCount; i++) {
-                IMMDevice* pDevice = nullptr;
-                hr = pCollection->Item(i, &pDevice);
-                
-                if (SUCCEEDED(hr)) {
-                    LPWSTR deviceId = nullptr;
-                    hr = pDevice->GetId(&deviceId);
-                    
-                    if (SUCCEEDED(hr)) {
-                        // Get device friendly name
-                        IPropertyStore* pPropertyStore = nullptr;
-                        hr = pDevice->OpenPropertyStore(STGM_READ, &pPropertyStore);
-                        
-                        std::string deviceName = "Unknown Device";
-                        if (SUCCEEDED(hr)) {
-                            PROPVARIANT friendlyName;
-                            PropVariantInit(&friendlyName);
-                            hr = pPropertyStore->GetValue(PKEY_Device_FriendlyName, &friendlyName);
-                            
-                            if (SUCCEEDED(hr) && friendlyName.vt == VT_LPWSTR) {
-                                // Convert wide string to regular string
-                                int size_needed = WideCharToMultiByte(CP_UTF8, 0, friendlyName.pwszVal, -1, NULL, 0, NULL, NULL);
-                                std::string temp(size_needed, 0);
-                                WideCharToMultiByte(CP_UTF8, 0, friendlyName.pwszVal, -1, &temp[0], size_needed, NULL, NULL);
-                                deviceName = temp.c_str();  // Remove null terminator
-                            }
-                            
-                            PropVariantClear(&friendlyName);
-                            pPropertyStore->Release();
-                        }
-                        
-                        // Convert device ID to string
-                        int id_size_needed = WideCharToMultiByte(CP_UTF8, 0, deviceId, -1, NULL, 0, NULL, NULL);
-                        std::string deviceIdStr(id_size_needed, 0);
-                        WideCharToMultiByte(CP_UTF8, 0, deviceId, -1, &deviceIdStr[0], id_size_needed, NULL, NULL);
-                        deviceIdStr = deviceIdStr.c_str();  // Remove null terminator
-                        
-                        bool isDefault = false;
-                        if (defaultDeviceId) {
-                            isDefault = (wcscmp(deviceId, defaultDeviceId) == 0);
-                        }
-                        
-                        // Add helpful identification for VoiceMeeter devices and device type
-                        std::string deviceTypeLabel = (dataFlow == eRender) ? " (Output)" : " (Input)";
-                        
-                        if (deviceName.find("VoiceMeeter") != std::string::npos || 
-                            deviceName.find("VAIO") != std::string::npos ||
-                            deviceName.find("VB-Audio") != std::string::npos) {
-                            deviceName += " [VoiceMeeter Virtual Device]";
-                        }
-                        
-                        deviceName += deviceTypeLabel;
-                        
-                        bool isRenderDevice = (dataFlow == eRender);
-                        devices.push_back({deviceIdStr, deviceName, isDefault, isRenderDevice});
-                        
-                        CoTaskMemFree(deviceId);
-                    }
-                    
-                    pDevice->Release();
-                }
-            }
-        }
-        
-        pCollection->Release();
-        pCollection = nullptr;
+    deviceSupervisor->SetCurrentDevice(sources.front()->Id(), deviceId.empty());
+    LOG_INFO_F("Switched audio capture to %s", sources.front()->Name().c_str());
+
+    // Stopping and releasing the old device happens off this thread
+    if (old.source) {
+        deviceSwitcher->Retire(std::move(old));
     }
-    } // End dataFlow loop
-    
-    if (defaultDeviceId) CoTaskMemFree(defaultDeviceId);
-    if (pDefaultDevice) pDefaultDevice->Release();
-    pTempEnumerator->Release();
-    
-    return devices;
 }
 
-bool AudioProcessor::SetSelectedDevice(const std::string& deviceId) {
-    LOG_DEBUG_F("Setting selected device ID to: '%s'", deviceId.c_str());
-    
-    // Find the device in our available devices list to get its type
-    auto devices = GetAvailableDevices();
-    for (const auto& device : devices) {
-        if (device.id == deviceId) {
-            currentDeviceIsRender = device.isRenderDevice;
-            LOG_DEBUG_F("Device type: isRenderDevice=%s", currentDeviceIsRender ? "true" : "false");
-            break;
+void AudioProcessor::OnPrimaryBlock() {
+    auto start = std::chrono::steady_clock::now();
+    PipelineMetrics::Get().blocks_analyzed.Add();
+    auto [left_avg, right_avg] = MergeLevels();
+    const SourcePipeline& primary = *pipelines.front();
+    detector.SetSampleRate(primary.SampleRate());
+    rules.SetSampleRate(primary.SampleRate());
+    ProcessLevels(left_avg, right_avg, static_cast<uint32_t>(primary.HopFrames()));
+    PerfMonitor::Get().ObserveBlock(std::chrono::steady_clock::now() - start);
+}
+
+std::pair<float, float> AudioProcessor::MergeLevels() const {
+    float left = 0.0f;
+    float right = 0.0f;
+    for (const auto& pipeline : pipelines) {
+        float source_left = pipeline->LeftLevel() * pipeline->Weight();
+        float source_right = pipeline->RightLevel() * pipeline->Weight();
+        if (detector.Params().merge_mode == MergeMode::WeightedSum) {
+            left += source_left;
+            right += source_right;
+        } else {
+            left = std::max(left, source_left);
+            right = std::max(right, source_right);
         }
     }
-    
-    config.selected_device_id = deviceId;
-    
-    // Restart audio with new device
-    return RestartAudio();
+    return { left, right };
 }
 
-std::string AudioProcessor::GetCurrentDeviceId() const {
-    return currentDeviceId;
-}
+void AudioProcessor::ProcessLevels(float left_avg, float right_avg, uint32_t frames) {
+    current_left_vol = left_avg;
+    current_right_vol = right_avg;
 
-std::string AudioProcessor::GetCurrentDeviceName() const {
-    return currentDeviceName;
+    uint8_t decisions = detector.Process(left_avg, right_avg, frames);
+    SendDecisions(decisions);
+    EvaluateRules(frames);
+
+    if (traceRecorder) {
+        const DetectionParams& params = detector.Params();
+        TraceRecorder::BlockFeatures features;
+        features.left_level = current_left_vol;
+        features.right_level = current_right_vol;
+        std::tie(features.analyzer_mean, features.analyzer_stddev) = detector.AnalyzerStats();
+        features.volume_threshold = params.volume_threshold;
+        features.excessive_threshold = params.excessive_volume_threshold;
+        features.decisions = decisions;
+        features.state = detector.State();
+        traceRecorder->RecordBlock(frames, pipelines.front()->SampleRate(), features);
+    }
+
+    PublishSnapshot(true);
 }
 
-std::pair<float, float> AudioProcessor::CalculateAvgLR() {
-    float left_volume = 0.0f;
-    float right_volume = 0.0f;
-    size_t count = 0;
+void AudioProcessor::SendDecisions(uint8_t decisions) {
+    // In the order the detector makes them
+    if (decisions & OverwhelmOn) {
+        osc.SendOverwhelm(true);
+    } else if (decisions & OverwhelmOff) {
+        osc.SendOverwhelm(false);
+    }
+    if (decisions & LeftPerk) {
+        osc.SendLeftEar(true);
+    }
+    if (decisions & RightPerk) {
+        osc.SendRightEar(true);
+    }
+    if (decisions & Suppressed) {
+        PipelineMetrics::Get().osc_suppressed.Add();
+    }
+    if (decisions & LeftReset) {
+        osc.SendLeftEar(false);
+    }
+    if (decisions & RightReset) {
+        osc.SendRightEar(false);
+    }
+}
 
-    while (sample_queue.size() >= pwfx->nChannels * sizeof(float)) {
-        std::array<uint8_t, sizeof(float)> left_bytes;
-        std::array<uint8_t, sizeof(float)> right_bytes;
+void AudioProcessor::EvaluateRules(uint32_t frames) {
+    if (rules.Size() == 0) {
+        return;
+    }
+
+    const DetectionParams& params = detector.Params();
+    float inputs[kRuleInputCount];
+    inputs[InputLeft] = current_left_vol;
+    inputs[InputRight] = current_right_vol;
+    inputs[InputVolumeThreshold] = params.volume_threshold;
+    inputs[InputExcessiveThreshold] = params.excessive_volume_threshold;
+    inputs[InputDifferentialThreshold] = params.differential_threshold;
+    inputs[InputLeftPerked] = detector.LeftEarPerked() ? 1.0f : 0.0f;
+    inputs[InputRightPerked] = detector.RightEarPerked() ? 1.0f : 0.0f;
+    inputs[InputOverwhelmed] = detector.IsOverwhelmed() ? 1.0f : 0.0f;
+    rules.Process(inputs, frames, [this](size_t index, bool value) {
+        osc.SendRule(index, value);
+    });
+}
 
-        for (size_t i = 0; i < sizeof(float); i++) {
-            left_bytes[i] = sample_queue.front();
-            sample_queue.pop_front();
-        }
-        for (size_t i = 0; i < sizeof(float); i++) {
-            right_bytes[i] = sample_queue.front();
-            sample_queue.pop_front();
+void AudioProcessor::LoadRules(const std::vector<std::string>& texts) {
+    // Parameters left on by the old rules would otherwise stay on
+    for (size_t i = 0; i < rules.Size(); i++) {
+        if (rules.IsOn(i)) {
+            osc.SendRule(i, false);
         }
+    }
 
-        float left = *reinterpret_cast<float*>(left_bytes.data());
-        float right = *reinterpret_cast<float*>(right_bytes.data());
+    std::vector<std::string> errors;
+    rules = RuleSet::Compile(texts, &errors);
+    for (const std::string& error : errors) {
+        LOG_WARN_F("Ignoring [rules] %s", error.c_str());
+    }
 
-        left_volume += std::abs(left);
-        right_volume += std::abs(right);
-        count++;
+    std::vector<std::string> addresses;
+    for (size_t i = 0; i < rules.Size(); i++) {
+        addresses.push_back(rules.Address(i));
     }
+    osc.SetRuleAddresses(addresses);
+    if (!texts.empty()) {
+        LOG_INFO_F("Loaded %zu of %zu rules", rules.Size(), texts.size());
+    }
+}
 
-    if (count > 0) {
-        current_left_vol = left_volume / count;
-        current_right_vol = right_volume / count;
+void AudioProcessor::ApplyPendingParams() {
+    if (pending_params.Version() == params_version) {
+        return;
     }
 
-    return { current_left_vol, current_right_vol };
+    detector.SetParams(pending_params.Load(&params_version));
 }
 
-void AudioProcessor::ProcessVolPerkAndReset(float left_avg, float right_avg) {
-    auto current_time = std::chrono::steady_clock::now();
-    auto timeout = std::chrono::milliseconds(config.timeout_ms);
-    auto reset_timeout = std::chrono::milliseconds(config.reset_timeout_ms);
-
-    if (left_avg > config.differential_threshold
-        && right_avg > config.differential_threshold
-        && left_avg > config.volume_threshold
-        && right_avg > config.volume_threshold) {
-        if (current_time - last_left_message_timestamp > timeout &&
-            current_time - last_right_message_timestamp > timeout) {
-            osc.SendLeftEar(true);
-            osc.SendRightEar(true);
-            last_left_message_timestamp = current_time;
-            last_right_message_timestamp = current_time;
-            left_perked = right_perked = true;
-        }
+void AudioProcessor::ReloadSettings(std::shared_ptr<const Config> next) {
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        pendingSettings = std::move(next);
     }
-    else if ((left_avg - right_avg > config.differential_threshold) && left_avg > config.volume_threshold) {
-        if (current_time - last_left_message_timestamp > timeout) {
-            osc.SendLeftEar(true);
-            last_left_message_timestamp = current_time;
-            left_perked = true;
-        }
+    settingsPending.store(true, std::memory_order_release);
+}
+
+std::shared_ptr<const Config> AudioProcessor::Settings() const {
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    return settings;
+}
+
+std::shared_ptr<const Config> AudioProcessor::TakePendingSettings() {
+    if (!settingsPending.load(std::memory_order_acquire)) {
+        return nullptr;
     }
-    else if ((right_avg - left_avg > config.differential_threshold) && right_avg > config.volume_threshold) {
-        if (current_time - last_right_message_timestamp > timeout) {
-            osc.SendRightEar(true);
-            last_right_message_timestamp = current_time;
-            right_perked = true;
-        }
+    std::lock_guard<std::mutex> lock(settingsMutex);
+    settingsPending.store(false);
+    return std::move(pendingSettings);
+}
+
+void AudioProcessor::ApplyPendingSettings() {
+    std::shared_ptr<const Config> next = TakePendingSettings();
+    if (!next) {
+        return;
     }
 
-    // Reset logic
-    if (left_perked && current_time - last_left_message_timestamp > reset_timeout) {
-        osc.SendLeftEar(false);
-        left_perked = false;
+    std::shared_ptr<const Config> previous;
+    {
+        std::lock_guard<std::mutex> lock(settingsMutex);
+        previous = settings;
+        settings = next;
     }
-    if (right_perked && current_time - last_right_message_timestamp > reset_timeout) {
-        osc.SendRightEar(false);
-        right_perked = false;
+
+    detector.SetParams(next->GetDetectionParams());
+    osc.Reconfigure(*next);
+    if (next->rules != previous->rules) {
+        LoadRules(next->rules);
+    }
+
+    if (next->selected_device_id != previous->selected_device_id) {
+        LOG_INFO("Selected device changed in the config file, switching");
+        deviceSwitcher->Request(next->selected_device_id);
+    }
+
+    if (next->extra_device_ids != previous->extra_device_ids) {
+        // Initialize() opens the new set from the settings
+        LOG_INFO("Extra devices changed in the config file, reopening audio devices");
+        needsReconnect.store(true);
+    } else if (next->window_ms != previous->window_ms || next->hop_ms != previous->hop_ms ||
+               next->GetLevelSettings() != previous->GetLevelSettings() ||
+               next->extra_device_weights != previous->extra_device_weights) {
+        RebuildPipelines(*next);
+    }
+
+    if (next->realtime_priority != previous->realtime_priority || next->cpu_core != previous->cpu_core) {
+        LOG_INFO("Capture thread scheduling changes take effect the next time capture starts");
     }
 }
 
-void AudioProcessor::ProcessVolOverwhelm(float left_avg, float right_avg) {
-    auto current_time = std::chrono::steady_clock::now();
-    auto reset_timeout = std::chrono::milliseconds(config.reset_timeout_ms);
+void AudioProcessor::RebuildPipelines(const Config& next) {
+    // Same devices, new framing: only the partial block in each framer is lost
+    for (size_t i = 0; i < sources.size(); i++) {
+        float weight = i == 0 ? 1.0f : ExtraDeviceWeight(next, sources[i]->Id());
+        SourcePipeline::BlockCallback on_block = nullptr;
+        if (i == 0) {
+            on_block = [this] { OnPrimaryBlock(); };
+        }
+        pipelines[i] = std::make_unique<SourcePipeline>(
+            sources[i]->SampleRate(), next.window_ms, next.hop_ms, next.GetLevelSettings(), weight, std::move(on_block));
+    }
+    if (traceRecorder) {
+        traceRecorder->SetFraming(next.window_ms, next.hop_ms);
+    }
+    LOG_INFO_F("Analysis blocks are now %d ms every %d ms", next.window_ms, next.hop_ms);
+}
 
-    if (left_avg > config.excessive_volume_threshold || right_avg > config.excessive_volume_threshold) {
-        osc.SendOverwhelm(true);
-        last_overwhelm_timestamp = current_time;
-        overwhelmingly_loud = true;
+void AudioProcessor::PublishSnapshot(bool audio_working) {
+    Snapshot state;
+    state.left_volume = current_left_vol;
+    state.right_volume = current_right_vol;
+    state.volume_threshold = detector.Params().volume_threshold;
+    state.excessive_volume_threshold = detector.Params().excessive_volume_threshold;
+    state.left_perked = detector.LeftEarPerked();
+    state.right_perked = detector.RightEarPerked();
+    state.overwhelmed = detector.IsOverwhelmed();
+    state.audio_working = audio_working;
+    state.capture_gaps = capture_gaps;
+    state.frames_lost = frames_lost;
+    state.last_gap_ms = last_gap_ms;
+    if (state == last_published) {
+        return;
+    }
+    last_published = state;
+    snapshot.Store(state);
+}
+
+bool AudioProcessor::SetSelectedDevice(const std::string& deviceId) {
+    LOG_DEBUG_F("Setting selected device ID to: '%s'", deviceId.c_str());
+
+    AudioDevice device;
+    if (deviceId.empty()) {
+        LOG_INFO("Switching to the default audio device");
+    } else if (deviceCatalog->Lookup(deviceId, &device)) {
+        LOG_INFO_F("Switching to %s, %u Hz, %u channels", device.name.c_str(), device.sampleRate, device.channels);
+    } else {
+        // The list may just not have caught up; opening decides
+        LOG_WARN_F("Selected device %s is not in the device list", deviceId.c_str());
     }
-    else if (overwhelmingly_loud && current_time - last_overwhelm_timestamp > reset_timeout) {
-        osc.SendOverwhelm(false);
-        overwhelmingly_loud = false;
+    
+    if (running) {
+        deviceSwitcher->Request(deviceId);
+        return true;
     }
+
+    {
+        std::lock_guard<std::mutex> lock(deviceInfoMutex);
+        selectedDeviceId = deviceId;
+    }
+    
+    // Restart audio with new device
+    return RestartAudio();
+}
+
+std::string AudioProcessor::GetSelectedDeviceId() const {
+    std::lock_guard<std::mutex> lock(deviceInfoMutex);
+    return selectedDeviceId;
+}
+
+std::string AudioProcessor::GetCurrentDeviceId() const {
+    std::lock_guard<std::mutex> lock(deviceInfoMutex);
+    return currentDeviceId;
+}
+
+std::string AudioProcessor::GetCurrentDeviceName() const {
+    std::lock_guard<std::mutex> lock(deviceInfoMutex);
+    return currentDeviceName;
 }
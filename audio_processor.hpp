@@ -6,13 +6,23 @@
 #include <propvarutil.h>
 #include <thread>
 #include <atomic>
-#include <deque>
 #include <chrono>
 #include <vector>
 #include <string>
+#include <memory>
+#include <mutex>
+#include "capture_source.hpp"
 #include "config.hpp"
+#include "detector.hpp"
+#include "device_catalog.hpp"
+#include "device_switcher.hpp"
+#include "device_watcher.hpp"
 #include "osc_sender.hpp"
-#include "volume_analyzer.hpp"
+#include "rule_engine.hpp"
+#include "seqlock.hpp"
+#include "source_pipeline.hpp"
+#include "thread_scheduling.hpp"
+#include "trace_recorder.hpp"
 
 class AudioProcessor {
 public:
@@ -27,73 +37,139 @@ public:
     void Start();
     void Stop();
     
-    // Force a complete audio system restart (for UI button)
+    // Reopen the selected device (for UI button). While capturing this
+    // happens in the background like SetSelectedDevice.
     bool RestartAudio();
 
-    // Device enumeration for UI
-    struct AudioDevice {
-        std::string id;
-        std::string name;
-        bool isDefault;
-        bool isRenderDevice;  // true for render/output devices, false for capture/input devices
-    };
-    std::vector<AudioDevice> GetAvailableDevices();
+    // Device list for the UI, served from the background catalog. Never
+    // blocks on enumeration; the list is empty until the first one ends.
+    using AudioDevice = AudioDeviceInfo;
+    std::vector<AudioDevice> GetAvailableDevices() const { return deviceCatalog->GetDevices(); }
+    uint32_t GetDeviceListVersion() const { return deviceCatalog->Version(); }
+    void RefreshDevices() { deviceCatalog->Invalidate(); }
+
+    // While capturing, the new device is brought up in the background and
+    // swapped in once it delivers audio; returns true once that's under
+    // way, and GetDeviceSwitchState() tells how it went. When not
+    // capturing, switches synchronously.
     bool SetSelectedDevice(const std::string& deviceId);
+    DeviceSwitcher::State GetDeviceSwitchState() const { return deviceSwitcher->GetState(); }
+    std::string GetSelectedDeviceId() const;  // Empty for the default device
     std::string GetCurrentDeviceId() const;
     std::string GetCurrentDeviceName() const;
 
-    // Getters for UI
-    float GetLeftVolume() const { return current_left_vol; }
-    float GetRightVolume() const { return current_right_vol; }
-    bool IsLeftPerked() const { return left_perked; }
-    bool IsRightPerked() const { return right_perked; }
-    bool IsOverwhelmed() const { return overwhelmingly_loud; }
-    bool IsAudioWorking() const { return pAudioClient != nullptr && pCaptureClient != nullptr; }
+    // Processor state as of the last block, published by the audio thread
+    struct Snapshot {
+        float left_volume = 0.0f;
+        float right_volume = 0.0f;
+        float volume_threshold = 0.0f;            // Thresholds in effect, including auto adjustment
+        float excessive_volume_threshold = 0.0f;
+        bool left_perked = false;
+        bool right_perked = false;
+        bool overwhelmed = false;
+        bool audio_working = false;
+        uint64_t capture_gaps = 0;                // Lost audio found since the processor started
+        uint64_t frames_lost = 0;
+        int64_t last_gap_ms = -1;                 // steady_clock milliseconds, -1 if none yet
+
+        bool operator==(const Snapshot& other) const {
+            return left_volume == other.left_volume
+                && right_volume == other.right_volume
+                && volume_threshold == other.volume_threshold
+                && excessive_volume_threshold == other.excessive_volume_threshold
+                && left_perked == other.left_perked
+                && right_perked == other.right_perked
+                && overwhelmed == other.overwhelmed
+                && audio_working == other.audio_working
+                && capture_gaps == other.capture_gaps
+                && frames_lost == other.frames_lost
+                && last_gap_ms == other.last_gap_ms;
+        }
+    };
+
+    // Lock-free; safe to call from the UI thread at any time
+    Snapshot GetSnapshot() const { return snapshot.Load(); }
+
+    // Changes only when the snapshot contents change
+    uint32_t GetSnapshotVersion() const { return snapshot.Version(); }
 
-    void UpdateThresholds(float differential, float volume, float excessive) {
-        config.differential_threshold = differential;
-        config.volume_threshold = volume;
-        config.excessive_volume_threshold = excessive;
-    }
+    // Hand new detection settings to the audio thread, which picks them up
+    // at the start of its next block. Call from one thread only (the UI).
+    void SetDetectionParams(const DetectionParams& params) { pending_params.Store(params); }
+
+    // Settings reloaded from config.ini; safe from any thread. The audio
+    // thread applies them between blocks. Only what changed is touched:
+    // the OSC target is swapped in place, a new window or hop rebuilds the
+    // pipelines, and the devices are reopened only if they changed.
+    void ReloadSettings(std::shared_ptr<const Config> next);
 
 private:
     void ProcessAudio();
-    std::pair<float, float> CalculateAvgLR();
-    void ProcessVolPerkAndReset(float left_avg, float right_avg);
-    void ProcessVolOverwhelm(float left_avg, float right_avg);
-    bool CheckDeviceStatus();
+    void CloseSources();
+    bool StartSources();
+    void OnPrimaryBlock();
+    std::pair<float, float> MergeLevels() const;
+    void ProcessLevels(float left_avg, float right_avg, uint32_t frames);
+    void SendDecisions(uint8_t decisions);
+    void EvaluateRules(uint32_t frames);
+    void LoadRules(const std::vector<std::string>& texts);
     bool TryReconnectDevice();
+    void SwapInStandby(WarmSource standby, const std::string& deviceId);
+    void ApplyPendingParams();
+    std::shared_ptr<const Config> Settings() const;
+    std::shared_ptr<const Config> TakePendingSettings();
+    void ApplyPendingSettings();
+    void RebuildPipelines(const Config& next);
+    void PublishSnapshot(bool audio_working);
 
-    // WASAPI interfaces
-    IMMDeviceEnumerator* pEnumerator;
-    IMMDevice* pDevice;
-    IAudioClient* pAudioClient;
-    IAudioCaptureClient* pCaptureClient;
-    WAVEFORMATEX* pwfx;
+    // Capture sources and their feature pipelines, index for index. The
+    // first is the selected device and drives the decisions; the others
+    // come from extra_device_ids and are merged in.
+    std::vector<std::unique_ptr<CaptureSource>> sources;
+    std::vector<std::unique_ptr<SourcePipeline>> pipelines;
 
     // Audio processing
-    std::deque<uint8_t> sample_queue;
     std::atomic<bool> running;
-    std::atomic<bool> needsReconnect;
+    std::atomic<bool> needsReconnect;  // Set by the device supervisor or on capture errors
     std::thread audioThread;
-    VolumeAnalyzer volume_analyzer;
+    ThreadScheduling scheduling;  // Taken from config when the thread starts
+    WakeupJitter timeout_jitter;  // Wake-ups from the wait timing out, against the timeout
+    WakeupJitter data_latency;    // Wake-ups from a source event, against its packet being ready
+    std::unique_ptr<DeviceWatcher> deviceWatcher;
+    std::unique_ptr<DeviceSupervisor> deviceSupervisor;
+    std::unique_ptr<DeviceWatcher> catalogWatcher;
+    std::unique_ptr<DeviceCatalog> deviceCatalog;
+    std::unique_ptr<DeviceSwitcher> deviceSwitcher;
+    std::unique_ptr<TraceRecorder> traceRecorder;  // Only when trace_file is set
 
-    // Configuration
+    // Configuration. config belongs to the UI; the audio side reads its
+    // own immutable copy, replaced as a whole when the file is reloaded.
     Config& config;
     OSCSender osc;
+    mutable std::mutex settingsMutex;
+    std::shared_ptr<const Config> settings;
+    std::shared_ptr<const Config> pendingSettings;
+    std::atomic<bool> settingsPending;
+
+    // Cross-thread handover in both directions. The audio thread works on
+    // its own copy of the parameters and only the snapshot leaves it.
+    SeqLock<DetectionParams> pending_params;
+    SeqLock<Snapshot> snapshot;
+    Snapshot last_published;  // Unchanged state isn't republished
 
-    // State variables
-    bool left_perked;
-    bool right_perked;
-    bool overwhelmingly_loud;
-    std::chrono::steady_clock::time_point last_left_message_timestamp;
-    std::chrono::steady_clock::time_point last_right_message_timestamp;
-    std::chrono::steady_clock::time_point last_overwhelm_timestamp;
+    // State variables, owned by the audio thread
+    EarDetector detector;
+    RuleSet rules;  // Compiled from config rules, sent alongside the ears
+    uint32_t params_version;
     float current_left_vol;
     float current_right_vol;
+    uint64_t capture_gaps;
+    uint64_t frames_lost;
+    int64_t last_gap_ms;
     
-    // Device selection
+    // Device selection, written on reconnect and read by the UI
+    mutable std::mutex deviceInfoMutex;
+    std::string selectedDeviceId;  // What to open; config is only updated once a switch worked
     std::string currentDeviceId;
     std::string currentDeviceName;
-    bool currentDeviceIsRender;
 };
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "block_framer.hpp"
+#include <cstring>
+
+namespace {
+
+template <typename Read>
+void Deinterleave(const SampleFormat& format, const uint8_t* data, size_t frames,
+                  unsigned bytes_per_sample, float* left, float* right, Read read) {
+    // Mono goes to both sides
+    const unsigned right_offset = format.channels > 1 ? bytes_per_sample : 0;
+    for (size_t i = 0; i < frames; i++) {
+        const uint8_t* frame = data + i * format.bytes_per_frame;
+        left[i] = read(frame);
+        right[i] = read(frame + right_offset);
+    }
+}
+
+} // namespace
+
+bool DecodeStereo(const SampleFormat& format, const uint8_t* data, size_t frames,
+                  float* left, float* right) {
+    if (format.channels == 0) {
+        return false;
+    }
+
+    switch (format.encoding) {
+        case SampleFormat::Encoding::Float32:
+            Deinterleave(format, data, frames, 4, left, right, [](const uint8_t* p) {
+                float value;
+                std::memcpy(&value, p, sizeof(value));
+                return value;
+            });
+            return true;
+        case SampleFormat::Encoding::Int16:
+            Deinterleave(format, data, frames, 2, left, right, [](const uint8_t* p) {
+                int16_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return value / 32768.0f;
+            });
+            return true;
+        case SampleFormat::Encoding::Int24:
+            Deinterleave(format, data, frames, 3, left, right, [](const uint8_t* p) {
+                // Little endian; shift into the top of an int32 to sign extend
+                int32_t value = static_cast<int32_t>(
+                    (static_cast<uint32_t>(p[0]) << 8) |
+                    (static_cast<uint32_t>(p[1]) << 16) |
+                    (static_cast<uint32_t>(p[2]) << 24));
+                return value / 2147483648.0f;
+            });
+            return true;
+        case SampleFormat::Encoding::Int32:
+            Deinterleave(format, data, frames, 4, left, right, [](const uint8_t* p) {
+                int32_t value;
+                std::memcpy(&value, p, sizeof(value));
+                return value / 2147483648.0f;
+            });
+            return true;
+        case SampleFormat::Encoding::Unsupported:
+            break;
+    }
+    return false;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Layout of the interleaved samples delivered by the capture device
+struct SampleFormat {
+    enum class Encoding {
+        Float32,
+        Int16,
+        Int24,  // Packed, 3 bytes per sample
+        Int32,  // Also 24-bit samples in a 32-bit container
+        Unsupported
+    };
+
+    Encoding encoding = Encoding::Unsupported;
+    unsigned channels = 0;
+    unsigned bytes_per_frame = 0;
+    unsigned sample_rate = 0;
+};
+
+// Convert interleaved frames to separate left/right float channels in
+// [-1, 1]. Mono is copied to both sides; channels beyond the first two
+// are ignored. Returns false for unsupported formats.
+bool DecodeStereo(const SampleFormat& format, const uint8_t* data, size_t frames,
+                  float* left, float* right);
+
+// Cuts a continuous stereo stream into fixed analysis blocks of `window`
+// frames, one every `hop` frames, independent of how the device packets
+// happen to be sized. hop < window gives overlapping blocks.
+class BlockFramer {
+public:
+    BlockFramer(size_t window = 480, size_t hop = 480) {
+        Configure(window, hop);
+    }
+
+    // Change block geometry; drops any partially filled block
+    void Configure(size_t window_frames, size_t hop_frames) {
+        window = std::max<size_t>(window_frames, 1);
+        hop = std::min(std::max<size_t>(hop_frames, 1), window);
+        left.assign(window, 0.0f);
+        right.assign(window, 0.0f);
+        filled = 0;
+    }
+
+    void Reset() { filled = 0; }
+
+    size_t Window() const { return window; }
+    size_t Hop() const { return hop; }
+
+    // Append frames, calling on_block(left, right, window) for every block
+    // completed along the way
+    template <typename Callback>
+    void Push(const float* in_left, const float* in_right, size_t frames, Callback&& on_block) {
+        while (frames > 0) {
+            size_t take = std::min(frames, window - filled);
+            std::copy(in_left, in_left + take, left.begin() + filled);
+            std::copy(in_right, in_right + take, right.begin() + filled);
+            in_left += take;
+            in_right += take;
+            frames -= take;
+            filled += take;
+
+            if (filled == window) {
+                EmitBlock(on_block);
+            }
+        }
+    }
+
+    // Append silence, e.g. while a loopback stream delivers no packets
+    template <typename Callback>
+    void PushSilence(size_t frames, Callback&& on_block) {
+        while (frames > 0) {
+            size_t take = std::min(frames, window - filled);
+            std::fill(left.begin() + filled, left.begin() + filled + take, 0.0f);
+            std::fill(right.begin() + filled, right.begin() + filled + take, 0.0f);
+            frames -= take;
+            filled += take;
+
+            if (filled == window) {
+                EmitBlock(on_block);
+            }
+        }
+    }
+
+private:
+    template <typename Callback>
+    void EmitBlock(Callback& on_block) {
+        on_block(left.data(), right.data(), window);
+        // Keep the overlap for the next block
+        std::copy(left.begin() + hop, left.end(), left.begin());
+        std::copy(right.begin() + hop, right.end(), right.begin());
+        filled = window - hop;
+    }
+
+    size_t window;
+    size_t hop;
+    std::vector<float> left;
+    std::vector<float> right;
+    size_t filled;
+};
@@ -0,0 +1,608 @@
+#include "capture_source.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "profile_zones.hpp"
+#include "string_utils.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+void ReportGap(const GapTracker::Gap& gap, PacketSink& sink) {
+    PipelineMetrics& metrics = PipelineMetrics::Get();
+    metrics.capture_gaps.Add();
+    metrics.frames_lost.Add(gap.frames_lost);
+    sink.OnGap(gap.frames_lost);
+}
+
+} // namespace
+
+GapTracker::Gap GapTracker::OnPacket(uint64_t device_position, uint32_t frames, bool discontinuity) {
+    Gap gap;
+    // Devices flag the first packet after starting, which isn't a loss
+    if (has_position) {
+        if (device_position > expected_position) {
+            gap.detected = true;
+            gap.frames_lost = device_position - expected_position;
+        } else if (discontinuity) {
+            gap.detected = true;
+        }
+    }
+    has_position = true;
+    expected_position = device_position + frames;
+    return gap;
+}
+
+FakeCaptureSource::FakeCaptureSource(const std::string& id, unsigned sample_rate, size_t packet_frames)
+    : id(id)
+    , sample_rate(sample_rate)
+    , packet_frames(packet_frames)
+    , started(false)
+    , packets_delivered(0)
+    , device_position(0)
+    , pending_gap(0)
+    , left(packet_frames)
+    , right(packet_frames)
+{
+}
+
+bool FakeCaptureSource::Start() {
+    started = true;
+    start_time = std::chrono::steady_clock::now();
+    packets_delivered = 0;
+    gaps.Reset();
+    return true;
+}
+
+CaptureSource::ReadStatus FakeCaptureSource::Read(PacketSink& sink) {
+    if (!started) return ReadStatus::Failed;
+
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+    uint64_t frames_due = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()) * sample_rate / 1000000;
+    const float kTwoPi = 6.2831853f;
+
+    while ((packets_delivered + 1) * packet_frames <= frames_due) {
+        device_position += pending_gap.exchange(0);
+
+        // 440 Hz on the left, 660 Hz on the right, so the two sides differ
+        for (size_t i = 0; i < packet_frames; i++) {
+            float t = static_cast<float>(device_position + i) / sample_rate;
+            left[i] = 0.25f * std::sin(kTwoPi * 440.0f * t);
+            right[i] = 0.25f * std::sin(kTwoPi * 660.0f * t);
+        }
+
+        PipelineMetrics::Get().frames_captured.Add(packet_frames);
+        GapTracker::Gap gap = gaps.OnPacket(device_position, static_cast<uint32_t>(packet_frames), false);
+        if (gap.detected) {
+            ReportGap(gap, sink);
+        }
+        sink.OnFrames(left.data(), right.data(), packet_frames);
+
+        device_position += packet_frames;
+        packets_delivered++;
+    }
+    return ReadStatus::Ok;
+}
+
+#ifdef _WIN32
+#include <functiondiscoverykeys_devpkey.h>
+#include <propvarutil.h>
+#include <mmreg.h>
+#include <ksmedia.h>
+#include <tuple>
+
+namespace {
+
+const UINT32 REFTIMES_PER_SEC = 10000000;
+const REFERENCE_TIME BUFFER_DURATION = REFTIMES_PER_SEC / 100; // 10ms buffer
+
+bool IsInvalidated(HRESULT hr) {
+    return hr == AUDCLNT_E_DEVICE_INVALIDATED || hr == AUDCLNT_E_RESOURCES_INVALIDATED;
+}
+
+} // namespace
+
+WasapiCaptureSource::WasapiCaptureSource(const std::string& device_id, bool fallback_to_default)
+    : requested_id(device_id)
+    , fallback_to_default(fallback_to_default)
+    , name("No Device")
+    , pEnumerator(nullptr)
+    , pDevice(nullptr)
+    , pAudioClient(nullptr)
+    , pCaptureClient(nullptr)
+    , pwfx(nullptr)
+    , event(nullptr)
+    , has_packet_ready(false)
+{
+    QueryPerformanceFrequency(&qpc_frequency);
+}
+
+WasapiCaptureSource::~WasapiCaptureSource() {
+    Close();
+}
+
+bool WasapiCaptureSource::Open() {
+    Close();
+
+    LOG_DEBUG("Initializing COM");
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_SPEED_OVER_MEMORY);
+    if (FAILED(hr) && hr != RPC_E_CHANGED_MODE) {
+        // RPC_E_CHANGED_MODE means COM is already initialized with a different threading model
+        // This is not a critical error, we can continue
+        LOG_ERROR_F("Failed to initialize COM: 0x%08X", hr);
+        return false;
+    }
+    LOG_DEBUG("COM initialized successfully");
+
+    LOG_DEBUG("Creating MMDeviceEnumerator");
+    hr = CoCreateInstance(
+        __uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+        __uuidof(IMMDeviceEnumerator), (void**)&pEnumerator);
+    if (FAILED(hr)) {
+        LOG_ERROR_F("Failed to create MMDeviceEnumerator: 0x%08X", hr);
+        pEnumerator = nullptr;
+        return false;
+    }
+    LOG_DEBUG("MMDeviceEnumerator created successfully");
+
+    if (!AcquireDevice()) {
+        return false;
+    }
+
+    // Loopback-capture outputs, capture inputs directly
+    bool isRenderDevice = true;
+    IMMEndpoint* pEndpoint = nullptr;
+    if (SUCCEEDED(pDevice->QueryInterface(__uuidof(IMMEndpoint), (void**)&pEndpoint))) {
+        EDataFlow flow = eRender;
+        if (SUCCEEDED(pEndpoint->GetDataFlow(&flow))) {
+            isRenderDevice = (flow == eRender);
+        }
+        pEndpoint->Release();
+    }
+    LOG_DEBUG_F("Device type: isRenderDevice=%s", isRenderDevice ? "true" : "false");
+
+    LOG_DEBUG("Activating audio client");
+    hr = pDevice->Activate(__uuidof(IAudioClient), CLSCTX_ALL,
+        nullptr, (void**)&pAudioClient);
+    if (FAILED(hr)) {
+        LOG_ERROR_F("Failed to activate audio client: 0x%08X", hr);
+        pAudioClient = nullptr;
+        return false;
+    }
+    LOG_DEBUG("Audio client activated successfully");
+
+    LOG_DEBUG("Getting audio mix format");
+    hr = pAudioClient->GetMixFormat(&pwfx);
+    if (FAILED(hr)) {
+        LOG_ERROR_F("Failed to get mix format: 0x%08X", hr);
+        pwfx = nullptr;
+        return false;
+    }
+    LOG_DEBUG_F("Audio format: %d channels, %d Hz, %d bits", pwfx->nChannels, pwfx->nSamplesPerSec, pwfx->wBitsPerSample);
+
+    DWORD streamFlags = AUDCLNT_STREAMFLAGS_EVENTCALLBACK;
+
+    bool isVoiceMeeterDevice = (name.find("VoiceMeeter") != std::string::npos ||
+                                name.find("VAIO") != std::string::npos ||
+                                name.find("VB-Audio") != std::string::npos);
+
+    if (isVoiceMeeterDevice) {
+        LOG_DEBUG("VoiceMeeter device detected - using direct capture (no loopback)");
+    } else if (isRenderDevice) {
+        streamFlags |= AUDCLNT_STREAMFLAGS_LOOPBACK;
+    }
+
+    LOG_DEBUG_F("Initializing audio client with flags: 0x%08X (isRenderDevice=%s, isVoiceMeeter=%s)",
+                streamFlags, isRenderDevice ? "true" : "false", isVoiceMeeterDevice ? "true" : "false");
+
+    hr = InitializeClient(streamFlags);
+
+    // If the mix format is not supported, try fallback formats
+    if (hr == AUDCLNT_E_UNSUPPORTED_FORMAT) {
+        if (!InitializeWithFallbackFormats(streamFlags)) {
+            LOG_ERROR("No supported audio format found for loopback capture");
+            return false;
+        }
+    } else if (FAILED(hr)) {
+        if (hr == AUDCLNT_E_DEVICE_IN_USE) {
+            LOG_ERROR("Audio device is in use by another application. Please check:");
+            LOG_ERROR("1. Close other audio applications that might be using exclusive mode");
+            LOG_ERROR("2. Disable exclusive mode in Sound settings > Device Properties > Advanced");
+            LOG_ERROR("3. Disable audio enhancement software (e.g., Nahimic, Sonic Studio)");
+        } else {
+            LOG_ERROR_F("Failed to initialize audio client: 0x%08X", hr);
+        }
+        return false;
+    }
+    LOG_DEBUG("Audio client initialized successfully");
+
+    // Signalled by the audio engine whenever a buffer is ready
+    event = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!event) {
+        LOG_ERROR_F("Failed to create capture event: %lu", GetLastError());
+        return false;
+    }
+    hr = pAudioClient->SetEventHandle(event);
+    if (FAILED(hr)) {
+        LOG_ERROR_F("Failed to set capture event handle: 0x%08X", hr);
+        return false;
+    }
+
+    LOG_DEBUG("Getting audio capture client service");
+    hr = pAudioClient->GetService(
+        __uuidof(IAudioCaptureClient),
+        (void**)&pCaptureClient);
+    if (FAILED(hr)) {
+        LOG_ERROR_F("Failed to get audio capture client: 0x%08X", hr);
+        pCaptureClient = nullptr;
+        return false;
+    }
+    LOG_DEBUG("Audio capture client acquired successfully");
+
+    ReadFormat();
+    return true;
+}
+
+bool WasapiCaptureSource::AcquireDevice() {
+    HRESULT hr;
+
+    // Use selected device if specified, otherwise use default
+    if (!requested_id.empty()) {
+        LOG_DEBUG_F("Getting selected audio device: %s", requested_id.c_str());
+
+        hr = pEnumerator->GetDevice(Utf8ToWide(requested_id).c_str(), &pDevice);
+        if (FAILED(hr)) {
+            pDevice = nullptr;
+            if (!fallback_to_default) {
+                LOG_WARN_F("Failed to get audio device %s: 0x%08X", requested_id.c_str(), hr);
+                return false;
+            }
+            LOG_WARN_F("Failed to get selected audio device (0x%08X), falling back to default", hr);
+        } else {
+            LOG_DEBUG("Selected audio device acquired successfully");
+        }
+    }
+
+    if (!pDevice) {
+        LOG_DEBUG("Getting default audio endpoint");
+        hr = pEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &pDevice);
+        if (FAILED(hr)) {
+            LOG_ERROR_F("Failed to get default audio endpoint: 0x%08X", hr);
+            pDevice = nullptr;
+            return false;
+        }
+        LOG_DEBUG("Default audio endpoint acquired successfully");
+    }
+
+    // Store device info for the UI and logs
+    LPWSTR deviceId = nullptr;
+    hr = pDevice->GetId(&deviceId);
+    if (SUCCEEDED(hr)) {
+        id = WideToUtf8(deviceId);
+        CoTaskMemFree(deviceId);
+    }
+
+    name.clear();
+    IPropertyStore* pPropertyStore = nullptr;
+    hr = pDevice->OpenPropertyStore(STGM_READ, &pPropertyStore);
+    if (SUCCEEDED(hr)) {
+        PROPVARIANT friendlyName;
+        PropVariantInit(&friendlyName);
+        hr = pPropertyStore->GetValue(PKEY_Device_FriendlyName, &friendlyName);
+
+        if (SUCCEEDED(hr) && friendlyName.vt == VT_LPWSTR) {
+            name = WideToUtf8(friendlyName.pwszVal);
+        }
+
+        PropVariantClear(&friendlyName);
+        pPropertyStore->Release();
+    }
+
+    if (name.empty()) {
+        name = "Unknown Device";
+    }
+
+    LOG_DEBUG_F("Using audio device: %s (id %s)", name.c_str(), id.c_str());
+    return true;
+}
+
+HRESULT WasapiCaptureSource::InitializeClient(DWORD streamFlags) {
+    HRESULT hr = pAudioClient->Initialize(
+        AUDCLNT_SHAREMODE_SHARED,
+        streamFlags,
+        BUFFER_DURATION,
+        0,
+        pwfx,
+        nullptr);
+
+    // Handle device in use error by trying with different buffer settings
+    if (hr == AUDCLNT_E_DEVICE_IN_USE) {
+        LOG_DEBUG("Device in use, trying with auto buffer duration");
+        hr = pAudioClient->Initialize(
+            AUDCLNT_SHAREMODE_SHARED,
+            streamFlags,
+            0,  // Let Windows choose buffer duration
+            0,
+            pwfx,
+            nullptr);
+
+        if (SUCCEEDED(hr)) {
+            LOG_DEBUG("Successfully initialized with auto buffer duration");
+        }
+    }
+    return hr;
+}
+
+bool WasapiCaptureSource::InitializeWithFallbackFormats(DWORD streamFlags) {
+    LOG_DEBUG("Mix format not supported for loopback, trying fallback formats");
+
+    // Free the original format
+    CoTaskMemFree(pwfx);
+    pwfx = nullptr;
+
+    // Try common fallback formats that are usually supported
+    std::vector<std::tuple<DWORD, DWORD, WORD>> fallbackFormats = {
+        {44100, 2, 16},  // 44.1kHz, 2 channels, 16-bit
+        {48000, 2, 16},  // 48kHz, 2 channels, 16-bit
+        {44100, 2, 24},  // 44.1kHz, 2 channels, 24-bit
+        {48000, 2, 24},  // 48kHz, 2 channels, 24-bit
+        {44100, 2, 32},  // 44.1kHz, 2 channels, 32-bit
+        {48000, 2, 32}   // 48kHz, 2 channels, 32-bit
+    };
+
+    for (const auto& [sampleRate, channels, bitsPerSample] : fallbackFormats) {
+        // Create a new format structure
+        pwfx = (WAVEFORMATEX*)CoTaskMemAlloc(sizeof(WAVEFORMATEX));
+        if (!pwfx) {
+            LOG_ERROR("Failed to allocate memory for audio format");
+            return false;
+        }
+
+        pwfx->wFormatTag = WAVE_FORMAT_PCM;
+        pwfx->nChannels = channels;
+        pwfx->nSamplesPerSec = sampleRate;
+        pwfx->wBitsPerSample = bitsPerSample;
+        pwfx->nBlockAlign = (channels * bitsPerSample) / 8;
+        pwfx->nAvgBytesPerSec = sampleRate * pwfx->nBlockAlign;
+        pwfx->cbSize = 0;
+
+        LOG_DEBUG_F("Trying fallback format: %d channels, %d Hz, %d bits",
+                   pwfx->nChannels, pwfx->nSamplesPerSec, pwfx->wBitsPerSample);
+
+        // Check if this format is supported
+        WAVEFORMATEX* pClosestMatch = nullptr;
+        HRESULT hr = pAudioClient->IsFormatSupported(
+            AUDCLNT_SHAREMODE_SHARED,
+            pwfx,
+            &pClosestMatch);
+
+        if (hr == S_FALSE && pClosestMatch) {
+            // Format is not supported exactly, but a close match was suggested
+            LOG_DEBUG_F("Trying closest match format: %d channels, %d Hz, %d bits",
+                       pClosestMatch->nChannels, pClosestMatch->nSamplesPerSec, pClosestMatch->wBitsPerSample);
+
+            // Free our format and use the suggested one
+            CoTaskMemFree(pwfx);
+            pwfx = pClosestMatch;
+            pClosestMatch = nullptr;
+        }
+
+        if (hr == S_OK || hr == S_FALSE) {
+            hr = InitializeClient(streamFlags);
+            if (SUCCEEDED(hr)) {
+                LOG_DEBUG_F("Successfully initialized with fallback format: %d channels, %d Hz, %d bits",
+                           pwfx->nChannels, pwfx->nSamplesPerSec, pwfx->wBitsPerSample);
+                return true;
+            }
+        }
+
+        // Clean up the suggested format if any
+        if (pClosestMatch) {
+            CoTaskMemFree(pClosestMatch);
+        }
+
+        // This format didn't work, free it and try the next one
+        CoTaskMemFree(pwfx);
+        pwfx = nullptr;
+    }
+
+    return false;
+}
+
+void WasapiCaptureSource::ReadFormat() {
+    format = SampleFormat();
+    format.channels = pwfx->nChannels;
+    format.bytes_per_frame = pwfx->nBlockAlign;
+    format.sample_rate = pwfx->nSamplesPerSec;
+
+    bool is_float = pwfx->wFormatTag == WAVE_FORMAT_IEEE_FLOAT;
+    bool is_pcm = pwfx->wFormatTag == WAVE_FORMAT_PCM;
+    if (pwfx->wFormatTag == WAVE_FORMAT_EXTENSIBLE && pwfx->cbSize >= 22) {
+        const auto* extensible = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(pwfx);
+        is_float = IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) != 0;
+        is_pcm = IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_PCM) != 0;
+    }
+
+    // wBitsPerSample is the container size, so 24-in-32 decodes as Int32
+    if (is_float && pwfx->wBitsPerSample == 32) {
+        format.encoding = SampleFormat::Encoding::Float32;
+    } else if (is_pcm && pwfx->wBitsPerSample == 16) {
+        format.encoding = SampleFormat::Encoding::Int16;
+    } else if (is_pcm && pwfx->wBitsPerSample == 24) {
+        format.encoding = SampleFormat::Encoding::Int24;
+    } else if (is_pcm && pwfx->wBitsPerSample == 32) {
+        format.encoding = SampleFormat::Encoding::Int32;
+    } else {
+        LOG_ERROR_F("Unsupported capture format (tag 0x%04X, %d bits), audio will read as silence",
+                    pwfx->wFormatTag, pwfx->wBitsPerSample);
+    }
+
+    // Room for a full device buffer so reading never allocates
+    decode_left.resize(format.sample_rate / 10);
+    decode_right.resize(format.sample_rate / 10);
+}
+
+void WasapiCaptureSource::Close() {
+    if (pCaptureClient) {
+        pCaptureClient->Release();
+        pCaptureClient = nullptr;
+    }
+    if (pAudioClient) {
+        pAudioClient->Stop();
+        pAudioClient->Release();
+        pAudioClient = nullptr;
+    }
+    if (pDevice) {
+        pDevice->Release();
+        pDevice = nullptr;
+    }
+    if (pEnumerator) {
+        pEnumerator->Release();
+        pEnumerator = nullptr;
+    }
+    if (pwfx) {
+        CoTaskMemFree(pwfx);
+        pwfx = nullptr;
+    }
+    if (event) {
+        CloseHandle(event);
+        event = nullptr;
+    }
+}
+
+bool WasapiCaptureSource::Start() {
+    if (!pAudioClient) return false;
+
+    HRESULT hr = pAudioClient->Start();
+    if (FAILED(hr)) {
+        LOG_ERROR_F("Failed to start audio client for %s: 0x%08X", name.c_str(), hr);
+        return false;
+    }
+    gaps.Reset();
+    return true;
+}
+
+void WasapiCaptureSource::Stop() {
+    if (pAudioClient) {
+        pAudioClient->Stop();
+    }
+}
+
+bool WasapiCaptureSource::LastPacketReady(std::chrono::steady_clock::time_point* time) const {
+    if (has_packet_ready) {
+        *time = packet_ready;
+    }
+    return has_packet_ready;
+}
+
+void WasapiCaptureSource::NotePacketReady(UINT64 qpcPosition, UINT32 frames) {
+    // qpcPosition is the first frame's capture time in 100 ns units of the
+    // performance counter; the packet was complete one packet later.
+    // Only the age is taken from the counter, so the two clocks don't need
+    // a common epoch.
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    const int64_t frequency = qpc_frequency.QuadPart;
+    const int64_t now_100ns = counter.QuadPart / frequency * 10000000
+        + counter.QuadPart % frequency * 10000000 / frequency;
+    const int64_t ready_100ns = static_cast<int64_t>(qpcPosition)
+        + static_cast<int64_t>(frames) * 10000000 / std::max(format.sample_rate, 1u);
+    const int64_t age_100ns = std::max<int64_t>(now_100ns - ready_100ns, 0);
+    packet_ready = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<int64_t, std::ratio<1, 10000000>>(age_100ns));
+    has_packet_ready = true;
+}
+
+CaptureSource::ReadStatus WasapiCaptureSource::Read(PacketSink& sink) {
+    if (!pCaptureClient) return ReadStatus::Failed;
+
+    PipelineMetrics& metrics = PipelineMetrics::Get();
+    UINT32 framesRead = 0;
+    has_packet_ready = false;
+
+    UINT32 packetLength = 0;
+    HRESULT hr = pCaptureClient->GetNextPacketSize(&packetLength);
+
+    while (SUCCEEDED(hr) && packetLength > 0) {
+        BYTE* data;
+        UINT32 numFramesAvailable;
+        DWORD flags;
+        UINT64 devicePosition = 0;
+        UINT64 qpcPosition = 0;
+
+        {
+            PROFILE_ZONE("GetBuffer");
+            hr = pCaptureClient->GetBuffer(
+                &data,
+                &numFramesAvailable,
+                &flags,
+                &devicePosition,
+                &qpcPosition);
+        }
+        if (FAILED(hr)) {
+            break;
+        }
+
+        if (!has_packet_ready && qpcPosition != 0) {
+            NotePacketReady(qpcPosition, numFramesAvailable);
+        }
+        framesRead += numFramesAvailable;
+        metrics.frames_captured.Add(numFramesAvailable);
+        const bool silent = (flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0;
+        if (silent) {
+            metrics.silent_packets.Add();
+        }
+        if (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) {
+            metrics.discontinuities.Add();
+        }
+        GapTracker::Gap gap = gaps.OnPacket(devicePosition, numFramesAvailable,
+            (flags & AUDCLNT_BUFFERFLAGS_DATA_DISCONTINUITY) != 0);
+
+        if (numFramesAvailable > decode_left.size()) {
+            decode_left.resize(numFramesAvailable);
+            decode_right.resize(numFramesAvailable);
+        }
+        bool decoded = false;
+        if (!silent) {
+            PROFILE_ZONE("Decode");
+            decoded = DecodeStereo(format, data, numFramesAvailable, decode_left.data(), decode_right.data());
+        }
+
+        // The samples are copied out, so hand the packet back before the
+        // sink runs the block chain (detection, rules, OSC); holding it
+        // through that is what makes the engine drop data
+        {
+            PROFILE_ZONE("ReleaseBuffer");
+            hr = pCaptureClient->ReleaseBuffer(numFramesAvailable);
+        }
+
+        if (gap.detected) {
+            ReportGap(gap, sink);
+        }
+        if (decoded) {
+            sink.OnFrames(decode_left.data(), decode_right.data(), numFramesAvailable);
+        } else {
+            sink.OnSilence(numFramesAvailable);
+        }
+        if (FAILED(hr)) {
+            break;
+        }
+
+        hr = pCaptureClient->GetNextPacketSize(&packetLength);
+    }
+    if (framesRead > 0) {
+        metrics.queue_depth.Set(framesRead);
+    }
+
+    if (SUCCEEDED(hr)) {
+        return ReadStatus::Ok;
+    }
+    if (IsInvalidated(hr)) {
+        LOG_WARN_F("Audio device %s invalidated, marking for reconnection", name.c_str());
+        return ReadStatus::Invalidated;
+    }
+    LOG_ERROR_F("Unexpected capture error on %s: 0x%08X", name.c_str(), hr);
+    return ReadStatus::Failed;
+}
+#endif
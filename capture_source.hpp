@@ -0,0 +1,170 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#include <mmdeviceapi.h>
+#include <Audioclient.h>
+#endif
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "block_framer.hpp"
+
+// Receives captured audio, already converted to float stereo
+class PacketSink {
+public:
+    virtual ~PacketSink() = default;
+
+    virtual void OnFrames(const float* left, const float* right, size_t frames) = 0;
+    virtual void OnSilence(size_t frames) = 0;
+
+    // Audio was lost before the next packet: frames_lost frames by the
+    // stream position (0 if the device only flagged a discontinuity)
+    virtual void OnGap(uint64_t frames_lost) { (void)frames_lost; }
+};
+
+// Finds lost audio by comparing each packet's device position with where
+// the previous packet ended, and by the device's discontinuity flag
+class GapTracker {
+public:
+    struct Gap {
+        bool detected = false;
+        uint64_t frames_lost = 0;
+    };
+
+    // Call when the stream (re)starts; the first packet is never a gap
+    void Reset() { has_position = false; }
+
+    Gap OnPacket(uint64_t device_position, uint32_t frames, bool discontinuity);
+
+private:
+    bool has_position = false;
+    uint64_t expected_position = 0;
+};
+
+// One endpoint to capture from. All calls come from the capture thread
+// (or from the UI thread while that is stopped).
+class CaptureSource {
+public:
+    enum class ReadStatus {
+        Ok,
+        Invalidated,  // Device went away; reopen to continue
+        Failed
+    };
+
+    virtual ~CaptureSource() = default;
+
+    virtual bool Open() = 0;
+    virtual void Close() = 0;
+    virtual bool Start() = 0;
+    virtual void Stop() = 0;
+
+    // Deliver everything captured since the last call to sink
+    virtual ReadStatus Read(PacketSink& sink) = 0;
+
+    // Event signalled when new data is ready, or nullptr if the source has
+    // to be polled
+    virtual void* WaitHandle() const = 0;
+
+    // When the first packet of the last Read() was complete, on the steady
+    // clock. False if that Read() got nothing or the source has no packet
+    // timestamps.
+    virtual bool LastPacketReady(std::chrono::steady_clock::time_point*) const { return false; }
+
+    virtual const std::string& Id() const = 0;
+    virtual const std::string& Name() const = 0;
+    virtual unsigned SampleRate() const = 0;
+};
+
+// Synthetic stereo tone for running the pipeline without audio hardware.
+// Packets are paced by the clock like a real device; InjectGap() makes the
+// stream skip ahead, as if the capture thread had fallen behind. Polled.
+class FakeCaptureSource : public CaptureSource {
+public:
+    FakeCaptureSource(const std::string& id, unsigned sample_rate, size_t packet_frames);
+
+    bool Open() override { return true; }
+    void Close() override {}
+    bool Start() override;
+    void Stop() override { started = false; }
+    ReadStatus Read(PacketSink& sink) override;
+
+    void* WaitHandle() const override { return nullptr; }
+    const std::string& Id() const override { return id; }
+    const std::string& Name() const override { return id; }
+    unsigned SampleRate() const override { return sample_rate; }
+
+    // Drop this many frames before the next packet; any thread
+    void InjectGap(uint64_t frames) { pending_gap.fetch_add(frames); }
+
+private:
+    std::string id;
+    unsigned sample_rate;
+    size_t packet_frames;
+    bool started;
+    std::chrono::steady_clock::time_point start_time;
+    uint64_t packets_delivered;
+    uint64_t device_position;
+    std::atomic<uint64_t> pending_gap;
+    GapTracker gaps;
+    std::vector<float> left;
+    std::vector<float> right;
+};
+
+#ifdef _WIN32
+// Shared-mode WASAPI capture: loopback for render devices, direct capture
+// for inputs and VoiceMeeter buses. Event driven.
+class WasapiCaptureSource : public CaptureSource {
+public:
+    // An empty device_id means the default render device. With
+    // fallback_to_default, a missing device is replaced by the default one.
+    WasapiCaptureSource(const std::string& device_id, bool fallback_to_default);
+    ~WasapiCaptureSource() override;
+
+    WasapiCaptureSource(const WasapiCaptureSource&) = delete;
+    WasapiCaptureSource& operator=(const WasapiCaptureSource&) = delete;
+
+    bool Open() override;
+    void Close() override;
+    bool Start() override;
+    void Stop() override;
+    ReadStatus Read(PacketSink& sink) override;
+
+    void* WaitHandle() const override { return event; }
+    bool LastPacketReady(std::chrono::steady_clock::time_point* time) const override;
+    const std::string& Id() const override { return id; }
+    const std::string& Name() const override { return name; }
+    unsigned SampleRate() const override { return format.sample_rate; }
+
+private:
+    bool AcquireDevice();
+    HRESULT InitializeClient(DWORD streamFlags);
+    bool InitializeWithFallbackFormats(DWORD streamFlags);
+    void ReadFormat();
+    void NotePacketReady(UINT64 qpcPosition, UINT32 frames);
+
+    std::string requested_id;
+    bool fallback_to_default;
+    std::string id;
+    std::string name;
+
+    IMMDeviceEnumerator* pEnumerator;
+    IMMDevice* pDevice;
+    IAudioClient* pAudioClient;
+    IAudioCaptureClient* pCaptureClient;
+    WAVEFORMATEX* pwfx;
+    HANDLE event;
+    LARGE_INTEGER qpc_frequency;
+
+    // From the first packet's QPC timestamp, see LastPacketReady()
+    bool has_packet_ready;
+    std::chrono::steady_clock::time_point packet_ready;
+
+    SampleFormat format;
+    GapTracker gaps;
+    std::vector<float> decode_left;   // One device packet, deinterleaved
+    std::vector<float> decode_right;
+};
+#endif
@@ -1,8 +1,60 @@
 #include "config.hpp"
+#include "config_writer.hpp"
 #include "logger.hpp"
 #include <inih/INIReader.h>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+
+namespace {
+
+// Lists are stored as ';'-separated values (device ids contain commas)
+std::vector<std::string> SplitList(const std::string& value) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= value.size()) {
+        size_t end = value.find(';', start);
+        if (end == std::string::npos) end = value.size();
+        std::string item = value.substr(start, end - start);
+        if (!item.empty()) items.push_back(item);
+        start = end + 1;
+    }
+    return items;
+}
+
+template <typename T>
+std::string JoinList(const std::vector<T>& items) {
+    std::ostringstream out;
+    for (size_t i = 0; i < items.size(); i++) {
+        if (i > 0) out << ';';
+        out << items[i];
+    }
+    return out.str();
+}
+
+// rule1= ... rule64= in [rules]; gaps in the numbering are fine
+const int kMaxRules = 64;
+
+const char* MergeModeToString(MergeMode mode) {
+    return mode == MergeMode::WeightedSum ? "weighted" : "max";
+}
+
+LevelDetector LevelDetectorFromString(const std::string& text) {
+    if (text == "average") return LevelDetector::Average;
+    if (text == "peak") return LevelDetector::Peak;
+    return LevelDetector::Rms;
+}
+
+} // namespace
+
+const char* LevelDetectorToString(LevelDetector detector) {
+    switch (detector) {
+        case LevelDetector::Average: return "average";
+        case LevelDetector::Peak: return "peak";
+        default: return "rms";
+    }
+}
 
 // Helper function to convert LogLevel to string
 std::string LogLevelToString(LogLevel level) {
@@ -28,20 +80,57 @@ Config::Config()
     , address_left("/avatar/parameters/EarPerkLeft")
     , address_right("/avatar/parameters/EarPerkRight")
     , address_overwhelmingly_loud("/avatar/parameters/EarOverwhelm")
+    , compact_booleans(false)
     , differential_threshold(0.01f)
     , volume_threshold(0.2f)
     , excessive_volume_threshold(0.5f)
     , reset_timeout_ms(1000)
     , timeout_ms(100)
+    , window_ms(10)
+    , hop_ms(5)
+    , level_detector(LevelDetector::Rms)
+    , attack_ms(5)
+    , release_ms(150)
     , auto_volume_threshold(false)
     , auto_excessive_threshold(false)
     , volume_threshold_multiplier(2.0f)  // 2 standard deviations above mean
     , excessive_threshold_multiplier(3.0f)  // 3 standard deviations above mean
     , log_level(LogLevel::LWARN)  // Default to WARN level
     , selected_device_id("")  // Empty means use default device
+    , merge_mode(MergeMode::Max)
+    , realtime_priority(false)
+    , cpu_core(-1)  // Let the OS schedule the capture thread
+    , max_fps(30)
+    , metrics_port(0)  // Disabled
+    , stats_osc_address("")  // Disabled
+    , stats_interval_ms(1000)
+    , trace_file("")  // Disabled
 {
 }
 
+DetectionParams Config::GetDetectionParams() const {
+    DetectionParams params;
+    params.differential_threshold = differential_threshold;
+    params.volume_threshold = volume_threshold;
+    params.excessive_volume_threshold = excessive_volume_threshold;
+    params.reset_timeout_ms = reset_timeout_ms;
+    params.timeout_ms = timeout_ms;
+    params.auto_volume_threshold = auto_volume_threshold;
+    params.auto_excessive_threshold = auto_excessive_threshold;
+    params.volume_threshold_multiplier = volume_threshold_multiplier;
+    params.excessive_threshold_multiplier = excessive_threshold_multiplier;
+    params.merge_mode = merge_mode;
+    return params;
+}
+
+LevelSettings Config::GetLevelSettings() const {
+    LevelSettings level;
+    level.detector = level_detector;
+    level.attack_ms = attack_ms;
+    level.release_ms = release_ms;
+    return level;
+}
+
 std::string Config::GetDefaultConfigPath() {
 #ifdef _WIN32
     // Get %APPDATA% path
@@ -80,19 +169,38 @@ bool Config::CreateDefaultConfigFile(const std::string& filename) {
         << "port=9000\n"
         << "osc_address_left=/avatar/parameters/EarPerkLeft\n"
         << "osc_address_right=/avatar/parameters/EarPerkRight\n"
-        << "osc_address_overwhelmingly_loud=/avatar/parameters/EarOverwhelm\n\n"
+        << "osc_address_overwhelmingly_loud=/avatar/parameters/EarOverwhelm\n"
+        << "compact_booleans=false\n\n"
         << "[audio]\n"
         << "differential_threshold=0.01\n"
         << "volume_threshold=0.2\n"
         << "excessive_volume_threshold=0.5\n"
         << "reset_timeout_ms=1000\n"
         << "timeout_ms=100\n"
+        << "window_ms=10\n"
+        << "hop_ms=5\n"
+        << "level_detector=rms\n"
+        << "attack_ms=5\n"
+        << "release_ms=150\n"
         << "auto_volume_threshold=false\n"
         << "auto_excessive_threshold=false\n"
         << "volume_threshold_multiplier=2.0\n"
         << "excessive_threshold_multiplier=3.0\n"
         << "selected_device_id=\n"
-        << "log_level=WARN\n";
+        << "extra_device_ids=\n"
+        << "extra_device_weights=\n"
+        << "merge_mode=max\n"
+        << "realtime_priority=false\n"
+        << "cpu_core=-1\n"
+        << "log_level=WARN\n\n"
+        << "[ui]\n"
+        << "max_fps=30\n\n"
+        << "[metrics]\n"
+        << "metrics_port=0\n"
+        << "stats_osc_address=\n"
+        << "stats_interval_ms=1000\n"
+        << "trace_file=\n\n"
+        << "[rules]\n";
 
     return true;
 }
@@ -131,17 +239,42 @@ bool Config::LoadFromFile(const std::string& filename) {
     address_left = reader.Get("connection", "osc_address_left", address_left);
     address_right = reader.Get("connection", "osc_address_right", address_right);
     address_overwhelmingly_loud = reader.Get("connection", "osc_address_overwhelmingly_loud", address_overwhelmingly_loud);
+    compact_booleans = reader.GetBoolean("connection", "compact_booleans", compact_booleans);
 
     differential_threshold = reader.GetFloat("audio", "differential_threshold", differential_threshold);
     volume_threshold = reader.GetFloat("audio", "volume_threshold", volume_threshold);
     excessive_volume_threshold = reader.GetFloat("audio", "excessive_volume_threshold", excessive_volume_threshold);
     reset_timeout_ms = reader.GetInteger("audio", "reset_timeout_ms", reset_timeout_ms);
     timeout_ms = reader.GetInteger("audio", "timeout_ms", timeout_ms);
+    window_ms = reader.GetInteger("audio", "window_ms", window_ms);
+    hop_ms = reader.GetInteger("audio", "hop_ms", hop_ms);
+    level_detector = LevelDetectorFromString(reader.Get("audio", "level_detector", LevelDetectorToString(level_detector)));
+    attack_ms = reader.GetInteger("audio", "attack_ms", attack_ms);
+    release_ms = reader.GetInteger("audio", "release_ms", release_ms);
     auto_volume_threshold = reader.GetBoolean("audio", "auto_volume_threshold", auto_volume_threshold);
     auto_excessive_threshold = reader.GetBoolean("audio", "auto_excessive_threshold", auto_excessive_threshold);
     volume_threshold_multiplier = reader.GetFloat("audio", "volume_threshold_multiplier", volume_threshold_multiplier);
     excessive_threshold_multiplier = reader.GetFloat("audio", "excessive_threshold_multiplier", excessive_threshold_multiplier);
     selected_device_id = reader.Get("audio", "selected_device_id", selected_device_id);
+    extra_device_ids = SplitList(reader.Get("audio", "extra_device_ids", JoinList(extra_device_ids)));
+    extra_device_weights.clear();
+    for (const auto& weight : SplitList(reader.Get("audio", "extra_device_weights", ""))) {
+        extra_device_weights.push_back(static_cast<float>(std::atof(weight.c_str())));
+    }
+    std::string mergeModeStr = reader.Get("audio", "merge_mode", MergeModeToString(merge_mode));
+    merge_mode = (mergeModeStr == "weighted") ? MergeMode::WeightedSum : MergeMode::Max;
+    realtime_priority = reader.GetBoolean("audio", "realtime_priority", realtime_priority);
+    cpu_core = reader.GetInteger("audio", "cpu_core", cpu_core);
+    max_fps = reader.GetInteger("ui", "max_fps", max_fps);
+    metrics_port = reader.GetInteger("metrics", "metrics_port", metrics_port);
+    stats_osc_address = reader.Get("metrics", "stats_osc_address", stats_osc_address);
+    stats_interval_ms = reader.GetInteger("metrics", "stats_interval_ms", stats_interval_ms);
+    trace_file = reader.Get("metrics", "trace_file", trace_file);
+    rules.clear();
+    for (int i = 1; i <= kMaxRules; i++) {
+        std::string rule = reader.Get("rules", "rule" + std::to_string(i), "");
+        if (!rule.empty()) rules.push_back(rule);
+    }
     
     LOG_DEBUG_F("Config loaded - selected_device_id: '%s'", selected_device_id.c_str());
 
@@ -169,31 +302,56 @@ bool Config::LoadFromFile(const std::string& filename) {
 
 bool Config::SaveToFile(const std::string& filename) const {
     std::string configPath = filename.empty() ? GetDefaultConfigPath() : filename;
-    std::ofstream config_file(configPath);
-    if (!config_file.is_open()) {
+    if (!WriteFileAtomically(configPath, ToIniString())) {
         return false;
     }
+        
+    LOG_DEBUG_F("Config saved - selected_device_id: '%s'", selected_device_id.c_str());
 
-    config_file << "[connection]\n"
+    return true;
+}
+
+std::string Config::ToIniString() const {
+    std::ostringstream out;
+    out << "[connection]\n"
         << "address=" << address << "\n"
         << "port=" << port << "\n"
         << "osc_address_left=" << address_left << "\n"
         << "osc_address_right=" << address_right << "\n"
-        << "osc_address_overwhelmingly_loud=" << address_overwhelmingly_loud << "\n\n"
+        << "osc_address_overwhelmingly_loud=" << address_overwhelmingly_loud << "\n"
+        << "compact_booleans=" << (compact_booleans ? "true" : "false") << "\n\n"
         << "[audio]\n"
         << "differential_threshold=" << differential_threshold << "\n"
         << "volume_threshold=" << volume_threshold << "\n"
         << "excessive_volume_threshold=" << excessive_volume_threshold << "\n"
         << "reset_timeout_ms=" << reset_timeout_ms << "\n"
         << "timeout_ms=" << timeout_ms << "\n"
+        << "window_ms=" << window_ms << "\n"
+        << "hop_ms=" << hop_ms << "\n"
+        << "level_detector=" << LevelDetectorToString(level_detector) << "\n"
+        << "attack_ms=" << attack_ms << "\n"
+        << "release_ms=" << release_ms << "\n"
         << "auto_volume_threshold=" << (auto_volume_threshold ? "true" : "false") << "\n"
         << "auto_excessive_threshold=" << (auto_excessive_threshold ? "true" : "false") << "\n"
         << "volume_threshold_multiplier=" << volume_threshold_multiplier << "\n"
         << "excessive_threshold_multiplier=" << excessive_threshold_multiplier << "\n"
         << "selected_device_id=" << selected_device_id << "\n"
-        << "log_level=" << LogLevelToString(log_level) << "\n";
-        
-    LOG_DEBUG_F("Config saved - selected_device_id: '%s'", selected_device_id.c_str());
-
-    return true;
+        << "extra_device_ids=" << JoinList(extra_device_ids) << "\n"
+        << "extra_device_weights=" << JoinList(extra_device_weights) << "\n"
+        << "merge_mode=" << MergeModeToString(merge_mode) << "\n"
+        << "realtime_priority=" << (realtime_priority ? "true" : "false") << "\n"
+        << "cpu_core=" << cpu_core << "\n"
+        << "log_level=" << LogLevelToString(log_level) << "\n\n"
+        << "[ui]\n"
+        << "max_fps=" << max_fps << "\n\n"
+        << "[metrics]\n"
+        << "metrics_port=" << metrics_port << "\n"
+        << "stats_osc_address=" << stats_osc_address << "\n"
+        << "stats_interval_ms=" << stats_interval_ms << "\n"
+        << "trace_file=" << trace_file << "\n\n"
+        << "[rules]\n";
+    for (size_t i = 0; i < rules.size(); i++) {
+        out << "rule" << (i + 1) << "=" << rules[i] << "\n";
+    }
+    return out.str();
 }
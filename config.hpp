@@ -1,13 +1,84 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "logger.hpp"
 
+// How levels from several capture sources are combined before detection
+enum class MergeMode {
+    Max,          // Loudest weighted source per channel
+    WeightedSum
+};
+
+// How a block's level is measured
+enum class LevelDetector {
+    Average,  // Mean absolute amplitude over the block
+    Peak,     // Attack/release envelope of the absolute amplitude
+    Rms       // Attack/release envelope of the power
+};
+
+// "average", "peak" or "rms", as in config.ini
+const char* LevelDetectorToString(LevelDetector detector);
+
+struct LevelSettings {
+    LevelDetector detector;
+    int attack_ms;   // Envelope rise time constant
+    int release_ms;  // Envelope fall time constant
+
+    bool operator==(const LevelSettings& other) const {
+        return detector == other.detector && attack_ms == other.attack_ms && release_ms == other.release_ms;
+    }
+    bool operator!=(const LevelSettings& other) const { return !(*this == other); }
+};
+
+// The part of the configuration the audio thread reads while processing.
+// Kept trivially copyable so the UI can hand it over through a SeqLock.
+struct DetectionParams {
+    float differential_threshold;
+    float volume_threshold;
+    float excessive_volume_threshold;
+    int reset_timeout_ms;
+    int timeout_ms;
+    bool auto_volume_threshold;
+    bool auto_excessive_threshold;
+    float volume_threshold_multiplier;
+    float excessive_threshold_multiplier;
+    MergeMode merge_mode;
+
+    bool operator==(const DetectionParams& other) const {
+        return differential_threshold == other.differential_threshold
+            && volume_threshold == other.volume_threshold
+            && excessive_volume_threshold == other.excessive_volume_threshold
+            && reset_timeout_ms == other.reset_timeout_ms
+            && timeout_ms == other.timeout_ms
+            && auto_volume_threshold == other.auto_volume_threshold
+            && auto_excessive_threshold == other.auto_excessive_threshold
+            && volume_threshold_multiplier == other.volume_threshold_multiplier
+            && excessive_threshold_multiplier == other.excessive_threshold_multiplier
+            && merge_mode == other.merge_mode;
+    }
+    bool operator!=(const DetectionParams& other) const { return !(*this == other); }
+
+    // Equal apart from thresholds that both sides leave to the audio
+    // thread's auto adjustment, where the UI only mirrors a snapshot
+    bool SameUserSettings(const DetectionParams& other) const {
+        DetectionParams mine = *this;
+        if (auto_volume_threshold && other.auto_volume_threshold) {
+            mine.volume_threshold = other.volume_threshold;
+        }
+        if (auto_excessive_threshold && other.auto_excessive_threshold) {
+            mine.excessive_volume_threshold = other.excessive_volume_threshold;
+        }
+        return mine == other;
+    }
+};
+
 struct Config {
     std::string address;
     int port;
     std::string address_left;
     std::string address_right;
     std::string address_overwhelmingly_loud;
+    bool compact_booleans;  // Send booleans as OSC 1.1 T/F tags instead of int32
     bool auto_volume_threshold;
     bool auto_excessive_threshold;
     float volume_threshold_multiplier;
@@ -19,20 +90,57 @@ struct Config {
     float excessive_volume_threshold;
     int reset_timeout_ms;
     int timeout_ms;
+
+    // Analysis blocks: length and spacing, independent of device packets
+    int window_ms;
+    int hop_ms;  // Less than window_ms for overlapping blocks
+    LevelDetector level_detector;
+    int attack_ms;
+    int release_ms;
     
     // Audio device selection
     std::string selected_device_id;
 
+    // Additional devices captured alongside the selected one
+    std::vector<std::string> extra_device_ids;
+    std::vector<float> extra_device_weights;  // Per extra device, 1.0 if missing
+    MergeMode merge_mode;
+
+    // Capture thread scheduling
+    bool realtime_priority;  // MMCSS "Pro Audio" on Windows, SCHED_FIFO/SCHED_RR on Linux
+    int cpu_core;            // Core to pin the capture thread to, -1 for any
+
+    // UI
+    int max_fps;  // Redraw cap; the window only redraws when something changed
+
+    // Metrics export, read at startup
+    int metrics_port;               // Prometheus endpoint on 127.0.0.1, 0 to disable
+    std::string stats_osc_address;  // OSC address prefix for periodic stats, empty to disable
+    int stats_interval_ms;
+    std::string trace_file;         // Binary trace of every analysis block, empty to disable
+
+    // Extra OSC parameters, one rule1=, rule2=... line each in [rules];
+    // see rule_engine.hpp for the syntax
+    std::vector<std::string> rules;
+
     // Default constructor with reasonable defaults
     Config();
 
     // Load configuration from file, returns true if successful
     bool LoadFromFile(const std::string& filename = "");
 
+    // Copy of the detection settings for the audio thread
+    DetectionParams GetDetectionParams() const;
+    LevelSettings GetLevelSettings() const;
+
     // Create default config file if it doesn't exist
     static bool CreateDefaultConfigFile(const std::string& filename = "");
+    // Replaces the file atomically, see WriteFileAtomically()
     bool SaveToFile(const std::string& filename = "") const;
 
+    // The exact text SaveToFile writes
+    std::string ToIniString() const;
+
     // Get the default config file path in AppData
     static std::string GetDefaultConfigPath();
 };
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "config_watcher.hpp"
+#include "logger.hpp"
+#include "string_utils.hpp"
+#include <fstream>
+#include <iterator>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Editors save in several steps (truncate, write, rename); reload once
+// the file has been quiet for this long
+const int kSettleMs = 150;
+
+bool ReadFile(const std::string& path, std::string* content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    content->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+} // namespace
+
+ConfigWatcher::ConfigWatcher(const std::string& path, Callback on_reload)
+    : path(path)
+    , on_reload(std::move(on_reload))
+    , version(0)
+    , running(false)
+{
+    size_t slash = path.find_last_of("/\\");
+    directory = slash == std::string::npos ? "." : path.substr(0, slash);
+    file_name = slash == std::string::npos ? path : path.substr(slash + 1);
+#ifdef _WIN32
+    stop_event = nullptr;
+#else
+    stop_pipe[0] = stop_pipe[1] = -1;
+#endif
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    Stop();
+}
+
+bool ConfigWatcher::Start() {
+    if (running) return true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ReadFile(path, &known_content);
+    }
+
+#ifdef _WIN32
+    stop_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!stop_event) {
+        LOG_ERROR_F("Failed to create config watcher stop event: %lu", GetLastError());
+        return false;
+    }
+#else
+    if (pipe2(stop_pipe, O_CLOEXEC) != 0) {
+        LOG_ERROR_F("Failed to create config watcher stop pipe: %d", errno);
+        return false;
+    }
+#endif
+
+    running = true;
+    thread = std::thread(&ConfigWatcher::Run, this);
+    LOG_DEBUG_F("Watching %s for changes", path.c_str());
+    return true;
+}
+
+void ConfigWatcher::Stop() {
+    if (!running.exchange(false)) return;
+
+#ifdef _WIN32
+    SetEvent(static_cast<HANDLE>(stop_event));
+#else
+    char wake = 0;
+    (void)!write(stop_pipe[1], &wake, 1);
+#endif
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+#ifdef _WIN32
+    CloseHandle(static_cast<HANDLE>(stop_event));
+    stop_event = nullptr;
+#else
+    close(stop_pipe[0]);
+    close(stop_pipe[1]);
+    stop_pipe[0] = stop_pipe[1] = -1;
+#endif
+}
+
+void ConfigWatcher::ExpectContent(const std::string& content) {
+    std::lock_guard<std::mutex> lock(mutex);
+    known_content = content;
+}
+
+std::shared_ptr<const Config> ConfigWatcher::Latest() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return latest;
+}
+
+void ConfigWatcher::Reload() {
+    std::string content;
+    if (!ReadFile(path, &content)) {
+        // Replaced by rename and not back yet; its creation is another event
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (content == known_content) {
+            return;
+        }
+        known_content = content;
+    }
+
+    auto fresh = std::make_shared<Config>();
+    if (!fresh->LoadFromFile(path)) {
+        LOG_WARN_F("Could not reload configuration from %s, keeping the current settings", path.c_str());
+        return;
+    }
+    LOG_INFO_F("Configuration file changed, reloaded %s", path.c_str());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest = fresh;
+    }
+    version.fetch_add(1, std::memory_order_release);
+
+    if (on_reload) {
+        on_reload(fresh);
+    }
+}
+
+#ifdef _WIN32
+void ConfigWatcher::Run() {
+    // Watch the directory: saving by rename replaces the file itself
+    std::wstring wide_directory = Utf8ToWide(directory);
+    std::wstring wide_name = Utf8ToWide(file_name);
+    HANDLE dir = CreateFileW(wide_directory.c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (dir == INVALID_HANDLE_VALUE) {
+        LOG_ERROR_F("Failed to watch config directory %s: %lu", directory.c_str(), GetLastError());
+        return;
+    }
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    alignas(DWORD) BYTE buffer[4096];
+    bool queued = false;
+    bool pending = false;
+
+    while (running) {
+        if (!queued) {
+            ResetEvent(overlapped.hEvent);
+            if (!ReadDirectoryChangesW(dir, buffer, sizeof(buffer), FALSE,
+                    FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+                    nullptr, &overlapped, nullptr)) {
+                LOG_ERROR_F("ReadDirectoryChangesW failed: %lu", GetLastError());
+                break;
+            }
+            queued = true;
+        }
+
+        HANDLE handles[2] = { overlapped.hEvent, static_cast<HANDLE>(stop_event) };
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, pending ? kSettleMs : INFINITE);
+        if (result == WAIT_OBJECT_0 + 1) {
+            break;
+        }
+        if (result == WAIT_TIMEOUT) {
+            pending = false;
+            Reload();
+            continue;
+        }
+        if (result != WAIT_OBJECT_0) {
+            break;
+        }
+
+        queued = false;
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(dir, &overlapped, &bytes, FALSE)) {
+            continue;
+        }
+        if (bytes == 0) {
+            // Too many changes for the buffer; check the file anyway
+            pending = true;
+            continue;
+        }
+        auto* info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer);
+        while (true) {
+            std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            if (_wcsicmp(name.c_str(), wide_name.c_str()) == 0) {
+                pending = true;
+            }
+            if (info->NextEntryOffset == 0) break;
+            info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(reinterpret_cast<BYTE*>(info) + info->NextEntryOffset);
+        }
+    }
+
+    if (queued) {
+        DWORD bytes = 0;
+        CancelIoEx(dir, &overlapped);
+        GetOverlappedResult(dir, &overlapped, &bytes, TRUE);
+    }
+    CloseHandle(overlapped.hEvent);
+    CloseHandle(dir);
+}
+#else
+void ConfigWatcher::Run() {
+    // Watch the directory: saving by rename replaces the file itself
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0 || inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0) {
+        LOG_ERROR_F("Failed to watch config directory %s: %d", directory.c_str(), errno);
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    bool pending = false;
+
+    while (running) {
+        pollfd fds[2] = { { fd, POLLIN, 0 }, { stop_pipe[0], POLLIN, 0 } };
+        int ready = poll(fds, 2, pending ? kSettleMs : -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) {
+            break;
+        }
+        if (ready == 0) {
+            pending = false;
+            Reload();
+            continue;
+        }
+
+        ssize_t length;
+        while ((length = read(fd, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + length; ) {
+                auto* event = reinterpret_cast<inotify_event*>(p);
+                if (event->len > 0 && file_name == event->name) {
+                    pending = true;
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+
+    close(fd);
+}
+#endif
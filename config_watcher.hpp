@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "config.hpp"
+
+// Watches config.ini for changes made outside the app and parses them on
+// its own thread. Every successful parse becomes a new immutable Config
+// snapshot, handed to the callback and kept as Latest().
+class ConfigWatcher {
+public:
+    using Callback = std::function<void(std::shared_ptr<const Config>)>;
+
+    // on_reload runs on the watcher thread and must not block
+    ConfigWatcher(const std::string& path, Callback on_reload);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    bool Start();
+    void Stop();
+
+    // Contents this process is about to write. If that is exactly what a
+    // change event finds in the file, it is our own save, not a reload.
+    void ExpectContent(const std::string& content);
+
+    std::shared_ptr<const Config> Latest() const;
+
+    // Bumped for every published snapshot
+    uint32_t Version() const { return version.load(std::memory_order_acquire); }
+
+private:
+    void Run();
+    void Reload();
+
+    std::string path;
+    std::string directory;
+    std::string file_name;
+    Callback on_reload;
+
+    mutable std::mutex mutex;
+    std::string known_content;  // Last contents loaded or written by us
+    std::shared_ptr<const Config> latest;
+    std::atomic<uint32_t> version;
+    std::atomic<bool> running;
+    std::thread thread;
+
+#ifdef _WIN32
+    void* stop_event;
+#else
+    int stop_pipe[2];
+#endif
+};
@@ -0,0 +1,139 @@
+#include "config_writer.hpp"
+#include "logger.hpp"
+#include "string_utils.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool WriteFileAtomically(const std::string& path, const std::string& content) {
+    std::string temp_path = path + ".tmp";
+
+#ifdef _WIN32
+    std::wstring wide_temp = Utf8ToWide(temp_path);
+    std::wstring wide_path = Utf8ToWide(path);
+
+    HANDLE file = CreateFileW(wide_temp.c_str(), GENERIC_WRITE, 0, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR_F("Failed to create %s: %lu", temp_path.c_str(), GetLastError());
+        return false;
+    }
+
+    DWORD written = 0;
+    bool ok = WriteFile(file, content.data(), static_cast<DWORD>(content.size()), &written, nullptr)
+        && written == content.size()
+        && FlushFileBuffers(file);
+    CloseHandle(file);
+
+    if (!ok || !MoveFileExW(wide_temp.c_str(), wide_path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        LOG_ERROR_F("Failed to write %s: %lu", path.c_str(), GetLastError());
+        DeleteFileW(wide_temp.c_str());
+        return false;
+    }
+#else
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR_F("Failed to create %s: %d", temp_path.c_str(), errno);
+        return false;
+    }
+
+    bool ok = true;
+    size_t offset = 0;
+    while (ok && offset < content.size()) {
+        ssize_t written = write(fd, content.data() + offset, content.size() - offset);
+        if (written < 0 && errno == EINTR) continue;
+        ok = written > 0;
+        if (ok) offset += static_cast<size_t>(written);
+    }
+    ok = ok && fsync(fd) == 0;
+    ok = (close(fd) == 0) && ok;
+
+    if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        LOG_ERROR_F("Failed to write %s: %d", path.c_str(), errno);
+        unlink(temp_path.c_str());
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+ConfigWriter::ConfigWriter(const std::string& path, std::chrono::milliseconds debounce, WriteHook before_write)
+    : path(path)
+    , debounce(debounce)
+    , before_write(std::move(before_write))
+    , has_pending(false)
+    , running(false)
+{
+}
+
+ConfigWriter::~ConfigWriter() {
+    Stop();
+}
+
+void ConfigWriter::Start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return;
+    running = true;
+    thread = std::thread(&ConfigWriter::Run, this);
+}
+
+void ConfigWriter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void ConfigWriter::Save(std::string content) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending_content = std::move(content);
+        has_pending = true;
+        due = std::chrono::steady_clock::now() + debounce;
+    }
+    cv.notify_one();
+}
+
+void ConfigWriter::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this] { return !running || has_pending; });
+        if (!has_pending) {
+            break;  // Stopped with nothing left to write
+        }
+
+        // Every new save moves the deadline; stopping writes right away
+        while (running && std::chrono::steady_clock::now() < due) {
+            cv.wait_until(lock, due);
+        }
+
+        std::string content = std::move(pending_content);
+        has_pending = false;
+        lock.unlock();
+        Write(content);
+        lock.lock();
+    }
+}
+
+void ConfigWriter::Write(const std::string& content) {
+    if (before_write) {
+        before_write(content);
+    }
+    if (WriteFileAtomically(path, content)) {
+        LOG_DEBUG_F("Configuration saved to %s", path.c_str());
+    } else {
+        LOG_ERROR("Failed to save configuration");
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Replace path with content so that readers, and the file after a crash,
+// only ever see the old or the new version: writes a temporary file next
+// to it, flushes it to disk and renames it over the original.
+bool WriteFileAtomically(const std::string& path, const std::string& content);
+
+// Saves config.ini off the UI thread. Saves requested in quick succession
+// (a slider being dragged) are coalesced: only the latest content is
+// written, once no new save has come in for the debounce interval.
+class ConfigWriter {
+public:
+    // Runs on the writer thread just before the file is replaced
+    using WriteHook = std::function<void(const std::string& content)>;
+
+    ConfigWriter(const std::string& path, std::chrono::milliseconds debounce, WriteHook before_write = nullptr);
+    ~ConfigWriter();
+
+    ConfigWriter(const ConfigWriter&) = delete;
+    ConfigWriter& operator=(const ConfigWriter&) = delete;
+
+    void Start();
+
+    // Writes anything still pending before returning
+    void Stop();
+
+    // Never blocks on I/O
+    void Save(std::string content);
+
+private:
+    void Run();
+    void Write(const std::string& content);
+
+    std::string path;
+    std::chrono::milliseconds debounce;
+    WriteHook before_write;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string pending_content;
+    bool has_pending;
+    std::chrono::steady_clock::time_point due;
+    bool running;
+    std::thread thread;
+};
@@ -0,0 +1,131 @@
+#include "detector.hpp"
+#include "profile_zones.hpp"
+#include <algorithm>
+
+EarDetector::EarDetector(const DetectionParams& params, unsigned sample_rate)
+    : params(params)
+    , sample_rate(sample_rate)
+    , ears(kParameterCount)
+    , time_base()
+    , frames_since_base(0)
+{
+    analyzer.UpdateTimestamp(time_base);
+    UpdateTimings();
+}
+
+uint8_t EarDetector::Process(float left_level, float right_level, uint32_t frames) {
+    PROFILE_ZONE("Detector");
+    frames_since_base += frames;
+    ears.Advance(frames);
+    UpdateThresholds(left_level, right_level);
+
+    uint8_t request[kParameterCount] = {};
+    uint8_t events[kParameterCount] = {};
+    uint8_t decisions = 0;
+
+    request[kOverwhelm] = left_level > params.excessive_volume_threshold
+        || right_level > params.excessive_volume_threshold;
+    ears.Step(kOverwhelm, kOverwhelm + 1, request, events);
+    if (events[kOverwhelm] & HysteresisFired) decisions |= OverwhelmOn;
+    if (events[kOverwhelm] & HysteresisReleased) decisions |= OverwhelmOff;
+    if (ears.IsOn(kOverwhelm)) {
+        return decisions;
+    }
+
+    // Both ears when both sides are loud, otherwise the one that is
+    // louder by the differential threshold
+    bool both = left_level > params.differential_threshold
+        && right_level > params.differential_threshold
+        && left_level > params.volume_threshold
+        && right_level > params.volume_threshold;
+    request[kLeft] = both
+        || (left_level - right_level > params.differential_threshold && left_level > params.volume_threshold);
+    request[kRight] = both
+        || (!request[kLeft] && right_level - left_level > params.differential_threshold && right_level > params.volume_threshold);
+    if (both && !(ears.Ready(kLeft) && ears.Ready(kRight))) {
+        // Both ears perk together or not at all
+        request[kLeft] = request[kRight] = 0;
+        decisions |= Suppressed;
+    }
+
+    ears.Step(kLeft, kRight + 1, request, events);
+    if (events[kLeft] & HysteresisFired) decisions |= LeftPerk;
+    if (events[kRight] & HysteresisFired) decisions |= RightPerk;
+    if ((events[kLeft] | events[kRight]) & HysteresisSuppressed) decisions |= Suppressed;
+    if (events[kLeft] & HysteresisReleased) decisions |= LeftReset;
+    if (events[kRight] & HysteresisReleased) decisions |= RightReset;
+    return decisions;
+}
+
+void EarDetector::SetParams(DetectionParams latest) {
+    // Auto thresholds are computed here; the UI only echoes back what it
+    // saw in an earlier snapshot, so keep our current value
+    if (latest.auto_volume_threshold && params.auto_volume_threshold) {
+        latest.volume_threshold = params.volume_threshold;
+    }
+    if (latest.auto_excessive_threshold && params.auto_excessive_threshold) {
+        latest.excessive_volume_threshold = params.excessive_volume_threshold;
+    }
+    params = latest;
+    UpdateTimings();
+}
+
+void EarDetector::SetSampleRate(unsigned rate) {
+    if (rate == sample_rate) {
+        return;
+    }
+    time_base = StreamTime();
+    frames_since_base = 0;
+    sample_rate = rate;
+    UpdateTimings();
+}
+
+uint8_t EarDetector::State() const {
+    return static_cast<uint8_t>((LeftEarPerked() ? LeftPerked : 0)
+        | (RightEarPerked() ? RightPerked : 0)
+        | (IsOverwhelmed() ? Overwhelmed : 0));
+}
+
+void EarDetector::UpdateTimings() {
+    // Overwhelm has no cooldown: every loud block refreshes it
+    HysteresisBank::Timing overwhelm;
+    overwhelm.hold = HysteresisBank::MsToFrames(params.reset_timeout_ms, sample_rate);
+    ears.SetTiming(kOverwhelm, overwhelm);
+
+    HysteresisBank::Timing ear;
+    ear.cooldown = HysteresisBank::MsToFrames(params.timeout_ms, sample_rate);
+    ear.hold = HysteresisBank::MsToFrames(params.reset_timeout_ms, sample_rate);
+    ears.SetTiming(kLeft, ear);
+    ears.SetTiming(kRight, ear);
+}
+
+EarDetector::Clock::time_point EarDetector::StreamTime() const {
+    unsigned rate = std::max(sample_rate, 1u);
+    return time_base + std::chrono::seconds(frames_since_base / rate)
+        + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::nanoseconds((frames_since_base % rate) * 1000000000ull / rate));
+}
+
+void EarDetector::UpdateThresholds(float left_level, float right_level) {
+    Clock::time_point now = StreamTime();
+    if (!analyzer.ShouldUpdate(now)) {
+        return;
+    }
+    PROFILE_ZONE("Analyzer update");
+    analyzer.AddSample(left_level, right_level);
+    analyzer.UpdateTimestamp(now);
+
+    if (params.auto_volume_threshold || params.auto_excessive_threshold) {
+        auto [vol_threshold, excess_threshold] =
+            analyzer.GetSuggestedThresholds(
+                params.volume_threshold_multiplier,
+                params.excessive_threshold_multiplier);
+
+        if (params.auto_volume_threshold) {
+            params.volume_threshold = vol_threshold;
+        }
+        if (params.auto_excessive_threshold) {
+            params.excessive_volume_threshold = excess_threshold;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include "config.hpp"
+#include "hysteresis.hpp"
+#include "volume_analyzer.hpp"
+
+// What a block decided to send over OSC
+enum EarDecision : uint8_t {
+    LeftPerk = 1 << 0,
+    LeftReset = 1 << 1,
+    RightPerk = 1 << 2,
+    RightReset = 1 << 3,
+    OverwhelmOn = 1 << 4,
+    OverwhelmOff = 1 << 5,
+    Suppressed = 1 << 6  // A perk was held back by timeout_ms
+};
+
+// Ear state after a block
+enum EarState : uint8_t {
+    LeftPerked = 1 << 0,
+    RightPerked = 1 << 1,
+    Overwhelmed = 1 << 2
+};
+
+// The ear decisions for a stream of block levels. Knows nothing about
+// devices or OSC. Time is counted in the audio frames between blocks, so
+// recorded audio can be replayed through it faster than real time and
+// gives the same decisions as live capture.
+class EarDetector {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    EarDetector(const DetectionParams& params, unsigned sample_rate);
+
+    // One analysis block, `frames` after the previous one; returns the
+    // EarDecision bits to act on
+    uint8_t Process(float left_level, float right_level, uint32_t frames);
+
+    // Auto thresholds keep their current value if they stay automatic
+    void SetParams(DetectionParams latest);
+    const DetectionParams& Params() const { return params; }
+
+    // Millisecond settings are converted at this rate; cheap to call for
+    // every block
+    void SetSampleRate(unsigned rate);
+
+    bool LeftEarPerked() const { return ears.IsOn(kLeft); }
+    bool RightEarPerked() const { return ears.IsOn(kRight); }
+    bool IsOverwhelmed() const { return ears.IsOn(kOverwhelm); }
+    uint8_t State() const;
+
+    std::pair<float, float> AnalyzerStats() const { return analyzer.GetStats(); }
+
+private:
+    // Parameters in the hysteresis bank
+    enum Parameter : size_t { kOverwhelm, kLeft, kRight, kParameterCount };
+
+    void UpdateTimings();
+    void UpdateThresholds(float left_level, float right_level);
+    Clock::time_point StreamTime() const;
+
+    DetectionParams params;
+    unsigned sample_rate;
+    VolumeAnalyzer analyzer;
+    HysteresisBank ears;
+
+    // Stream time for the analyzer's update pacing: frames counted since
+    // the last sample rate change, on top of the time at that change
+    Clock::time_point time_base;
+    uint64_t frames_since_base;
+};
@@ -0,0 +1,227 @@
+#include "device_catalog.hpp"
+#include "logger.hpp"
+#include "string_utils.hpp"
+#include <chrono>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <mmdeviceapi.h>
+#include <mmreg.h>
+#include <functiondiscoverykeys_devpkey.h>
+#include <propvarutil.h>
+#endif
+
+namespace {
+
+// Devices come and go in bursts of notifications (one per role, format
+// and state); wait for the burst to end before enumerating
+const auto kSettleDelay = std::chrono::milliseconds(100);
+
+} // namespace
+
+DeviceCatalog::DeviceCatalog(DeviceWatcher& watcher, Enumerator enumerate)
+    : watcher(watcher)
+    , enumerate(std::move(enumerate))
+    , version(0)
+    , stale(true)
+    , running(false)
+{
+}
+
+DeviceCatalog::~DeviceCatalog() {
+    Stop();
+}
+
+void DeviceCatalog::Start() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running) return;
+        running = true;
+        stale = true;
+    }
+
+    // Any change can rename, add or remove a row, or move the default
+    if (!watcher.Start([this](const DeviceEvent&) { Invalidate(); })) {
+        LOG_WARN("Device watcher unavailable, the device list only updates on refresh");
+    }
+
+    thread = std::thread(&DeviceCatalog::Run, this);
+    LOG_DEBUG("Device catalog started");
+}
+
+void DeviceCatalog::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    watcher.Stop();
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    LOG_DEBUG("Device catalog stopped");
+}
+
+void DeviceCatalog::Invalidate() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stale = true;
+    }
+    cv.notify_one();
+}
+
+std::vector<AudioDeviceInfo> DeviceCatalog::GetDevices() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return devices;
+}
+
+bool DeviceCatalog::Lookup(const std::string& id, AudioDeviceInfo* info) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& device : devices) {
+        if (device.id == id) {
+            if (info) {
+                *info = device;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void DeviceCatalog::Run() {
+#ifdef _WIN32
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    bool com_initialized = SUCCEEDED(hr);
+    if (FAILED(hr) && hr != RPC_E_CHANGED_MODE) {
+        LOG_ERROR_F("Failed to initialize COM for device enumeration: 0x%08X", hr);
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        cv.wait(lock, [this] { return !running || stale; });
+        if (!running) break;
+
+        // Let the burst settle; further events during the wait are
+        // covered by this enumeration
+        cv.wait_for(lock, kSettleDelay, [this] { return !running; });
+        if (!running) break;
+        stale = false;
+
+        lock.unlock();
+        std::vector<AudioDeviceInfo> fresh = enumerate();
+        lock.lock();
+
+        devices = std::move(fresh);
+        version.fetch_add(1, std::memory_order_release);
+        LOG_DEBUG_F("Device list updated: %d devices", static_cast<int>(devices.size()));
+    }
+    lock.unlock();
+
+#ifdef _WIN32
+    if (com_initialized) {
+        CoUninitialize();
+    }
+#endif
+}
+
+#ifdef _WIN32
+namespace {
+
+// Friendly name and engine format from the property store
+void ReadDeviceProperties(IMMDevice* pDevice, AudioDeviceInfo& info) {
+    IPropertyStore* pPropertyStore = nullptr;
+    if (FAILED(pDevice->OpenPropertyStore(STGM_READ, &pPropertyStore))) {
+        return;
+    }
+
+    PROPVARIANT value;
+    PropVariantInit(&value);
+    if (SUCCEEDED(pPropertyStore->GetValue(PKEY_Device_FriendlyName, &value)) && value.vt == VT_LPWSTR) {
+        info.name = WideToUtf8(value.pwszVal);
+    }
+    PropVariantClear(&value);
+
+    if (SUCCEEDED(pPropertyStore->GetValue(PKEY_AudioEngine_DeviceFormat, &value)) &&
+        value.vt == VT_BLOB && value.blob.cbSize >= sizeof(WAVEFORMATEX)) {
+        const auto* format = reinterpret_cast<const WAVEFORMATEX*>(value.blob.pBlobData);
+        info.sampleRate = format->nSamplesPerSec;
+        info.channels = format->nChannels;
+    }
+    PropVariantClear(&value);
+
+    pPropertyStore->Release();
+}
+
+} // namespace
+
+std::vector<AudioDeviceInfo> EnumerateMMDevices() {
+    std::vector<AudioDeviceInfo> devices;
+
+    IMMDeviceEnumerator* pEnumerator = nullptr;
+    HRESULT hr = CoCreateInstance(
+        __uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+        __uuidof(IMMDeviceEnumerator), (void**)&pEnumerator);
+    if (FAILED(hr)) {
+        LOG_ERROR_F("Failed to create device enumerator for listing: 0x%08X", hr);
+        return devices;
+    }
+
+    // Get default device to mark it
+    std::string defaultDeviceId;
+    IMMDevice* pDefaultDevice = nullptr;
+    if (SUCCEEDED(pEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &pDefaultDevice))) {
+        LPWSTR id = nullptr;
+        if (SUCCEEDED(pDefaultDevice->GetId(&id))) {
+            defaultDeviceId = WideToUtf8(id);
+            CoTaskMemFree(id);
+        }
+        pDefaultDevice->Release();
+    }
+
+    // Enumerate both render and capture devices for comprehensive device list
+    const EDataFlow dataFlows[] = { eRender, eCapture };
+    for (EDataFlow dataFlow : dataFlows) {
+        IMMDeviceCollection* pCollection = nullptr;
+        if (FAILED(pEnumerator->EnumAudioEndpoints(dataFlow, DEVICE_STATE_ACTIVE, &pCollection))) {
+            continue;
+        }
+
+        UINT deviceCount = 0;
+        pCollection->GetCount(&deviceCount);
+        for (UINT i = 0; i < deviceCount; i++) {
+            IMMDevice* pDevice = nullptr;
+            if (FAILED(pCollection->Item(i, &pDevice))) {
+                continue;
+            }
+
+            LPWSTR deviceId = nullptr;
+            if (SUCCEEDED(pDevice->GetId(&deviceId))) {
+                AudioDeviceInfo info;
+                info.id = WideToUtf8(deviceId);
+                info.name = "Unknown Device";
+                info.isDefault = !defaultDeviceId.empty() && info.id == defaultDeviceId;
+                info.isRenderDevice = (dataFlow == eRender);
+                ReadDeviceProperties(pDevice, info);
+
+                // Add helpful identification for VoiceMeeter devices and device type
+                if (info.name.find("VoiceMeeter") != std::string::npos ||
+                    info.name.find("VAIO") != std::string::npos ||
+                    info.name.find("VB-Audio") != std::string::npos) {
+                    info.name += " [VoiceMeeter Virtual Device]";
+                }
+                info.name += info.isRenderDevice ? " (Output)" : " (Input)";
+
+                devices.push_back(std::move(info));
+                CoTaskMemFree(deviceId);
+            }
+            pDevice->Release();
+        }
+        pCollection->Release();
+    }
+
+    pEnumerator->Release();
+    return devices;
+}
+#endif
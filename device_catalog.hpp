@@ -0,0 +1,70 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "device_watcher.hpp"
+
+// One active audio endpoint as listed to the user
+struct AudioDeviceInfo {
+    std::string id;
+    std::string name;            // Friendly name with type label
+    bool isDefault = false;      // Default console render device
+    bool isRenderDevice = false; // true for render/output devices, false for capture/input devices
+    unsigned sampleRate = 0;     // Engine mix format, 0 if unknown
+    unsigned channels = 0;
+};
+
+// Cached table of audio endpoints, kept up to date on its own thread.
+// Enumerating opens every device's property store, which can take a
+// noticeable time, so nobody else ever does it: readers get a copy of the
+// last table and watcher events schedule a fresh enumeration.
+class DeviceCatalog {
+public:
+    using Enumerator = std::function<std::vector<AudioDeviceInfo>()>;
+
+    DeviceCatalog(DeviceWatcher& watcher, Enumerator enumerate);
+    ~DeviceCatalog();
+
+    DeviceCatalog(const DeviceCatalog&) = delete;
+    DeviceCatalog& operator=(const DeviceCatalog&) = delete;
+
+    // Enumerates once in the background, then again after every change
+    void Start();
+    void Stop();
+
+    // Ask for a fresh enumeration (e.g. from a refresh button)
+    void Invalidate();
+
+    std::vector<AudioDeviceInfo> GetDevices() const;
+    bool Lookup(const std::string& id, AudioDeviceInfo* info) const;
+
+    // Bumped each time the table is replaced, so callers can skip
+    // rebuilding anything derived from an unchanged table
+    uint32_t Version() const { return version.load(std::memory_order_acquire); }
+
+private:
+    void Run();
+
+    DeviceWatcher& watcher;
+    Enumerator enumerate;
+
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<AudioDeviceInfo> devices;
+    std::atomic<uint32_t> version;
+    bool stale;
+    bool running;
+    std::thread thread;
+};
+
+#ifdef _WIN32
+// Lists active render and capture endpoints through MMDevice. Must be
+// called on a thread with COM initialized.
+std::vector<AudioDeviceInfo> EnumerateMMDevices();
+#endif
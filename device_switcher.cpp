@@ -0,0 +1,192 @@
+#include "device_switcher.hpp"
+#include "logger.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace {
+
+// A silent loopback stream produces idle blocks after 100 ms, so anything
+// slower than this is a device that opened but isn't delivering
+const auto kWarmUpTimeout = std::chrono::seconds(2);
+
+} // namespace
+
+DeviceSwitcher::DeviceSwitcher(OpenFunction open)
+    : open(std::move(open))
+    , has_request(false)
+    , ready_flag(false)
+    , state(State::Idle)
+    , running(false)
+{
+}
+
+DeviceSwitcher::~DeviceSwitcher() {
+    Stop();
+}
+
+void DeviceSwitcher::Start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return;
+    running = true;
+    thread = std::thread(&DeviceSwitcher::Run, this);
+}
+
+void DeviceSwitcher::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+
+    // Nobody is left to take or retire these
+    ready_flag.store(false);
+    ready = WarmSource();
+    retired.clear();
+}
+
+void DeviceSwitcher::Request(const std::string& device_id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requested_id = device_id;
+        has_request = true;
+        state.store(State::Warming, std::memory_order_release);
+    }
+    cv.notify_one();
+}
+
+bool DeviceSwitcher::TakeReady(WarmSource* standby, std::string* device_id) {
+    if (!ready_flag.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!ready.source) {
+        return false;
+    }
+    *standby = std::move(ready);
+    *device_id = std::move(ready_id);
+    ready = WarmSource();
+    ready_flag.store(false);
+    if (!has_request) {
+        state.store(State::Switched, std::memory_order_release);
+    }
+    return true;
+}
+
+void DeviceSwitcher::Retire(WarmSource old) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        retired.push_back(std::move(old));
+    }
+    cv.notify_one();
+}
+
+void DeviceSwitcher::Run() {
+#ifdef _WIN32
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    bool com_initialized = SUCCEEDED(hr);
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        cv.wait(lock, [this] { return !running || has_request || !retired.empty(); });
+
+        // Release old sources first; closing can block in the driver
+        if (!retired.empty()) {
+            std::vector<WarmSource> closing = std::move(retired);
+            retired.clear();
+            lock.unlock();
+            for (auto& old : closing) {
+                if (old.source) {
+                    LOG_DEBUG_F("Releasing previous audio device %s", old.source->Name().c_str());
+                    old.source->Stop();
+                }
+            }
+            closing.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (!running || !has_request) continue;
+        std::string device_id = requested_id;
+        has_request = false;
+        lock.unlock();
+
+        WarmSource standby = open(device_id);
+        bool warmed = standby.source && WarmUp(standby);
+
+        if (!warmed) {
+            LOG_ERROR_F("Failed to bring up audio device '%s', keeping the current one", device_id.c_str());
+            standby = WarmSource();
+            lock.lock();
+            if (!has_request) {
+                state.store(State::Failed, std::memory_order_release);
+            }
+            continue;
+        }
+
+        lock.lock();
+
+        // A standby nobody took yet is superseded by this one
+        if (ready.source) {
+            retired.push_back(std::move(ready));
+        }
+        ready = std::move(standby);
+        ready_id = device_id;
+        ready_flag.store(true, std::memory_order_release);
+        if (!has_request) {
+            state.store(State::Ready, std::memory_order_release);
+        }
+    }
+    lock.unlock();
+
+#ifdef _WIN32
+    if (com_initialized) {
+        CoUninitialize();
+    }
+#endif
+}
+
+bool DeviceSwitcher::WarmUp(WarmSource& standby) {
+    if (!standby.source->Start()) {
+        return false;
+    }
+
+    // Run the new source until its first block so the switch doesn't
+    // wait for the device's startup latency
+    auto deadline = std::chrono::steady_clock::now() + kWarmUpTimeout;
+    while (standby.pipeline->BlockCount() == 0) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            LOG_WARN_F("Audio device %s delivered no audio while warming up", standby.source->Name().c_str());
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) return false;
+        }
+
+#ifdef _WIN32
+        if (HANDLE handle = standby.source->WaitHandle()) {
+            WaitForSingleObject(handle, 10);
+        } else {
+            Sleep(1);
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+        if (standby.source->Read(*standby.pipeline) != CaptureSource::ReadStatus::Ok) {
+            return false;
+        }
+        standby.pipeline->FeedIdle(std::chrono::steady_clock::now());
+    }
+
+    LOG_INFO_F("Audio device %s is warm, switching", standby.source->Name().c_str());
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "capture_source.hpp"
+#include "source_pipeline.hpp"
+
+// A capture source together with the pipeline it feeds
+struct WarmSource {
+    std::unique_ptr<CaptureSource> source;
+    std::unique_ptr<SourcePipeline> pipeline;
+};
+
+// Brings up a new capture device on its own thread while the current one
+// keeps running. Once the new source has produced its first block it is
+// offered to the capture thread, which swaps it in and hands the old
+// source back here to be torn down. Neither the UI nor the capture thread
+// ever waits for a device to open or close.
+class DeviceSwitcher {
+public:
+    enum class State {
+        Idle,
+        Warming,   // Opening the requested device and waiting for audio
+        Ready,     // Waiting for the capture thread to take it
+        Switched,
+        Failed
+    };
+
+    // Opens (but doesn't start) a source for device_id, with a pipeline
+    // that has no block callback. Returns an empty WarmSource on failure.
+    using OpenFunction = std::function<WarmSource(const std::string& device_id)>;
+
+    explicit DeviceSwitcher(OpenFunction open);
+    ~DeviceSwitcher();
+
+    DeviceSwitcher(const DeviceSwitcher&) = delete;
+    DeviceSwitcher& operator=(const DeviceSwitcher&) = delete;
+
+    void Start();
+    void Stop();
+
+    // Switch to device_id (empty for the default device). A newer request
+    // replaces one that hasn't started warming yet.
+    void Request(const std::string& device_id);
+
+    // Capture thread: take the standby if one is ready. Cheap otherwise.
+    bool TakeReady(WarmSource* standby, std::string* device_id);
+
+    // Capture thread: give up a source; it is stopped and released here
+    void Retire(WarmSource old);
+
+    State GetState() const { return state.load(std::memory_order_acquire); }
+
+private:
+    void Run();
+    bool WarmUp(WarmSource& standby);
+
+    OpenFunction open;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string requested_id;
+    bool has_request;
+    WarmSource ready;
+    std::string ready_id;
+    std::vector<WarmSource> retired;
+    std::atomic<bool> ready_flag;  // Lets TakeReady skip the lock
+    std::atomic<State> state;
+    bool running;
+    std::thread thread;
+};
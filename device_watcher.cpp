@@ -0,0 +1,291 @@
+#include "device_watcher.hpp"
+#include "logger.hpp"
+#include "string_utils.hpp"
+#include <algorithm>
+
+#ifdef _WIN32
+// Called by the audio service on its own threads. Only converts the
+// notification and hands it on; the callback must not block.
+class MMDeviceWatcher::NotificationClient : public IMMNotificationClient {
+public:
+    explicit NotificationClient(Callback callback)
+        : refCount(1), callback(std::move(callback)) {}
+
+    ULONG STDMETHODCALLTYPE AddRef() override {
+        return InterlockedIncrement(&refCount);
+    }
+
+    ULONG STDMETHODCALLTYPE Release() override {
+        ULONG count = InterlockedDecrement(&refCount);
+        if (count == 0) {
+            delete this;
+        }
+        return count;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppv) override {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IMMNotificationClient)) {
+            *ppv = static_cast<IMMNotificationClient*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR deviceId) override {
+        // We only ever follow the default console render device
+        if (flow == eRender && role == eConsole) {
+            callback({DeviceEvent::Type::DefaultChanged, WideToUtf8(deviceId), true});
+        }
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR deviceId, DWORD newState) override {
+        callback({DeviceEvent::Type::StateChanged, WideToUtf8(deviceId), newState == DEVICE_STATE_ACTIVE});
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR deviceId) override {
+        callback({DeviceEvent::Type::Added, WideToUtf8(deviceId), true});
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR deviceId) override {
+        callback({DeviceEvent::Type::Removed, WideToUtf8(deviceId), false});
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR, const PROPERTYKEY) override {
+        return S_OK;
+    }
+
+private:
+    LONG refCount;
+    Callback callback;
+};
+
+MMDeviceWatcher::MMDeviceWatcher()
+    : client(nullptr)
+    , enumerator(nullptr)
+{
+}
+
+MMDeviceWatcher::~MMDeviceWatcher() {
+    Stop();
+}
+
+bool MMDeviceWatcher::Start(Callback callback) {
+    if (client) return true;
+
+    HRESULT hr = CoCreateInstance(
+        __uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+        __uuidof(IMMDeviceEnumerator), (void**)&enumerator);
+    if (FAILED(hr)) {
+        LOG_ERROR_F("Failed to create device enumerator for notifications: 0x%08X", hr);
+        enumerator = nullptr;
+        return false;
+    }
+
+    client = new NotificationClient(std::move(callback));
+    hr = enumerator->RegisterEndpointNotificationCallback(client);
+    if (FAILED(hr)) {
+        LOG_ERROR_F("Failed to register device notification callback: 0x%08X", hr);
+        client->Release();
+        client = nullptr;
+        enumerator->Release();
+        enumerator = nullptr;
+        return false;
+    }
+
+    LOG_DEBUG("Device notification callback registered");
+    return true;
+}
+
+void MMDeviceWatcher::Stop() {
+    if (client) {
+        // Unregistering waits for callbacks in flight to return
+        enumerator->UnregisterEndpointNotificationCallback(client);
+        client->Release();
+        client = nullptr;
+    }
+    if (enumerator) {
+        enumerator->Release();
+        enumerator = nullptr;
+    }
+}
+#endif
+
+bool FakeDeviceWatcher::Start(Callback cb) {
+    std::lock_guard<std::mutex> lock(mutex);
+    callback = std::move(cb);
+    return true;
+}
+
+void FakeDeviceWatcher::Stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    callback = nullptr;
+}
+
+void FakeDeviceWatcher::Inject(const DeviceEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (callback) {
+        callback(event);
+    }
+}
+
+DeviceSupervisor::DeviceSupervisor(DeviceWatcher& watcher, std::atomic<bool>& reconnect_flag)
+    : watcher(watcher)
+    , reconnect_flag(reconnect_flag)
+    , follow_default(true)
+    , attached(false)
+    , running(false)
+{
+}
+
+DeviceSupervisor::~DeviceSupervisor() {
+    Stop();
+}
+
+bool DeviceSupervisor::Attach() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (attached) return true;
+        attached = true;
+    }
+
+    // Outside the lock: the watcher may deliver events as soon as it starts
+    if (!watcher.Start([this](const DeviceEvent& event) { Enqueue(event); })) {
+        std::lock_guard<std::mutex> lock(mutex);
+        attached = false;
+        return false;
+    }
+    return true;
+}
+
+bool DeviceSupervisor::Start() {
+    if (!Attach()) {
+        LOG_WARN("Device watcher unavailable, device changes will only be noticed on capture errors");
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running) return true;
+        running = true;
+    }
+    thread = std::thread(&DeviceSupervisor::Run, this);
+    LOG_DEBUG("Device supervisor started");
+    return true;
+}
+
+void DeviceSupervisor::Stop() {
+    bool was_attached;
+    bool was_running;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        was_attached = attached;
+        was_running = running;
+        attached = false;
+        running = false;
+    }
+    // Unregistering waits for callbacks in flight, which take the lock
+    if (was_attached) {
+        watcher.Stop();
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (was_running) {
+        LOG_DEBUG("Device supervisor stopped");
+    }
+}
+
+void DeviceSupervisor::SetCurrentDevice(const std::string& device_id, bool follow) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current_device_id = device_id;
+    follow_default = follow;
+}
+
+void DeviceSupervisor::SetExtraDevices(const std::vector<std::string>& device_ids) {
+    std::lock_guard<std::mutex> lock(mutex);
+    extra_device_ids = device_ids;
+}
+
+void DeviceSupervisor::ProcessPendingEvents() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!queue.empty()) {
+        DeviceEvent event = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        Handle(event);
+        lock.lock();
+    }
+}
+
+void DeviceSupervisor::Enqueue(const DeviceEvent& event) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(event);
+    }
+    cv.notify_one();
+}
+
+void DeviceSupervisor::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        cv.wait(lock, [this] { return !running || !queue.empty(); });
+        while (!queue.empty()) {
+            DeviceEvent event = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            Handle(event);
+            lock.lock();
+        }
+    }
+}
+
+void DeviceSupervisor::Handle(const DeviceEvent& event) {
+    std::string device_id;
+    bool follow;
+    bool is_extra;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        device_id = current_device_id;
+        follow = follow_default;
+        is_extra = std::find(extra_device_ids.begin(), extra_device_ids.end(), event.device_id) != extra_device_ids.end();
+    }
+
+    bool reconnect = false;
+    switch (event.type) {
+        case DeviceEvent::Type::DefaultChanged:
+            reconnect = follow && event.device_id != device_id;
+            if (reconnect) {
+                LOG_DEBUG("Default audio device changed, marking for reconnection");
+            }
+            break;
+        case DeviceEvent::Type::StateChanged:
+        case DeviceEvent::Type::Removed:
+            reconnect = !event.active && event.device_id == device_id;
+            if (reconnect) {
+                LOG_DEBUG("Current audio device is no longer active, marking for reconnection");
+            }
+            // Extra devices are picked up again when they come back
+            if (is_extra) {
+                reconnect = true;
+                LOG_DEBUG("Extra audio device changed state, marking for reconnection");
+            }
+            break;
+        case DeviceEvent::Type::Added:
+            if (is_extra) {
+                reconnect = true;
+                LOG_DEBUG("Extra audio device added, marking for reconnection");
+            }
+            break;
+    }
+
+    if (reconnect) {
+        reconnect_flag.store(true);
+    }
+}
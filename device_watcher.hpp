@@ -0,0 +1,127 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#include <mmdeviceapi.h>
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A change to the set or state of audio endpoints
+struct DeviceEvent {
+    enum class Type {
+        DefaultChanged,  // device_id is the new default render device (empty if none)
+        StateChanged,    // device_id changed state, see active
+        Added,
+        Removed
+    };
+
+    Type type;
+    std::string device_id;
+    bool active = false;
+};
+
+// Source of device change notifications. Implementations deliver events
+// on their own thread and must not block in the callback.
+class DeviceWatcher {
+public:
+    using Callback = std::function<void(const DeviceEvent&)>;
+
+    virtual ~DeviceWatcher() = default;
+
+    virtual bool Start(Callback callback) = 0;
+    virtual void Stop() = 0;
+};
+
+#ifdef _WIN32
+// Watches endpoints through IMMNotificationClient
+class MMDeviceWatcher : public DeviceWatcher {
+public:
+    MMDeviceWatcher();
+    ~MMDeviceWatcher() override;
+
+    MMDeviceWatcher(const MMDeviceWatcher&) = delete;
+    MMDeviceWatcher& operator=(const MMDeviceWatcher&) = delete;
+
+    bool Start(Callback callback) override;
+    void Stop() override;
+
+private:
+    class NotificationClient;
+
+    NotificationClient* client;
+    IMMDeviceEnumerator* enumerator;
+};
+#endif
+
+// Watcher whose events are injected by hand, for exercising the
+// reconnect logic without real devices
+class FakeDeviceWatcher : public DeviceWatcher {
+public:
+    bool Start(Callback callback) override;
+    void Stop() override;
+
+    // Deliver an event as if it came from the system
+    void Inject(const DeviceEvent& event);
+
+private:
+    std::mutex mutex;
+    Callback callback;
+};
+
+// Decides on its own thread whether watcher events affect the device
+// being captured, and raises the capture loop's reconnect flag if so.
+// The capture loop only ever checks that flag.
+class DeviceSupervisor {
+public:
+    DeviceSupervisor(DeviceWatcher& watcher, std::atomic<bool>& reconnect_flag);
+    ~DeviceSupervisor();
+
+    DeviceSupervisor(const DeviceSupervisor&) = delete;
+    DeviceSupervisor& operator=(const DeviceSupervisor&) = delete;
+
+    // Registers with the watcher, so its events are queued from now on.
+    // Start() does this too; without Start(), ProcessPendingEvents()
+    // handles the queue.
+    bool Attach();
+
+    // Attaches and handles events on the supervisor's own thread
+    bool Start();
+    void Stop();
+
+    // Device currently being captured. When following the default device,
+    // a change of default render device also triggers a reconnect.
+    void SetCurrentDevice(const std::string& device_id, bool follow_default);
+
+    // Additional devices being captured. Losing one, or one of them coming
+    // back, also triggers a reconnect.
+    void SetExtraDevices(const std::vector<std::string>& device_ids);
+
+    // Process all queued events on the calling thread; for tests, which
+    // Attach() without starting the thread
+    void ProcessPendingEvents();
+
+private:
+    void Enqueue(const DeviceEvent& event);
+    void Run();
+    void Handle(const DeviceEvent& event);
+
+    DeviceWatcher& watcher;
+    std::atomic<bool>& reconnect_flag;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<DeviceEvent> queue;
+    std::string current_device_id;
+    std::vector<std::string> extra_device_ids;
+    bool follow_default;
+    bool attached;
+    bool running;
+    std::thread thread;
+};
@@ -0,0 +1,118 @@
+#include "envelope_follower.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define EARPERK_ENVELOPE_SSE 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Below this the envelope is silence. Flushing it keeps a long release
+// from decaying into denormals, which are very slow on x86.
+const float kFloor = 1e-20f;
+
+// One-pole smoothing: the share of the remaining distance covered per
+// sample, reaching 63% of a step after `ms`
+float Coefficient(double ms, unsigned sample_rate) {
+    if (ms <= 0.0 || sample_rate == 0) {
+        return 1.0f;
+    }
+    return static_cast<float>(1.0 - std::exp(-1000.0 / (ms * sample_rate)));
+}
+
+// Left and right share one SSE register, so each sample costs a single
+// set of compare, select and multiply-add for both channels.
+//
+// Peak: the envelope moves towards |x|, at the attack rate when that is
+// up and the release rate when it is down. Rms: x^2 is first averaged
+// with the attack rate, and the envelope follows that average straight
+// up and with the release rate down.
+template <bool kRms>
+void Follow(float* power, float* envelope, float attack, float release,
+            const float* left, const float* right, size_t frames) {
+#ifdef EARPERK_ENVELOPE_SSE
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 attack_v = _mm_set1_ps(attack);
+    const __m128 release_v = _mm_set1_ps(release);
+    __m128 mean_square = _mm_setr_ps(power[0], power[1], 0.0f, 0.0f);
+    __m128 env = _mm_setr_ps(envelope[0], envelope[1], 0.0f, 0.0f);
+    for (size_t i = 0; i < frames; i++) {
+        __m128 x = _mm_unpacklo_ps(_mm_load_ss(left + i), _mm_load_ss(right + i));
+        __m128 target;
+        __m128 rising_coeff;
+        if (kRms) {
+            mean_square = _mm_add_ps(mean_square, _mm_mul_ps(attack_v, _mm_sub_ps(_mm_mul_ps(x, x), mean_square)));
+            target = mean_square;
+            rising_coeff = _mm_set1_ps(1.0f);
+        } else {
+            target = _mm_andnot_ps(sign, x);
+            rising_coeff = attack_v;
+        }
+        __m128 rising = _mm_cmpgt_ps(target, env);
+        __m128 coeff = _mm_or_ps(_mm_and_ps(rising, rising_coeff), _mm_andnot_ps(rising, release_v));
+        env = _mm_add_ps(env, _mm_mul_ps(coeff, _mm_sub_ps(target, env)));
+    }
+    const __m128 floor_v = _mm_set1_ps(kFloor);
+    mean_square = _mm_and_ps(mean_square, _mm_cmpge_ps(mean_square, floor_v));
+    env = _mm_and_ps(env, _mm_cmpge_ps(env, floor_v));
+    float out[4];
+    _mm_storeu_ps(out, mean_square);
+    power[0] = out[0];
+    power[1] = out[1];
+    _mm_storeu_ps(out, env);
+    envelope[0] = out[0];
+    envelope[1] = out[1];
+#else
+    const float* channels[2] = { left, right };
+    for (int c = 0; c < 2; c++) {
+        float mean_square = power[c];
+        float env = envelope[c];
+        for (size_t i = 0; i < frames; i++) {
+            float x = channels[c][i];
+            float target;
+            float rising_coeff;
+            if (kRms) {
+                mean_square += attack * (x * x - mean_square);
+                target = mean_square;
+                rising_coeff = 1.0f;
+            } else {
+                target = std::abs(x);
+                rising_coeff = attack;
+            }
+            env += (target > env ? rising_coeff : release) * (target - env);
+        }
+        power[c] = mean_square >= kFloor ? mean_square : 0.0f;
+        envelope[c] = env >= kFloor ? env : 0.0f;
+    }
+#endif
+}
+
+} // namespace
+
+EnvelopeFollower::EnvelopeFollower(Mode mode, int attack_ms, int release_ms, unsigned sample_rate)
+    : mode(mode)
+    , attack(Coefficient(attack_ms, sample_rate))
+    // Power falling with half the time constant is the level falling with the whole
+    , release(Coefficient(mode == Mode::Rms ? release_ms / 2.0 : release_ms, sample_rate))
+    , power{ 0.0f, 0.0f }
+    , envelope{ 0.0f, 0.0f }
+{
+}
+
+void EnvelopeFollower::Process(const float* left, const float* right, size_t frames) {
+    if (mode == Mode::Rms) {
+        Follow<true>(power, envelope, attack, release, left, right, frames);
+    } else {
+        Follow<false>(power, envelope, attack, release, left, right, frames);
+    }
+}
+
+float EnvelopeFollower::Left() const {
+    return mode == Mode::Rms ? std::sqrt(envelope[0]) : envelope[0];
+}
+
+float EnvelopeFollower::Right() const {
+    return mode == Mode::Rms ? std::sqrt(envelope[1]) : envelope[1];
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+
+// Attack/release envelope of a stereo stream, run for every sample. Rises
+// towards louder input with the attack time constant and falls back with
+// the release one, so a short sound isn't averaged away over a block and a
+// sustained one doesn't flicker from block to block.
+class EnvelopeFollower {
+public:
+    enum class Mode {
+        Peak,  // Rises to the absolute sample value within attack
+        Rms    // Power averaged over attack, so a steady sine reads 0.707
+    };
+
+    EnvelopeFollower(Mode mode, int attack_ms, int release_ms, unsigned sample_rate);
+
+    // Both channels advance together; left and right are `frames` long
+    void Process(const float* left, const float* right, size_t frames);
+
+    float Left() const;
+    float Right() const;
+
+private:
+    Mode mode;
+    float attack;   // Share of the distance to the input covered per sample
+    float release;
+    float power[2];     // Left, right mean square; Rms mode only
+    float envelope[2];  // Left, right; squared in Rms mode
+};
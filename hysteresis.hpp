@@ -0,0 +1,115 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What a step did to a parameter
+enum HysteresisEvent : uint8_t {
+    HysteresisFired = 1 << 0,       // Turned (or stayed) on with a fresh trigger
+    HysteresisReleased = 1 << 1,    // Turned off after hold
+    HysteresisSuppressed = 1 << 2   // Wanted to fire but was still cooling down
+};
+
+// A set of on/off parameters with the same timing rules: fire once the
+// condition has held for `attack` frames, not again within `cooldown`
+// frames of the last trigger, and turn off `hold` frames after it.
+//
+// Time is counted in audio frames, so decisions follow the stream rather
+// than when the capture thread got to run. State is kept as one array per
+// field, and Advance() / Step() are straight loops over them without
+// branches, so many parameters update in a single vectorizable pass.
+class HysteresisBank {
+public:
+    enum Phase : uint8_t {
+        Idle,       // Off
+        Armed,      // Off, condition holds but attack or cooldown not yet met
+        Active,     // On, condition holds
+        Holding,    // On, condition gone, waiting out hold
+        Releasing   // Turned off by this step; Idle or Armed after the next
+    };
+
+    struct Timing {
+        uint32_t attack = 0;
+        uint32_t cooldown = 0;
+        uint32_t hold = 0;
+    };
+
+    explicit HysteresisBank(size_t count)
+        : attack(count, 0)
+        , cooldown(count, 0)
+        , hold(count, 0)
+        , phase(count, Idle)
+        , since_trigger(count, 0)
+        , since_armed(count, 0) {}
+
+    size_t Size() const { return phase.size(); }
+
+    // A millisecond setting as frames at the given rate
+    static uint32_t MsToFrames(int ms, unsigned sample_rate) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(std::max(ms, 0)) * sample_rate / 1000);
+    }
+
+    void SetTiming(size_t index, const Timing& timing) {
+        attack[index] = timing.attack;
+        cooldown[index] = timing.cooldown;
+        hold[index] = timing.hold;
+    }
+
+    // Moves every parameter `frames` further along
+    void Advance(uint32_t frames) {
+        const uint32_t limit = UINT32_MAX - frames;  // Saturate instead of wrapping
+        for (size_t i = 0; i < phase.size(); i++) {
+            since_trigger[i] = std::min(since_trigger[i], limit) + frames;
+            since_armed[i] = std::min(since_armed[i], limit) + frames;
+        }
+    }
+
+    // Could a request fire right now, cooldown-wise
+    bool Ready(size_t index) const { return since_trigger[index] > cooldown[index]; }
+    bool IsOn(size_t index) const { return phase[index] == Active || phase[index] == Holding; }
+    Phase GetPhase(size_t index) const { return static_cast<Phase>(phase[index]); }
+
+    // Applies this block's conditions to parameters [begin, end): request[i]
+    // is nonzero where the condition holds. Writes HysteresisEvent bits to
+    // events[i]; both arrays are indexed like the bank.
+    void Step(size_t begin, size_t end, const uint8_t* request, uint8_t* events) {
+        // Raw pointers, so the uint8_t stores don't force reloading the
+        // vectors' own pointers on every iteration
+        const uint32_t* attack_frames = attack.data();
+        const uint32_t* cooldown_frames = cooldown.data();
+        const uint32_t* hold_frames = hold.data();
+        uint8_t* phases = phase.data();
+        uint32_t* triggered = since_trigger.data();
+        uint32_t* armed = since_armed.data();
+        for (size_t i = begin; i < end; i++) {
+            uint32_t wanted = request[i] != 0;
+            uint32_t on = (phases[i] == Active) | (phases[i] == Holding);
+            armed[i] *= wanted;
+
+            uint32_t due = wanted & (armed[i] >= attack_frames[i]);
+            uint32_t ready = triggered[i] > cooldown_frames[i];
+            uint32_t fire = due & ready;
+            triggered[i] *= fire ^ 1;
+            uint32_t release = on & (fire ^ 1) & (triggered[i] > hold_frames[i]);
+            uint32_t stays_on = (on | fire) & (release ^ 1);
+
+            // Active or Holding while on; Releasing, Armed or Idle while off
+            static_assert(Active + 1 == Holding, "on_phase below relies on the order");
+            uint32_t on_phase = Holding - wanted;
+            uint32_t off_phase = release ? static_cast<uint32_t>(Releasing) : wanted * Armed;
+            phases[i] = static_cast<uint8_t>(stays_on ? on_phase : off_phase);
+            events[i] = static_cast<uint8_t>(fire * HysteresisFired
+                | release * HysteresisReleased
+                | (due & (ready ^ 1)) * HysteresisSuppressed);
+        }
+    }
+
+private:
+    std::vector<uint32_t> attack;
+    std::vector<uint32_t> cooldown;
+    std::vector<uint32_t> hold;
+    std::vector<uint8_t> phase;
+    std::vector<uint32_t> since_trigger;  // Frames since the last trigger
+    std::vector<uint32_t> since_armed;    // Frames the condition has held
+};
@@ -0,0 +1,388 @@
+#include "logger.hpp"
+#include <ctime>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <ShlObj.h>
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+// How often the logger thread wakes when nobody asks it to
+const auto kDrainInterval = std::chrono::milliseconds(50);
+
+// Rotation: EarPerkOSC.log grows to this size, then moves to .1, .1 to .2
+// and so on
+const uint64_t kMaxFileSize = 5 * 1024 * 1024;
+const int kBackupCount = 3;
+
+struct ThreadRingHandle {
+    std::shared_ptr<logging::Ring> ring;
+    ~ThreadRingHandle() {
+        if (ring) ring->Orphan();
+    }
+};
+
+thread_local ThreadRingHandle thread_ring;
+
+std::string DefaultLogPath() {
+#ifdef _WIN32
+    CHAR appDataPath[MAX_PATH];
+    if (SUCCEEDED(SHGetFolderPathA(NULL, CSIDL_APPDATA, NULL, 0, appDataPath))) {
+        std::string logDir = std::string(appDataPath) + "\\EarPerkOSC";
+        _mkdir(logDir.c_str());
+        return logDir + "\\EarPerkOSC.log";
+    }
+    return "EarPerkOSC.log";
+#else
+    const char* home = getenv("HOME");
+    if (home) {
+        std::string logDir = std::string(home) + "/.config/EarPerkOSC";
+        mkdir(logDir.c_str(), 0755);
+        return logDir + "/EarPerkOSC.log";
+    }
+    return "EarPerkOSC.log";
+#endif
+}
+
+const char* LevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::LDEBUG: return "DEBUG";
+        case LogLevel::LINFO: return "INFO";
+        case LogLevel::LWARN: return "WARN";
+        case LogLevel::LERROR: return "ERROR";
+    }
+    return "?";
+}
+
+// Reads back the arguments packed by RecordWriter
+class RecordReader {
+public:
+    explicit RecordReader(const logging::Record& record) : record(record), offset(0) {}
+
+    bool Next(logging::Record::Tag* tag, uint64_t* bits, std::string* text) {
+        if (offset >= record.payload_used) return false;
+        *tag = static_cast<logging::Record::Tag>(record.payload[offset++]);
+        if (*tag == logging::Record::String) {
+            uint16_t length;
+            std::memcpy(&length, record.payload + offset, sizeof(length));
+            offset += sizeof(length);
+            text->assign(reinterpret_cast<const char*>(record.payload + offset), length);
+            offset += length;
+        } else {
+            std::memcpy(bits, record.payload + offset, sizeof(*bits));
+            offset += sizeof(*bits);
+        }
+        return true;
+    }
+
+private:
+    const logging::Record& record;
+    size_t offset;
+};
+
+// Formats one conversion with snprintf, converting the stored value to
+// the type the length modifier asks for, as printf itself would have read it
+void FormatArgument(std::string& out, const std::string& spec, char conversion, const std::string& length,
+                    logging::Record::Tag tag, uint64_t bits, const std::string& text) {
+    char buffer[512];
+    int written = -1;
+    int64_t as_signed = static_cast<int64_t>(bits);
+    double as_double;
+    std::memcpy(&as_double, &bits, sizeof(as_double));
+
+    switch (conversion) {
+        case 'd': case 'i':
+            if (tag == logging::Record::Double) as_signed = static_cast<int64_t>(as_double);
+            if (length == "ll" || length == "j") written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<long long>(as_signed));
+            else if (length == "l") written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<long>(as_signed));
+            else if (length == "z" || length == "t") written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<ptrdiff_t>(as_signed));
+            else written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<int>(as_signed));
+            break;
+        case 'u': case 'x': case 'X': case 'o':
+            if (tag == logging::Record::Double) bits = static_cast<uint64_t>(as_double);
+            if (length == "ll" || length == "j") written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<unsigned long long>(bits));
+            else if (length == "l") written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<unsigned long>(bits));
+            else if (length == "z" || length == "t") written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<size_t>(bits));
+            else written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<unsigned int>(bits));
+            break;
+        case 'c':
+            written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<int>(as_signed));
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            if (tag == logging::Record::Signed) as_double = static_cast<double>(as_signed);
+            else if (tag == logging::Record::Unsigned) as_double = static_cast<double>(bits);
+            if (length == "L") written = snprintf(buffer, sizeof(buffer), spec.c_str(), static_cast<long double>(as_double));
+            else written = snprintf(buffer, sizeof(buffer), spec.c_str(), as_double);
+            break;
+        case 's':
+            if (tag == logging::Record::String) {
+                // Precision and width still apply; the text itself can be long
+                if (spec == "%s") {
+                    out += text;
+                    return;
+                }
+                written = snprintf(buffer, sizeof(buffer), spec.c_str(), text.c_str());
+            }
+            break;
+        case 'p':
+            written = snprintf(buffer, sizeof(buffer), spec.c_str(), reinterpret_cast<void*>(static_cast<uintptr_t>(bits)));
+            break;
+    }
+
+    if (written < 0) {
+        out += spec;  // Argument doesn't fit the conversion; show where
+    } else {
+        out.append(buffer, std::min<size_t>(static_cast<size_t>(written), sizeof(buffer) - 1));
+    }
+}
+
+std::string FormatRecord(const logging::Record& record) {
+    if (record.verbatim) {
+        return record.format;
+    }
+
+    std::string out;
+    RecordReader reader(record);
+    const char* p = record.format;
+    while (*p) {
+        if (*p != '%') {
+            out += *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out += '%';
+            p += 2;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion
+        const char* start = p++;
+        while (*p && std::strchr("-+ #0", *p)) p++;
+        while (*p >= '0' && *p <= '9') p++;
+        if (*p == '.') {
+            p++;
+            while (*p >= '0' && *p <= '9') p++;
+        }
+        const char* length_start = p;
+        while (*p && std::strchr("hljztL", *p)) p++;
+        std::string length(length_start, p);
+        if (!*p) {
+            out.append(start, p);
+            break;
+        }
+        char conversion = *p++;
+        std::string spec(start, p);
+
+        logging::Record::Tag tag;
+        uint64_t bits = 0;
+        std::string text;
+        if (!reader.Next(&tag, &bits, &text)) {
+            out += spec;  // More conversions than arguments
+            continue;
+        }
+        FormatArgument(out, spec, conversion, length, tag, bits, text);
+    }
+    return out;
+}
+
+} // namespace
+
+Logger& Logger::getInstance() {
+    static Logger instance;
+    return instance;
+}
+
+Logger::Logger()
+    : running(false)
+    , level(LogLevel::LWARN)
+    , next_thread_number(0)
+    , flush_requested(0)
+    , flush_completed(0)
+    , stopping(false)
+    , file(nullptr)
+    , file_size(0)
+    , wall_clock_offset_ns(0)
+{
+}
+
+Logger::~Logger() {
+    Shutdown();
+}
+
+bool Logger::Initialize(const std::string& log_path) {
+    if (running) return true;
+
+    path = log_path.empty() ? DefaultLogPath() : log_path;
+    file = fopen(path.c_str(), "a");
+    if (!file) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    file_size = size > 0 ? static_cast<uint64_t>(size) : 0;
+
+    wall_clock_offset_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count() - Now();
+
+    stopping = false;
+    running = true;
+    thread = std::thread(&Logger::Run, this);
+    return true;
+}
+
+void Logger::Shutdown() {
+    if (!running.exchange(false)) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+void Logger::Flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!running || stopping) return;
+    uint64_t target = ++flush_requested;
+    cv.notify_one();
+    flushed_cv.wait(lock, [this, target] { return flush_completed >= target || stopping; });
+}
+
+logging::Ring* Logger::ThreadRing() {
+    if (!thread_ring.ring) {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        thread_ring.ring = std::make_shared<logging::Ring>(++next_thread_number);
+        rings.push_back(thread_ring.ring);
+    }
+    return thread_ring.ring.get();
+}
+
+void Logger::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (!stopping && flush_requested == flush_completed) {
+            // Errors notify without the lock, so an early wake-up is fine
+            cv.wait_for(lock, kDrainInterval);
+        }
+        bool stop = stopping;
+        uint64_t target = flush_requested;
+
+        lock.unlock();
+        Drain();
+        lock.lock();
+
+        flush_completed = target;
+        flushed_cv.notify_all();
+        if (stop) {
+            break;
+        }
+    }
+}
+
+bool Logger::Drain() {
+    std::vector<std::shared_ptr<logging::Ring>> current;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        current = rings;
+    }
+
+    // Take what every thread has so far and write it in time order
+    std::vector<size_t> counts(current.size());
+    std::vector<bool> orphaned(current.size());
+    batch.clear();
+    for (size_t i = 0; i < current.size(); i++) {
+        orphaned[i] = current[i]->IsOrphaned();  // Before counting, so nothing comes after
+        counts[i] = current[i]->Readable();
+        for (size_t j = 0; j < counts[i]; j++) {
+            batch.emplace_back(&current[i]->At(j), current[i]->ThreadNumber());
+        }
+    }
+    std::stable_sort(batch.begin(), batch.end(), [](const auto& a, const auto& b) {
+        return a.first->timestamp_ns < b.first->timestamp_ns;
+    });
+
+    std::string line;
+    for (const auto& entry : batch) {
+        const logging::Record& record = *entry.first;
+        std::chrono::system_clock::time_point wall_time{std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::nanoseconds(record.timestamp_ns + wall_clock_offset_ns))};
+        std::time_t seconds = std::chrono::system_clock::to_time_t(wall_time);
+        int millis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            wall_time.time_since_epoch()).count() % 1000);
+        std::tm local = {};
+#ifdef _WIN32
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        char prefix[64];
+        size_t prefix_length = std::strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+        snprintf(prefix + prefix_length, sizeof(prefix) - prefix_length, ".%03d [%s] [t%u] ",
+            millis, LevelName(record.level), entry.second);
+
+        line = prefix;
+        line += FormatRecord(record);
+        line += '\n';
+        WriteLine(line);
+    }
+    batch.clear();
+
+    bool wrote = false;
+    for (size_t i = 0; i < current.size(); i++) {
+        current[i]->Release(counts[i]);
+        wrote = wrote || counts[i] > 0;
+        if (uint64_t dropped = current[i]->TakeDropped()) {
+            char note[96];
+            snprintf(note, sizeof(note), "Logger: %llu messages from thread t%u were dropped, its queue was full\n",
+                static_cast<unsigned long long>(dropped), current[i]->ThreadNumber());
+            WriteLine(note);
+            wrote = true;
+        }
+    }
+
+    // Threads that exited and have nothing left are forgotten
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        for (size_t i = 0; i < current.size(); i++) {
+            if (orphaned[i] && current[i]->Readable() == 0) {
+                rings.erase(std::remove(rings.begin(), rings.end(), current[i]), rings.end());
+            }
+        }
+    }
+
+    if (wrote && file) {
+        fflush(file);
+    }
+    return wrote;
+}
+
+void Logger::WriteLine(const std::string& line) {
+    RotateIfNeeded();
+    if (!file) return;
+    fwrite(line.data(), 1, line.size(), file);
+    file_size += line.size();
+}
+
+void Logger::RotateIfNeeded() {
+    if (!file || file_size < kMaxFileSize) return;
+
+    fclose(file);
+    std::remove((path + "." + std::to_string(kBackupCount)).c_str());
+    for (int i = kBackupCount - 1; i >= 1; i--) {
+        std::rename((path + "." + std::to_string(i)).c_str(), (path + "." + std::to_string(i + 1)).c_str());
+    }
+    std::rename(path.c_str(), (path + ".1").c_str());
+
+    file = fopen(path.c_str(), "w");
+    file_size = 0;
+}
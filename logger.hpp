@@ -0,0 +1,258 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+enum class LogLevel { LDEBUG, LINFO, LWARN, LERROR };
+
+namespace logging {
+
+// One log call as the calling thread leaves it: the format string by
+// pointer (it must be a literal) and the arguments in raw form. Strings
+// are copied in, since they rarely outlive the call. Formatting happens
+// later on the logger thread.
+struct Record {
+    static const size_t kPayloadSize = 216;
+
+    enum Tag : unsigned char { Signed, Unsigned, Double, Pointer, String };
+
+    const char* format;
+    int64_t timestamp_ns;   // steady_clock
+    LogLevel level;
+    bool verbatim;          // format is the whole message, no arguments
+    uint16_t payload_used;
+    unsigned char payload[kPayloadSize];
+};
+
+// Packs arguments into a record's payload: a tag byte, then 8 bytes of
+// value, or a 2-byte length and the characters of a string. Strings are
+// cut short when the payload runs out.
+class RecordWriter {
+public:
+    explicit RecordWriter(Record& record) : record(record) { record.payload_used = 0; }
+
+    template <typename T>
+    void Add(const T& value) {
+        using Arg = std::decay_t<T>;
+        if constexpr (std::is_same_v<Arg, std::string>) {
+            AddString(value.data(), value.size());
+        } else if constexpr (std::is_array_v<T>) {
+            AddString(value, std::strlen(value));
+        } else if constexpr (std::is_same_v<Arg, const char*> || std::is_same_v<Arg, char*>) {
+            const char* text = value ? value : "(null)";
+            AddString(text, std::strlen(text));
+        } else if constexpr (std::is_floating_point_v<Arg>) {
+            AddValue(Record::Double, static_cast<double>(value));
+        } else if constexpr (std::is_pointer_v<Arg>) {
+            AddValue(Record::Pointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+        } else if constexpr (std::is_enum_v<Arg>) {
+            AddValue(Record::Signed, static_cast<int64_t>(value));
+        } else if constexpr (std::is_signed_v<Arg>) {
+            AddValue(Record::Signed, static_cast<int64_t>(value));
+        } else {
+            static_assert(std::is_unsigned_v<Arg>, "Unsupported log argument type");
+            AddValue(Record::Unsigned, static_cast<uint64_t>(value));
+        }
+    }
+
+private:
+    template <typename V>
+    void AddValue(Record::Tag tag, V value) {
+        if (size_t(record.payload_used) + 1 + sizeof(V) > Record::kPayloadSize) return;
+        record.payload[record.payload_used++] = tag;
+        std::memcpy(record.payload + record.payload_used, &value, sizeof(V));
+        record.payload_used += sizeof(V);
+    }
+
+    void AddString(const char* text, size_t length) {
+        if (size_t(record.payload_used) + 3 > Record::kPayloadSize) return;
+        length = std::min(length, Record::kPayloadSize - record.payload_used - 3);
+        uint16_t stored = static_cast<uint16_t>(length);
+        record.payload[record.payload_used++] = Record::String;
+        std::memcpy(record.payload + record.payload_used, &stored, sizeof(stored));
+        record.payload_used += sizeof(stored);
+        std::memcpy(record.payload + record.payload_used, text, length);
+        record.payload_used += stored;
+    }
+
+    Record& record;
+};
+
+// Single-producer, single-consumer queue of records. Each logging thread
+// owns one; only the logger thread reads it. When it is full the record
+// is dropped and counted rather than waiting.
+class Ring {
+public:
+    static const size_t kCapacity = 512;
+
+    explicit Ring(uint32_t thread_number)
+        : slots(kCapacity), head(0), tail(0), dropped(0), orphaned(false), thread_number(thread_number) {}
+
+    // Producer side
+    Record* BeginWrite() {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= kCapacity) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &slots[h % kCapacity];
+    }
+    // True when the ring just became half full, time to wake the reader
+    bool CommitWrite() {
+        uint64_t h = head.load(std::memory_order_relaxed) + 1;
+        head.store(h, std::memory_order_release);
+        return h - tail.load(std::memory_order_relaxed) == kCapacity / 2;
+    }
+
+    // Consumer side: records [0, Readable()) can be read until Release()
+    size_t Readable() const {
+        return static_cast<size_t>(head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed));
+    }
+    const Record& At(size_t index) const { return slots[(tail.load(std::memory_order_relaxed) + index) % kCapacity]; }
+    void Release(size_t count) { tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release); }
+    uint64_t TakeDropped() { return dropped.exchange(0, std::memory_order_relaxed); }
+
+    void Orphan() { orphaned.store(true, std::memory_order_release); }
+    bool IsOrphaned() const { return orphaned.load(std::memory_order_acquire); }
+    uint32_t ThreadNumber() const { return thread_number; }
+
+private:
+    std::vector<Record> slots;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+    std::atomic<bool> orphaned;  // The owning thread has exited
+    uint32_t thread_number;
+};
+
+} // namespace logging
+
+// Asynchronous logger. A log call only copies the format pointer and its
+// arguments into the calling thread's ring; formatting, writing the file,
+// rotation and flushing happen on the logger's own thread. The level is
+// checked by the macros before any argument is evaluated.
+class Logger {
+public:
+    static Logger& getInstance();
+
+    // Opens the log file (by default %APPDATA%/EarPerkOSC/EarPerkOSC.log)
+    // and starts the logger thread. Nothing is recorded before this.
+    bool Initialize(const std::string& path = "");
+    void Shutdown();
+
+    void SetLevel(LogLevel new_level) { level.store(new_level, std::memory_order_relaxed); }
+    LogLevel GetLevel() const { return level.load(std::memory_order_relaxed); }
+
+    bool IsEnabled(LogLevel message_level) const {
+        return running.load(std::memory_order_relaxed) && message_level >= level.load(std::memory_order_relaxed);
+    }
+
+    // Blocks until everything logged before the call is in the file
+    void Flush();
+
+    // printf-style; format must be a string literal
+    template <typename... Args>
+    void Log(LogLevel message_level, const char* format, const Args&... args) {
+        logging::Ring* ring = ThreadRing();
+        logging::Record* record = ring ? ring->BeginWrite() : nullptr;
+        if (!record) return;
+        record->format = format;
+        record->timestamp_ns = Now();
+        record->level = message_level;
+        record->verbatim = false;
+        logging::RecordWriter writer(*record);
+        (writer.Add(args), ...);
+        // Errors reach the file even if we crash soon after
+        if (ring->CommitWrite() || message_level == LogLevel::LERROR) {
+            cv.notify_one();
+        }
+    }
+
+    // message must be a string literal; it's written as is
+    void LogMessage(LogLevel message_level, const char* message) {
+        logging::Ring* ring = ThreadRing();
+        logging::Record* record = ring ? ring->BeginWrite() : nullptr;
+        if (!record) return;
+        record->format = message;
+        record->timestamp_ns = Now();
+        record->level = message_level;
+        record->verbatim = true;
+        record->payload_used = 0;
+        if (ring->CommitWrite() || message_level == LogLevel::LERROR) {
+            cv.notify_one();
+        }
+    }
+
+private:
+    Logger();
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    static int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    logging::Ring* ThreadRing();
+    void Run();
+    bool Drain();
+    void WriteLine(const std::string& line);
+    void RotateIfNeeded();
+
+    std::atomic<bool> running;
+    std::atomic<LogLevel> level;
+
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<logging::Ring>> rings;
+    uint32_t next_thread_number;
+
+    // Logger thread
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::condition_variable flushed_cv;
+    uint64_t flush_requested;
+    uint64_t flush_completed;
+    bool stopping;
+    std::thread thread;
+
+    // Owned by the logger thread once started
+    std::string path;
+    FILE* file;
+    uint64_t file_size;
+    int64_t wall_clock_offset_ns;  // system_clock minus steady_clock at startup
+    std::vector<std::pair<const logging::Record*, uint32_t>> batch;  // Record and thread number
+};
+
+#define LOG_MESSAGE_AT(level, message) \
+    do { \
+        Logger& logger_ = Logger::getInstance(); \
+        if (logger_.IsEnabled(level)) logger_.LogMessage(level, "" message); \
+    } while (0)
+
+#define LOG_FORMAT_AT(level, ...) \
+    do { \
+        Logger& logger_ = Logger::getInstance(); \
+        if (logger_.IsEnabled(level)) logger_.Log(level, "" __VA_ARGS__); \
+    } while (0)
+
+#define LOG_DEBUG(message) LOG_MESSAGE_AT(LogLevel::LDEBUG, message)
+#define LOG_INFO(message) LOG_MESSAGE_AT(LogLevel::LINFO, message)
+#define LOG_WARN(message) LOG_MESSAGE_AT(LogLevel::LWARN, message)
+#define LOG_ERROR(message) LOG_MESSAGE_AT(LogLevel::LERROR, message)
+
+#define LOG_DEBUG_F(...) LOG_FORMAT_AT(LogLevel::LDEBUG, __VA_ARGS__)
+#define LOG_INFO_F(...) LOG_FORMAT_AT(LogLevel::LINFO, __VA_ARGS__)
+#define LOG_WARN_F(...) LOG_FORMAT_AT(LogLevel::LWARN, __VA_ARGS__)
+#define LOG_ERROR_F(...) LOG_FORMAT_AT(LogLevel::LERROR, __VA_ARGS__)
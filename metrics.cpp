@@ -0,0 +1,92 @@
+#include "metrics.hpp"
+#include <sstream>
+
+MetricsRegistry& MetricsRegistry::getInstance() {
+    static MetricsRegistry instance;
+    return instance;
+}
+
+MetricsRegistry::Entry& MetricsRegistry::Add(const std::string& name, const std::string& help, Type type) {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.emplace_back();
+    Entry& entry = entries.back();
+    entry.name = name;
+    entry.help = help;
+    entry.type = type;
+    return entry;
+}
+
+Counter& MetricsRegistry::AddCounter(const std::string& name, const std::string& help) {
+    return Add(name, help, Type::Counter).counter;
+}
+
+Gauge& MetricsRegistry::AddGauge(const std::string& name, const std::string& help) {
+    return Add(name, help, Type::Gauge).gauge;
+}
+
+DurationSummary& MetricsRegistry::AddSummary(const std::string& name, const std::string& help) {
+    return Add(name, help, Type::Summary).summary;
+}
+
+std::string MetricsRegistry::RenderPrometheus() const {
+    std::ostringstream out;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& entry : entries) {
+        out << "# HELP " << entry.name << " " << entry.help << "\n";
+        switch (entry.type) {
+            case Type::Counter:
+                out << "# TYPE " << entry.name << " counter\n"
+                    << entry.name << " " << entry.counter.Value() << "\n";
+                break;
+            case Type::Gauge:
+                out << "# TYPE " << entry.name << " gauge\n"
+                    << entry.name << " " << entry.gauge.Value() << "\n";
+                break;
+            case Type::Summary:
+                out << "# TYPE " << entry.name << " summary\n"
+                    << entry.name << "_sum " << entry.summary.SumSeconds() << "\n"
+                    << entry.name << "_count " << entry.summary.Count() << "\n";
+                break;
+        }
+    }
+    return out.str();
+}
+
+void MetricsRegistry::ForEachSample(const std::function<void(const std::string&, double)>& callback) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& entry : entries) {
+        switch (entry.type) {
+            case Type::Counter:
+                callback(entry.name, static_cast<double>(entry.counter.Value()));
+                break;
+            case Type::Gauge:
+                callback(entry.name, entry.gauge.Value());
+                break;
+            case Type::Summary:
+                callback(entry.name + "_sum", entry.summary.SumSeconds());
+                callback(entry.name + "_count", static_cast<double>(entry.summary.Count()));
+                break;
+        }
+    }
+}
+
+PipelineMetrics::PipelineMetrics(MetricsRegistry& registry)
+    : frames_captured(registry.AddCounter("earperk_frames_captured_total", "Audio frames read from capture devices"))
+    , silent_packets(registry.AddCounter("earperk_silent_packets_total", "Capture packets flagged as silent"))
+    , discontinuities(registry.AddCounter("earperk_data_discontinuities_total", "Capture packets flagged as following a gap"))
+    , capture_gaps(registry.AddCounter("earperk_capture_gaps_total", "Gaps found from capture device positions"))
+    , frames_lost(registry.AddCounter("earperk_capture_frames_lost_total", "Frames missing across capture gaps"))
+    , queue_depth(registry.AddGauge("earperk_capture_queue_frames", "Frames waiting when the capture thread last woke"))
+    , blocks_analyzed(registry.AddCounter("earperk_blocks_analyzed_total", "Analysis blocks that ran the ear decisions"))
+    , osc_sent(registry.AddCounter("earperk_osc_messages_sent_total", "OSC messages sent"))
+    , osc_suppressed(registry.AddCounter("earperk_osc_messages_suppressed_total", "Ear perks held back by timeout_ms"))
+    , osc_failed(registry.AddCounter("earperk_osc_messages_failed_total", "OSC messages that failed to send"))
+    , reconnects(registry.AddCounter("earperk_device_reconnects_total", "Audio device reconnection attempts"))
+    , loop_time(registry.AddSummary("earperk_capture_loop_seconds", "Capture loop work per iteration, excluding the wait"))
+{
+}
+
+PipelineMetrics& PipelineMetrics::Get() {
+    static PipelineMetrics instance(MetricsRegistry::getInstance());
+    return instance;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+// Monotonic count. Add() is a single relaxed atomic increment, safe on the
+// audio thread.
+class Counter {
+public:
+    void Add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Value() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+// Last observed value of something that goes up and down
+class Gauge {
+public:
+    void Set(double v) { value.store(v, std::memory_order_relaxed); }
+    double Value() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value{0.0};
+};
+
+// Count and total of a duration, exported as a Prometheus summary
+// without quantiles
+class DurationSummary {
+public:
+    void Observe(uint64_t nanoseconds) {
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum_ns.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+    uint64_t Count() const { return count.load(std::memory_order_relaxed); }
+    double SumSeconds() const { return sum_ns.load(std::memory_order_relaxed) / 1e9; }
+
+private:
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum_ns{0};
+};
+
+// Named metrics of the process. Registration happens once at startup;
+// the metrics themselves live as long as the registry and are updated
+// without touching it.
+class MetricsRegistry {
+public:
+    static MetricsRegistry& getInstance();
+
+    Counter& AddCounter(const std::string& name, const std::string& help);
+    Gauge& AddGauge(const std::string& name, const std::string& help);
+    DurationSummary& AddSummary(const std::string& name, const std::string& help);
+
+    // Prometheus text exposition format, version 0.0.4
+    std::string RenderPrometheus() const;
+
+    // Every exported sample as (name, value), e.g. for sending over OSC
+    void ForEachSample(const std::function<void(const std::string&, double)>& callback) const;
+
+private:
+    MetricsRegistry() = default;
+
+    enum class Type { Counter, Gauge, Summary };
+    struct Entry {
+        std::string name;
+        std::string help;
+        Type type;
+        Counter counter;
+        Gauge gauge;
+        DurationSummary summary;
+    };
+
+    Entry& Add(const std::string& name, const std::string& help, Type type);
+
+    mutable std::mutex mutex;
+    std::deque<Entry> entries;  // Deque: references stay valid as it grows
+};
+
+// What the capture and detection pipeline reports
+struct PipelineMetrics {
+    Counter& frames_captured;
+    Counter& silent_packets;
+    Counter& discontinuities;
+    Counter& capture_gaps;        // Packets that arrived after lost audio
+    Counter& frames_lost;
+    Gauge& queue_depth;           // Frames waiting when the capture thread last woke
+    Counter& blocks_analyzed;
+    Counter& osc_sent;
+    Counter& osc_suppressed;      // Perks held back by timeout_ms
+    Counter& osc_failed;
+    Counter& reconnects;
+    DurationSummary& loop_time;   // Capture loop work per iteration, excluding the wait
+
+    static PipelineMetrics& Get();
+
+private:
+    explicit PipelineMetrics(MetricsRegistry& registry);
+};
@@ -0,0 +1,176 @@
+#include "metrics_server.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "oscpp/client.hpp"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+using SocketHandle = SOCKET;
+const SocketHandle kInvalidSocket = INVALID_SOCKET;
+#define CloseSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using SocketHandle = int;
+const SocketHandle kInvalidSocket = -1;
+#define CloseSocket close
+#endif
+
+namespace {
+
+// Upper bound on how long Stop() waits for the thread
+const auto kPollInterval = std::chrono::milliseconds(100);
+
+SocketHandle ToSocket(uintptr_t handle) { return static_cast<SocketHandle>(handle); }
+uintptr_t FromSocket(SocketHandle sock) { return static_cast<uintptr_t>(sock); }
+
+} // namespace
+
+MetricsServer::MetricsServer(const Options& options)
+    : options(options)
+    , listen_socket(FromSocket(kInvalidSocket))
+    , running(false)
+{
+}
+
+MetricsServer::~MetricsServer() {
+    Stop();
+}
+
+bool MetricsServer::Start() {
+    if (running) return true;
+    if (options.http_port <= 0 && options.stats_address.empty()) {
+        return false;
+    }
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        LOG_ERROR("Failed to initialize WinSock for metrics");
+        return false;
+    }
+#endif
+
+    if (options.http_port > 0) {
+        SocketHandle sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(options.http_port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // Never reachable from other machines
+        if (sock == kInvalidSocket ||
+            bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(sock, 4) != 0) {
+            LOG_ERROR_F("Failed to listen for metrics on 127.0.0.1:%d", options.http_port);
+            if (sock != kInvalidSocket) CloseSocket(sock);
+        } else {
+            listen_socket = FromSocket(sock);
+            LOG_INFO_F("Serving metrics on http://127.0.0.1:%d/metrics", options.http_port);
+        }
+    }
+
+    running = true;
+    thread = std::thread(&MetricsServer::Run, this);
+    return true;
+}
+
+void MetricsServer::Stop() {
+    if (!running.exchange(false)) return;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (ToSocket(listen_socket) != kInvalidSocket) {
+        CloseSocket(ToSocket(listen_socket));
+        listen_socket = FromSocket(kInvalidSocket);
+    }
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void MetricsServer::Run() {
+    SocketHandle stats_socket = kInvalidSocket;
+    if (!options.stats_address.empty()) {
+        stats_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        LOG_INFO_F("Sending stats over OSC to %s every %d ms", options.stats_address.c_str(),
+            static_cast<int>(options.stats_interval.count()));
+    }
+    auto next_stats = std::chrono::steady_clock::now() + options.stats_interval;
+
+    while (running) {
+        SocketHandle listener = ToSocket(listen_socket);
+        if (listener == kInvalidSocket) {
+            std::this_thread::sleep_for(kPollInterval);
+        } else {
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(listener, &readable);
+            timeval timeout = { 0, static_cast<long>(std::chrono::microseconds(kPollInterval).count()) };
+            if (select(static_cast<int>(listener) + 1, &readable, nullptr, nullptr, &timeout) > 0) {
+                SocketHandle client = accept(listener, nullptr, nullptr);
+                if (client != kInvalidSocket) {
+                    ServeClient(FromSocket(client));
+                }
+            }
+        }
+
+        if (stats_socket != kInvalidSocket && std::chrono::steady_clock::now() >= next_stats) {
+            SendStats(FromSocket(stats_socket));
+            next_stats += options.stats_interval;
+        }
+    }
+
+    if (stats_socket != kInvalidSocket) {
+        CloseSocket(stats_socket);
+    }
+}
+
+void MetricsServer::ServeClient(uintptr_t handle) {
+    SocketHandle client = ToSocket(handle);
+
+    // One short request per connection; don't let a silent client hold
+    // up the thread
+#ifdef _WIN32
+    DWORD recv_timeout = 1000;
+#else
+    timeval recv_timeout = { 1, 0 };
+#endif
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&recv_timeout), sizeof(recv_timeout));
+
+    char request[1024];
+    int received = recv(client, request, sizeof(request) - 1, 0);
+    if (received > 0) {
+        request[received] = '\0';
+        bool found = std::strncmp(request, "GET /metrics", 12) == 0 || std::strncmp(request, "GET / ", 6) == 0;
+
+        std::string body = found ? MetricsRegistry::getInstance().RenderPrometheus() : "Not found\n";
+        std::string response = std::string(found ? "HTTP/1.0 200 OK\r\n" : "HTTP/1.0 404 Not Found\r\n")
+            + "Content-Type: text/plain; version=0.0.4\r\n"
+            + "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            + "Connection: close\r\n\r\n"
+            + body;
+        send(client, response.data(), static_cast<int>(response.size()), 0);
+    }
+    CloseSocket(client);
+}
+
+void MetricsServer::SendStats(uintptr_t handle) {
+    SocketHandle sock = ToSocket(handle);
+    sockaddr_in dest = {};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(static_cast<uint16_t>(options.osc_port));
+    inet_pton(AF_INET, options.osc_host.c_str(), &dest.sin_addr);
+
+    MetricsRegistry::getInstance().ForEachSample([&](const std::string& name, double value) {
+        OSCPP::Client::MessageTemplate<'f'> message((options.stats_address + "/" + name).c_str());
+        message.float32<0>(static_cast<float>(value));
+        sendto(sock, static_cast<const char*>(message.data()), static_cast<int>(message.size()), 0,
+            reinterpret_cast<sockaddr*>(&dest), sizeof(dest));
+    });
+}
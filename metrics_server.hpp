@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Exposes the metrics registry outside the process, on its own thread:
+//  - http_port > 0: serves GET /metrics (Prometheus text) on 127.0.0.1
+//  - stats_address non-empty: sends every sample as a float OSC message
+//    to <stats_address>/<metric name> at osc_host:osc_port
+class MetricsServer {
+public:
+    struct Options {
+        int http_port = 0;
+        std::string stats_address;
+        std::chrono::milliseconds stats_interval{1000};
+        std::string osc_host;
+        int osc_port = 0;
+    };
+
+    explicit MetricsServer(const Options& options);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool Start();
+    void Stop();
+
+private:
+    void Run();
+    void ServeClient(uintptr_t client);
+    void SendStats(uintptr_t sock);
+
+    Options options;
+    uintptr_t listen_socket;
+    std::atomic<bool> running;
+    std::thread thread;
+};
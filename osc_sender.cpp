@@ -1,5 +1,7 @@
 #include "osc_sender.hpp"
 #include "logger.hpp"
+#include "metrics.hpp"
+#include "profile_zones.hpp"
 #include <stdexcept>
 #include <WinSock2.h>
 #include <WS2tcpip.h>
@@ -8,14 +10,16 @@
 OSCSender::OSCSender(Config& config)
     : address(config.address)
     , port(config.port)
-    , address_left(config.address_left)
-    , address_right(config.address_right)
-    , address_overwhelm(config.address_overwhelmingly_loud)
+    , compact_booleans(config.compact_booleans)
+    , param_left(config.address_left)
+    , param_right(config.address_right)
+    , param_overwhelm(config.address_overwhelmingly_loud)
 {
     LOG_DEBUG("OSCSender constructor called");
-    LOG_DEBUG_F("OSC target: %s:%d", address.c_str(), port);
+    LOG_DEBUG_F("OSC target: %s:%d (compact booleans: %s)", address.c_str(), port,
+        compact_booleans ? "true" : "false");
     LOG_DEBUG_F("OSC addresses - Left: %s, Right: %s, Overwhelm: %s", 
-        address_left.c_str(), address_right.c_str(), address_overwhelm.c_str());
+        param_left.as_int.address(), param_right.as_int.address(), param_overwhelm.as_int.address());
     
     // Initialize Winsock
     LOG_DEBUG("Initializing WinSock");
@@ -30,18 +34,55 @@ OSCSender::OSCSender(Config& config)
 }
 
 void OSCSender::SendLeftEar(bool value) {
-    SendOSCMessage(address_left, value);
+    SendOSCMessage(param_left, value);
 }
 
 void OSCSender::SendRightEar(bool value) {
-    SendOSCMessage(address_right, value);
+    SendOSCMessage(param_right, value);
 }
 
 void OSCSender::SendOverwhelm(bool value) {
-    SendOSCMessage(address_overwhelm, value);
+    SendOSCMessage(param_overwhelm, value);
 }
 
-void OSCSender::SendOSCMessage(const std::string& addr, bool value) {
+void OSCSender::SetRuleAddresses(const std::vector<std::string>& addresses) {
+    param_rules.clear();
+    for (const std::string& addr : addresses) {
+        param_rules.emplace_back(addr);
+    }
+}
+
+void OSCSender::SendRule(size_t index, bool value) {
+    SendOSCMessage(param_rules[index], value);
+}
+
+bool OSCSender::Reconfigure(const Config& config) {
+    bool changed = false;
+    if (config.address != address || config.port != port || config.compact_booleans != compact_booleans) {
+        address = config.address;
+        port = config.port;
+        compact_booleans = config.compact_booleans;
+        changed = true;
+    }
+
+    BoolParameter* params[] = { &param_left, &param_right, &param_overwhelm };
+    const std::string* addresses[] = { &config.address_left, &config.address_right, &config.address_overwhelmingly_loud };
+    for (size_t i = 0; i < 3; i++) {
+        if (*addresses[i] != params[i]->as_int.address()) {
+            params[i]->Reset(*addresses[i]);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        LOG_INFO_F("OSC target changed to %s:%d (compact booleans: %s)", address.c_str(), port,
+            compact_booleans ? "true" : "false");
+    }
+    return changed;
+}
+
+void OSCSender::SendOSCMessage(BoolParameter& param, bool value) {
+    PROFILE_ZONE("OSC send");
     try {
         // Create the socket
         SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
@@ -50,11 +91,21 @@ void OSCSender::SendOSCMessage(const std::string& addr, bool value) {
             throw std::runtime_error("Failed to create socket");
         }
 
-        // Create OSC packet
-        OSCPP::Client::Packet packet(buffer.data(), buffer.size());
-        packet.openMessage(addr.c_str(), 1)
-            .int32(value ? 1 : 0)
-            .closeMessage();
+        // Patch the value into the pre-serialized packet
+        const void* data;
+        size_t size;
+        {
+            PROFILE_ZONE("OSC serialize");
+            if (compact_booleans) {
+                param.as_tag.boolean<0>(value);
+                data = param.as_tag.data();
+                size = param.as_tag.size();
+            } else {
+                param.as_int.int32<0>(value ? 1 : 0);
+                data = param.as_int.data();
+                size = param.as_int.size();
+            }
+        }
 
         // Set up the address structure
         sockaddr_in destAddr;
@@ -63,18 +114,22 @@ void OSCSender::SendOSCMessage(const std::string& addr, bool value) {
         inet_pton(AF_INET, address.c_str(), &(destAddr.sin_addr));
 
         // Send the packet
-        int result = sendto(sock, buffer.data(), packet.size(), 0,
+        int result = sendto(sock, static_cast<const char*>(data),
+            static_cast<int>(size), 0,
             reinterpret_cast<sockaddr*>(&destAddr), sizeof(destAddr));
         
         if (result == SOCKET_ERROR) {
-            LOG_ERROR_F("Failed to send OSC message to %s: %d", addr.c_str(), WSAGetLastError());
+            PipelineMetrics::Get().osc_failed.Add();
+            LOG_ERROR_F("Failed to send OSC message to %s: %d", param.as_int.address(), WSAGetLastError());
         } else {
-            LOG_DEBUG_F("Sent OSC message: %s = %s", addr.c_str(), value ? "true" : "false");
+            PipelineMetrics::Get().osc_sent.Add();
+            LOG_DEBUG_F("Sent OSC message: %s = %s", param.as_int.address(), value ? "true" : "false");
         }
 
         closesocket(sock);
     }
     catch (const std::exception& e) {
+        PipelineMetrics::Get().osc_failed.Add();
         LOG_ERROR_F("Exception in SendOSCMessage: %s", e.what());
     }
 }
\ No newline at end of file
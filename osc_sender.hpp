@@ -1,6 +1,6 @@
 #pragma once
 #include <string>
-#include <array>
+#include <vector>
 #include "oscpp/client.hpp"
 #include "config.hpp"
 
@@ -18,15 +18,37 @@ public:
     void SendRightEar(bool value);
     void SendOverwhelm(bool value);
 
+    // Parameters driven by config rules, indexed like the rule set
+    void SetRuleAddresses(const std::vector<std::string>& addresses);
+    void SendRule(size_t index, bool value);
+
+    // Pick up a changed target or parameter addresses. Returns false if
+    // nothing changed. Call from the thread that sends.
+    bool Reconfigure(const Config& config);
+
 private:
-    void SendOSCMessage(const std::string& address, bool value);
+    // A boolean parameter, pre-serialized in both encodings: a single
+    // int32 argument, or an OSC 1.1 T/F tag with no argument data
+    struct BoolParameter {
+        explicit BoolParameter(const std::string& addr)
+            : as_int(addr.c_str()), as_tag(addr.c_str()) {}
+
+        void Reset(const std::string& addr) {
+            as_int.reset(addr.c_str());
+            as_tag.reset(addr.c_str());
+        }
+
+        OSCPP::Client::MessageTemplate<'i'> as_int;
+        OSCPP::Client::MessageTemplate<'F'> as_tag;
+    };
 
-    static const size_t MAX_PACKET_SIZE = 1024;
-    std::array<char, MAX_PACKET_SIZE> buffer;
+    void SendOSCMessage(BoolParameter& param, bool value);
 
     std::string address;
     int port;
-    std::string address_left;
-    std::string address_right;
-    std::string address_overwhelm;
+    bool compact_booleans;
+    BoolParameter param_left;
+    BoolParameter param_right;
+    BoolParameter param_overwhelm;
+    std::vector<BoolParameter> param_rules;
 };
\ No newline at end of file
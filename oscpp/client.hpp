@@ -34,6 +34,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <type_traits>
+#include <vector>
 
 namespace OSCPP { namespace Client {
 
@@ -251,6 +252,48 @@ public:
         return *this;
     }
 
+    Packet& int64(int64_t arg)
+    {
+        m_tags.putChar('h');
+        m_args.putInt64(arg);
+        return *this;
+    }
+
+    Packet& float64(double arg)
+    {
+        m_tags.putChar('d');
+        m_args.putFloat64(arg);
+        return *this;
+    }
+
+    //! Write OSC time tag message argument.
+    /*!
+     * \param arg 64 bit NTP time tag.
+     */
+    Packet& timeTag(uint64_t arg)
+    {
+        m_tags.putChar('t');
+        m_args.putUInt64(arg);
+        return *this;
+    }
+
+    //! Write boolean message argument.
+    /*!
+     * Booleans are encoded as the OSC 1.1 'T' and 'F' type tags and
+     * don't occupy any space in the argument data.
+     */
+    Packet& boolean(bool arg)
+    {
+        m_tags.putChar(arg ? 'T' : 'F');
+        return *this;
+    }
+
+    Packet& nil()
+    {
+        m_tags.putChar('N');
+        return *this;
+    }
+
     Packet& string(const char* arg)
     {
         m_tags.putChar('s');
@@ -273,6 +316,58 @@ public:
         return *this;
     }
 
+    //! Write blob of 32 bit integers.
+    /*!
+     * Write n integers in network byte order as a single blob argument.
+     */
+    Packet& int32Blob(const int32_t* data, size_t n)
+    {
+        putBlobSize(4 * n);
+        m_args.putInt32Array(data, n);
+        return *this;
+    }
+
+    //! Write blob of 32 bit floats.
+    /*!
+     * Write n floats in network byte order as a single blob argument.
+     */
+    Packet& float32Blob(const float* data, size_t n)
+    {
+        putBlobSize(4 * n);
+        m_args.putFloat32Array(data, n);
+        return *this;
+    }
+
+    //! Write array of 32 bit integers.
+    /*!
+     * Equivalent to putArray(data, data + n), but converts all values in
+     * a single pass.
+     *
+     * \pre openMessage must have been called with numTags including
+     * Tags::array(n).
+     */
+    Packet& int32Array(const int32_t* data, size_t n)
+    {
+        m_tags.putChar('[');
+        m_tags.putChars('i', n);
+        m_tags.putChar(']');
+        m_args.putInt32Array(data, n);
+        return *this;
+    }
+
+    //! Write array of 32 bit floats.
+    /*!
+     * \sa int32Array
+     */
+    Packet& float32Array(const float* data, size_t n)
+    {
+        m_tags.putChar('[');
+        m_tags.putChars('f', n);
+        m_tags.putChar(']');
+        m_args.putFloat32Array(data, n);
+        return *this;
+    }
+
     Packet& openArray()
     {
         m_tags.putChar('[');
@@ -310,7 +405,40 @@ public:
         return *this;
     }
 
+    Packet& putArray(const int32_t* begin, const int32_t* end)
+    {
+        return int32Array(begin, end - begin);
+    }
+
+    Packet& putArray(const float* begin, const float* end)
+    {
+        return float32Array(begin, end - begin);
+    }
+
+    // Non-const pointers would otherwise be an exact match for the
+    // InputIterator template and take the per-element path
+    Packet& putArray(int32_t* begin, int32_t* end)
+    {
+        return int32Array(begin, end - begin);
+    }
+
+    Packet& putArray(float* begin, float* end)
+    {
+        return float32Array(begin, end - begin);
+    }
+
 private:
+    void putBlobSize(size_t size)
+    {
+        if (size > (size_t)std::numeric_limits<int32_t>::max())
+        {
+            throw std::invalid_argument("Blob size greater than maximum "
+                                        "value representable by int32_t");
+        }
+        m_tags.putChar('b');
+        m_args.putInt32(static_cast<int32_t>(size));
+    }
+
     void*       m_buffer;
     size_t      m_capacity;
     WriteStream m_args;     // packet stream
@@ -328,6 +456,18 @@ template <> inline Packet& Packet::put<float>(float x)
 {
     return float32(x);
 }
+template <> inline Packet& Packet::put<int64_t>(int64_t x)
+{
+    return int64(x);
+}
+template <> inline Packet& Packet::put<double>(double x)
+{
+    return float64(x);
+}
+template <> inline Packet& Packet::put<bool>(bool x)
+{
+    return boolean(x);
+}
 template <> inline Packet& Packet::put<const char*>(const char* x)
 {
     return string(x);
@@ -363,6 +503,175 @@ public:
     }
 };
 
+namespace detail {
+
+//! Payload size of a fixed-size argument type tag.
+constexpr size_t fixedArgSize(char tag)
+{
+    return (tag == 'i' || tag == 'f')
+               ? 4
+               : (tag == 'h' || tag == 'd' || tag == 't') ? 8 : 0;
+}
+
+constexpr bool isFixedArgTag(char tag)
+{
+    return fixedArgSize(tag) > 0 || tag == 'T' || tag == 'F' || tag == 'N';
+}
+
+} // namespace detail
+
+//! Pre-serialized OSC message.
+/*!
+ * Serializes the address and type tag string once on construction so
+ * that sending the same message repeatedly only needs to patch the
+ * argument payload in place. The type tags are fixed at compile time,
+ * e.g. MessageTemplate<'i'> for a message with a single int32 argument.
+ *
+ * Only fixed-size argument types are supported. A 'T' or 'F' tag
+ * declares a boolean slot whose value is patched into the tag string.
+ */
+template <char... Tags> class MessageTemplate
+{
+    static_assert(sizeof...(Tags) > 0, "MessageTemplate needs arguments");
+    static_assert((detail::isFixedArgTag(Tags) && ...),
+                  "MessageTemplate only supports fixed-size arguments");
+
+    static constexpr char kTags[] = {Tags...};
+
+    static constexpr size_t argOffset(size_t index)
+    {
+        size_t offset = 0;
+        for (size_t i = 0; i < index; i++)
+            offset += detail::fixedArgSize(kTags[i]);
+        return offset;
+    }
+
+public:
+    static constexpr size_t kNumArgs = sizeof...(Tags);
+    static constexpr size_t kTagsSize = align(kNumArgs + 2);
+    static constexpr size_t kArgsSize = argOffset(kNumArgs);
+
+    MessageTemplate()
+    : m_argsOffset(0)
+    {}
+
+    explicit MessageTemplate(const char* address)
+    {
+        reset(address);
+    }
+
+    //! Serialize address and type tags into the cached buffer.
+    void reset(const char* address)
+    {
+        const size_t addrLen = std::strlen(address);
+        const size_t addrSize = Size::string(addrLen);
+        m_argsOffset = addrSize + kTagsSize;
+        // Zero fill takes care of string terminators and padding.
+        m_buffer.assign(m_argsOffset + kArgsSize, 0);
+        std::memcpy(m_buffer.data(), address, addrLen);
+        char* tags = m_buffer.data() + addrSize;
+        tags[0] = ',';
+        std::memcpy(tags + 1, kTags, kNumArgs);
+    }
+
+    const char* address() const
+    {
+        return m_buffer.data();
+    }
+
+    const void* data() const
+    {
+        return m_buffer.data();
+    }
+
+    size_t size() const
+    {
+        return m_buffer.size();
+    }
+
+    //! Patch an int32 argument.
+    template <size_t I> MessageTemplate& int32(int32_t arg)
+    {
+        static_assert(I < kNumArgs && kTags[I] == 'i',
+                      "Argument is not an int32");
+        uint32_t uh;
+        std::memcpy(&uh, &arg, 4);
+        patch32(argOffset(I), uh);
+        return *this;
+    }
+
+    //! Patch a float32 argument.
+    template <size_t I> MessageTemplate& float32(float arg)
+    {
+        static_assert(I < kNumArgs && kTags[I] == 'f',
+                      "Argument is not a float32");
+        uint32_t uh;
+        std::memcpy(&uh, &arg, 4);
+        patch32(argOffset(I), uh);
+        return *this;
+    }
+
+    //! Patch an int64 argument.
+    template <size_t I> MessageTemplate& int64(int64_t arg)
+    {
+        static_assert(I < kNumArgs && kTags[I] == 'h',
+                      "Argument is not an int64");
+        uint64_t uh;
+        std::memcpy(&uh, &arg, 8);
+        patch64(argOffset(I), uh);
+        return *this;
+    }
+
+    //! Patch a float64 argument.
+    template <size_t I> MessageTemplate& float64(double arg)
+    {
+        static_assert(I < kNumArgs && kTags[I] == 'd',
+                      "Argument is not a float64");
+        uint64_t uh;
+        std::memcpy(&uh, &arg, 8);
+        patch64(argOffset(I), uh);
+        return *this;
+    }
+
+    //! Patch a time tag argument.
+    template <size_t I> MessageTemplate& timeTag(uint64_t arg)
+    {
+        static_assert(I < kNumArgs && kTags[I] == 't',
+                      "Argument is not a time tag");
+        patch64(argOffset(I), arg);
+        return *this;
+    }
+
+    //! Patch a boolean argument by rewriting its type tag.
+    template <size_t I> MessageTemplate& boolean(bool arg)
+    {
+        static_assert(I < kNumArgs && (kTags[I] == 'T' || kTags[I] == 'F'),
+                      "Argument is not a boolean");
+        assert(!m_buffer.empty());
+        // Skip the leading ',' of the tag string
+        m_buffer[m_argsOffset - kTagsSize + 1 + I] = arg ? 'T' : 'F';
+        return *this;
+    }
+
+private:
+    void patch32(size_t offset, uint32_t uh)
+    {
+        assert(!m_buffer.empty());
+        const uint32_t un = convert32<NetworkByteOrder>(uh);
+        std::memcpy(m_buffer.data() + m_argsOffset + offset, &un, 4);
+    }
+
+    void patch64(size_t offset, uint64_t uh)
+    {
+        assert(!m_buffer.empty());
+        const uint64_t un = convert64<NetworkByteOrder>(uh);
+        std::memcpy(m_buffer.data() + m_argsOffset + offset, &un, 8);
+    }
+
+    std::vector<char> m_buffer;
+    size_t            m_argsOffset; // start of argument payload
+};
+
 }} // namespace OSCPP::Client
 
 #endif // OSCPP_CLIENT_HPP_INCLUDED
@@ -27,9 +27,30 @@
 
 #include <oscpp/detail/endian.hpp>
 
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <stdexcept>
 
+// SIMD byte shuffles for bulk conversion
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define OSCPP_HAVE_AVX2
+#    define OSCPP_HAVE_SSSE3
+#    define OSCPP_HAVE_SSE2
+#elif defined(__SSSE3__)
+#    include <tmmintrin.h>
+#    define OSCPP_HAVE_SSSE3
+#    define OSCPP_HAVE_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define OSCPP_HAVE_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#    include <arm_neon.h>
+#    define OSCPP_HAVE_NEON
+#endif
+
 namespace OSCPP {
 #if defined(__GNUC__)
 inline static uint32_t bswap32(uint32_t x)
@@ -70,6 +91,67 @@ inline static uint64_t bswap64(int64_t x)
 }
 #endif
 
+//! Byte swap n consecutive 32 bit words from src to dst.
+/*!
+ * Neither pointer needs to be aligned. src and dst may be identical but
+ * must not otherwise overlap.
+ */
+inline void bswap32(void* dst, const void* src, size_t n)
+{
+    const char*  s = static_cast<const char*>(src);
+    char*        d = static_cast<char*>(dst);
+    const size_t bytes = 4 * n;
+    size_t       i = 0; // byte offset
+#if defined(OSCPP_HAVE_AVX2)
+    const __m256i mask256 = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7,
+        6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 32 <= bytes; i += 32)
+    {
+        const __m256i x =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i),
+                            _mm256_shuffle_epi8(x, mask256));
+    }
+#endif
+#if defined(OSCPP_HAVE_SSSE3)
+    const __m128i mask128 =
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 16 <= bytes; i += 16)
+    {
+        const __m128i x =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i),
+                         _mm_shuffle_epi8(x, mask128));
+    }
+#elif defined(OSCPP_HAVE_SSE2)
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i x =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        // Swap bytes within 16 bit halves, then swap the halves
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+        x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), x);
+    }
+#elif defined(OSCPP_HAVE_NEON)
+    for (; i + 16 <= bytes; i += 16)
+    {
+        const uint8x16_t x =
+            vld1q_u8(reinterpret_cast<const uint8_t*>(s + i));
+        vst1q_u8(reinterpret_cast<uint8_t*>(d + i), vrev32q_u8(x));
+    }
+#endif
+    for (; i < bytes; i += 4)
+    {
+        uint32_t x;
+        std::memcpy(&x, s + i, 4);
+        x = bswap32(x);
+        std::memcpy(d + i, &x, 4);
+    }
+}
+
 enum ByteOrder
 {
     NetworkByteOrder,
@@ -113,6 +195,34 @@ template <> inline uint64_t convert64<HostByteOrder>(uint64_t x)
 {
     return x;
 }
+
+//! Convert n consecutive 32 bit words from src to dst.
+/*!
+ * Bulk version of convert32 with the same aliasing rules as the bulk
+ * bswap32.
+ */
+template <ByteOrder B>
+inline void convertArray32(void* dst, const void* src, size_t n);
+
+template <>
+inline void convertArray32<NetworkByteOrder>(void* dst, const void* src,
+                                             size_t n)
+{
+#if defined(OSCPP_LITTLE_ENDIAN)
+    bswap32(dst, src, n);
+#else
+    if (dst != src)
+        std::memcpy(dst, src, 4 * n);
+#endif
+}
+
+template <>
+inline void convertArray32<HostByteOrder>(void* dst, const void* src,
+                                          size_t n)
+{
+    if (dst != src)
+        std::memcpy(dst, src, 4 * n);
+}
 } // namespace OSCPP
 
 #endif // OSCPP_HOST_HPP_INCLUDED
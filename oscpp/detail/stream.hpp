@@ -60,10 +60,11 @@ public:
 
     Stream(const Stream& stream, size_t size)
     {
+        // Check before forming the end pointer, size may be bogus
+        if (size > stream.consumable())
+            throw UnderrunError();
         m_begin = m_pos = stream.m_pos;
         m_end = m_begin + size;
-        if (m_end > stream.m_end)
-            throw UnderrunError();
     }
 
     void reset()
@@ -184,6 +185,13 @@ public:
         advance(1);
     }
 
+    void putChars(char c, size_t n)
+    {
+        checkWritable(n);
+        std::memset(m_pos, c, n);
+        advance(n);
+    }
+
     void putInt32(int32_t x)
     {
         checkWritable(4);
@@ -203,6 +211,17 @@ public:
         advance(8);
     }
 
+    void putInt64(int64_t x)
+    {
+        checkWritable(8);
+        checkAlignment(4);
+        uint64_t uh;
+        std::memcpy(&uh, &x, 8);
+        const uint64_t un = convert64<B>(uh);
+        std::memcpy(pos(), &un, 8);
+        advance(8);
+    }
+
     void putFloat32(float f)
     {
         checkWritable(4);
@@ -214,6 +233,23 @@ public:
         advance(4);
     }
 
+    void putInt32Array(const int32_t* x, size_t n)
+    {
+        checkWritable(4 * n);
+        checkAlignment(4);
+        convertArray32<B>(pos(), x, n);
+        advance(4 * n);
+    }
+
+    void putFloat32Array(const float* f, size_t n)
+    {
+        static_assert(sizeof(float) == 4, "float must be 32 bit");
+        checkWritable(4 * n);
+        checkAlignment(4);
+        convertArray32<B>(pos(), f, n);
+        advance(4 * n);
+    }
+
     void putFloat64(double f)
     {
         checkWritable(8);
@@ -321,6 +357,20 @@ public:
         return convert64<B>(un);
     }
 
+    // throw (UnderrunError)
+    inline int64_t getInt64()
+    {
+        checkReadable(8);
+        checkAlignment(4);
+        uint64_t un;
+        std::memcpy(&un, pos(), 8);
+        advance(8);
+        const uint64_t uh = convert64<B>(un);
+        int64_t        x;
+        std::memcpy(&x, &uh, 8);
+        return x;
+    }
+
     // throw (UnderrunError)
     inline float getFloat32()
     {
@@ -371,6 +421,83 @@ public:
 
         return x;
     }
+
+    // Unchecked accessors.
+    //
+    // These perform no bounds or alignment checks and never throw. They
+    // may only be used on data whose structure has been verified
+    // beforehand, e.g. with OSCPP::Server::validate().
+
+    void skipUnchecked(size_t n) noexcept
+    {
+        advance(n);
+    }
+
+    char peekCharUnchecked() const noexcept
+    {
+        return *pos();
+    }
+
+    char getCharUnchecked() noexcept
+    {
+        const char x = *pos();
+        advance(1);
+        return x;
+    }
+
+    int32_t getInt32Unchecked() noexcept
+    {
+        uint32_t un;
+        std::memcpy(&un, pos(), 4);
+        advance(4);
+        const uint32_t uh = convert32<B>(un);
+        int32_t        x;
+        std::memcpy(&x, &uh, 4);
+        return x;
+    }
+
+    int64_t getInt64Unchecked() noexcept
+    {
+        const uint64_t uh = getUInt64Unchecked();
+        int64_t        x;
+        std::memcpy(&x, &uh, 8);
+        return x;
+    }
+
+    uint64_t getUInt64Unchecked() noexcept
+    {
+        uint64_t un;
+        std::memcpy(&un, pos(), 8);
+        advance(8);
+        return convert64<B>(un);
+    }
+
+    float getFloat32Unchecked() noexcept
+    {
+        uint32_t un;
+        std::memcpy(&un, pos(), 4);
+        advance(4);
+        const uint32_t uh = convert32<B>(un);
+        float          f;
+        std::memcpy(&f, &uh, 4);
+        return f;
+    }
+
+    double getFloat64Unchecked() noexcept
+    {
+        const uint64_t uh = getUInt64Unchecked();
+        double         f;
+        std::memcpy(&f, &uh, 8);
+        return f;
+    }
+
+    const char* getStringUnchecked() noexcept
+    {
+        // Validated strings are zero padded after the first terminator
+        const char* x = pos();
+        advance(align(std::strlen(x) + 1));
+        return x;
+    }
 };
 
 typedef BasicReadStream<NetworkByteOrder> ReadStream;
@@ -88,6 +88,24 @@ inline void printArgs(std::ostream& out, Server::ArgStream args)
             case 'b':
                 out << "b:" << args.blob().size();
                 break;
+            case 'h':
+                out << "h:" << args.int64();
+                break;
+            case 'd':
+                out << "d:" << args.float64();
+                break;
+            case 't':
+                out << "t:" << args.timeTag();
+                break;
+            case 'T':
+            case 'F':
+                out << t;
+                args.drop();
+                break;
+            case 'N':
+                out << "N";
+                args.drop();
+                break;
             case '[':
                 out << "[ ";
                 printArgs(out, args.array());
@@ -44,7 +44,13 @@ namespace OSCPP { namespace Server {
  *  i       -- 32 bit signed integer number<br>
  *  f       -- 32 bit floating point number<br>
  *  s       -- NULL-terminated string padded to 4-byte boundary<br>
- *  b       -- 32-bit integer size followed by 4-byte aligned data
+ *  b       -- 32-bit integer size followed by 4-byte aligned data<br>
+ *  h       -- 64 bit signed integer number<br>
+ *  d       -- 64 bit floating point number<br>
+ *  t       -- 64 bit NTP time tag<br>
+ *  T, F    -- boolean true/false, no argument data<br>
+ *  N       -- nil, no argument data<br>
+ *  [ ]     -- array delimiters
  *
  * \sa getArgInt32
  * \sa getArgFloat32
@@ -145,6 +151,87 @@ public:
         throw ParseError("Cannot convert argument to float");
     }
 
+    //! Get next 64 bit integer argument.
+    /*!
+     * Read next integer argument from the input stream and convert it
+     * to a 64 bit integer.
+     *
+     * \exception OSCPP::UnderrunError stream buffer underrun.
+     * \exception OSCPP::ParseError argument could not be converted.
+     */
+    int64_t int64()
+    {
+        const char t = m_tags.getChar();
+        if (t == 'h')
+            return m_args.getInt64();
+        if (t == 'i')
+            return m_args.getInt32();
+        throw ParseError("Cannot convert argument to int64");
+    }
+
+    //! Get next double argument.
+    /*!
+     * Read next numerical argument from the input stream and convert it
+     * to a double.
+     *
+     * \exception OSCPP::UnderrunError stream buffer underrun.
+     * \exception OSCPP::ParseError argument could not be converted.
+     */
+    double float64()
+    {
+        const char t = m_tags.getChar();
+        if (t == 'd')
+            return m_args.getFloat64();
+        if (t == 'f')
+            return m_args.getFloat32();
+        if (t == 'i')
+            return m_args.getInt32();
+        throw ParseError("Cannot convert argument to double");
+    }
+
+    //! Get next time tag argument.
+    /*!
+     * \exception OSCPP::UnderrunError stream buffer underrun.
+     * \exception OSCPP::ParseError argument is not a time tag.
+     */
+    uint64_t timeTag()
+    {
+        if (m_tags.getChar() == 't')
+            return m_args.getUInt64();
+        throw ParseError("Cannot convert argument to time tag");
+    }
+
+    //! Get next boolean argument.
+    /*!
+     * Accepts the OSC 1.1 'T' and 'F' tags as well as int32 arguments,
+     * which are interpreted as true when non-zero.
+     *
+     * \exception OSCPP::UnderrunError stream buffer underrun.
+     * \exception OSCPP::ParseError argument could not be converted.
+     */
+    bool boolean()
+    {
+        const char t = m_tags.getChar();
+        if (t == 'T')
+            return true;
+        if (t == 'F')
+            return false;
+        if (t == 'i')
+            return m_args.getInt32() != 0;
+        throw ParseError("Cannot convert argument to bool");
+    }
+
+    //! Consume next nil argument.
+    /*!
+     * \exception OSCPP::UnderrunError stream buffer underrun.
+     * \exception OSCPP::ParseError argument is not nil.
+     */
+    void nil()
+    {
+        if (m_tags.getChar() != 'N')
+            throw ParseError("Expected nil");
+    }
+
     //! Get next string argument.
     /*!
      * Read next string argument and return it as a NULL-terminated
@@ -232,6 +319,11 @@ private:
             case 'f':
                 m_args.skip(4);
                 break;
+            case 'h':
+            case 'd':
+            case 't':
+                m_args.skip(8);
+                break;
             case 's':
                 m_args.getString();
                 break;
@@ -422,11 +514,17 @@ public:
         return m_stream.atEnd();
     }
 
+    // throw (UnderrunError, ParseError)
     Packet next()
     {
-        size_t     size = m_stream.getInt32();
-        ReadStream stream(m_stream, size);
-        m_stream.skip(size);
+        const int32_t size = m_stream.getInt32();
+        if (size < 0)
+            throw ParseError("Invalid bundle element size is less than zero");
+        // Elements must keep the stream aligned for the following reads
+        if (!isAligned(static_cast<size_t>(size)))
+            throw ParseError("Bundle element size is not a multiple of 4");
+        ReadStream stream(m_stream, static_cast<size_t>(size));
+        m_stream.skip(static_cast<size_t>(size));
         return Packet(stream);
     }
 
@@ -444,6 +542,21 @@ template <> inline float ArgStream::next<float>()
     return float32();
 }
 
+template <> inline int64_t ArgStream::next<int64_t>()
+{
+    return int64();
+}
+
+template <> inline double ArgStream::next<double>()
+{
+    return float64();
+}
+
+template <> inline bool ArgStream::next<bool>()
+{
+    return boolean();
+}
+
 template <> inline const char* ArgStream::next<const char*>()
 {
     return string();
@@ -464,6 +577,505 @@ PacketStream Bundle::packets() const
     return PacketStream(m_stream);
 }
 
+//! Structural packet validation.
+/*!
+ * Walks a complete packet, including nested bundles and all message
+ * arguments, checking every size, string terminator and type tag
+ * against the packet bounds. Never throws.
+ */
+class Validator
+{
+public:
+    static const size_t kMaxBundleDepth = 16;
+
+    static bool packet(const char* begin, const char* end,
+                       size_t depth = 0) noexcept
+    {
+        const size_t size = end - begin;
+        if (!isAligned(size))
+            return false;
+        if (Packet::isBundle(begin, size))
+            return bundle(begin, end, depth);
+        if (Packet::isMessage(begin, size))
+            return message(begin, end);
+        return false;
+    }
+
+private:
+    static bool string(const char*& pos, const char* end) noexcept
+    {
+        // Require zero padding up to the word boundary, so that the
+        // first terminator also ends the string for ReadStream::getString
+        const void* nul = std::memchr(pos, '\0', end - pos);
+        if (nul == nullptr)
+            return false;
+        const size_t n = align(static_cast<const char*>(nul) - pos + 1);
+        if (static_cast<size_t>(end - pos) < n || pos[n - 1] != '\0')
+            return false;
+        pos += n;
+        return true;
+    }
+
+    static bool int32(const char*& pos, const char* end, int32_t& x) noexcept
+    {
+        if (end - pos < 4)
+            return false;
+        uint32_t un;
+        std::memcpy(&un, pos, 4);
+        const uint32_t uh = convert32<NetworkByteOrder>(un);
+        std::memcpy(&x, &uh, 4);
+        pos += 4;
+        return true;
+    }
+
+    static bool skip(const char*& pos, const char* end, size_t n) noexcept
+    {
+        if (static_cast<size_t>(end - pos) < n)
+            return false;
+        pos += n;
+        return true;
+    }
+
+    static bool message(const char* begin, const char* end) noexcept
+    {
+        const char* pos = begin;
+        if (!string(pos, end))
+            return false;
+        const char* tags = pos;
+        if (tags >= end || *tags != ',' || !string(pos, end))
+            return false;
+        size_t arrayLevel = 0;
+        for (const char* t = tags + 1; *t != '\0'; t++)
+        {
+            switch (*t)
+            {
+                case 'i':
+                case 'f':
+                    if (!skip(pos, end, 4))
+                        return false;
+                    break;
+                case 'h':
+                case 'd':
+                case 't':
+                    if (!skip(pos, end, 8))
+                        return false;
+                    break;
+                case 's':
+                    if (!string(pos, end))
+                        return false;
+                    break;
+                case 'b':
+                {
+                    int32_t size;
+                    if (!int32(pos, end, size) || size < 0 ||
+                        !skip(pos, end, align(static_cast<size_t>(size))))
+                        return false;
+                    break;
+                }
+                case 'T':
+                case 'F':
+                case 'N':
+                    break;
+                case '[':
+                    arrayLevel++;
+                    break;
+                case ']':
+                    if (arrayLevel == 0)
+                        return false;
+                    arrayLevel--;
+                    break;
+                default:
+                    // Unknown argument size, can't be skipped safely
+                    return false;
+            }
+        }
+        return arrayLevel == 0;
+    }
+
+    static bool bundle(const char* begin, const char* end,
+                       size_t depth) noexcept
+    {
+        if (depth >= kMaxBundleDepth)
+            return false;
+        // #bundle header and time tag
+        const char* pos = begin + 16;
+        while (pos < end)
+        {
+            int32_t size;
+            if (!int32(pos, end, size) || size < 0 ||
+                !isAligned(static_cast<size_t>(size)) ||
+                static_cast<size_t>(end - pos) < static_cast<size_t>(size))
+                return false;
+            if (!packet(pos, pos + size, depth + 1))
+                return false;
+            pos += size;
+        }
+        return true;
+    }
+};
+
+//! Validate packet structure.
+/*!
+ * Return true if data points to a well-formed, 4-byte aligned OSC
+ * packet whose elements and arguments all lie within [data, data+size).
+ * Only packets that pass validation may be read with the Unchecked API.
+ * Never throws.
+ */
+inline bool validate(const void* data, size_t size) noexcept
+{
+    const char* begin = static_cast<const char*>(data);
+    return isAligned(data, kAlignment) &&
+           Validator::packet(begin, begin + size);
+}
+
+//! Exception-free access to validated packets.
+/*!
+ * Mirrors the checked Packet/Message/Bundle/ArgStream API without any
+ * bounds checks. Reading a packet that has not passed validate() is
+ * undefined behaviour.
+ *
+ * Arguments whose type tag can't be converted to the requested type are
+ * skipped and a default value is returned; check tag() first where the
+ * distinction matters.
+ */
+namespace Unchecked {
+
+class ArgStream
+{
+public:
+    ArgStream() = default;
+
+    ArgStream(const ReadStream& tags, const ReadStream& args) noexcept
+    : m_tags(tags)
+    , m_args(args)
+    {}
+
+    //* Construct from a stream pointing to a type tag string.
+    explicit ArgStream(const ReadStream& stream) noexcept
+    : m_args(stream)
+    {
+        const char* tags = m_args.getStringUnchecked();
+        m_tags = ReadStream(tags + 1, std::strlen(tags) - 1);
+    }
+
+    size_t size() const noexcept
+    {
+        return m_tags.capacity();
+    }
+
+    bool atEnd() const noexcept
+    {
+        return m_tags.atEnd();
+    }
+
+    char tag() const noexcept
+    {
+        return m_tags.peekCharUnchecked();
+    }
+
+    void drop() noexcept
+    {
+        drop(m_tags.getCharUnchecked());
+    }
+
+    int32_t int32() noexcept
+    {
+        const char t = m_tags.getCharUnchecked();
+        if (t == 'i')
+            return m_args.getInt32Unchecked();
+        if (t == 'f')
+            return (int32_t)m_args.getFloat32Unchecked();
+        drop(t);
+        return 0;
+    }
+
+    float float32() noexcept
+    {
+        const char t = m_tags.getCharUnchecked();
+        if (t == 'f')
+            return m_args.getFloat32Unchecked();
+        if (t == 'i')
+            return (float)m_args.getInt32Unchecked();
+        drop(t);
+        return 0.f;
+    }
+
+    int64_t int64() noexcept
+    {
+        const char t = m_tags.getCharUnchecked();
+        if (t == 'h')
+            return m_args.getInt64Unchecked();
+        if (t == 'i')
+            return m_args.getInt32Unchecked();
+        drop(t);
+        return 0;
+    }
+
+    double float64() noexcept
+    {
+        const char t = m_tags.getCharUnchecked();
+        if (t == 'd')
+            return m_args.getFloat64Unchecked();
+        if (t == 'f')
+            return m_args.getFloat32Unchecked();
+        if (t == 'i')
+            return m_args.getInt32Unchecked();
+        drop(t);
+        return 0.;
+    }
+
+    uint64_t timeTag() noexcept
+    {
+        const char t = m_tags.getCharUnchecked();
+        if (t == 't')
+            return m_args.getUInt64Unchecked();
+        drop(t);
+        return 0;
+    }
+
+    bool boolean() noexcept
+    {
+        const char t = m_tags.getCharUnchecked();
+        if (t == 'T')
+            return true;
+        if (t == 'i')
+            return m_args.getInt32Unchecked() != 0;
+        drop(t);
+        return false;
+    }
+
+    //* Returns an empty string on type mismatch.
+    const char* string() noexcept
+    {
+        const char t = m_tags.getCharUnchecked();
+        if (t == 's')
+            return m_args.getStringUnchecked();
+        drop(t);
+        return "";
+    }
+
+    Blob blob() noexcept
+    {
+        const char t = m_tags.getCharUnchecked();
+        if (t == 'b')
+            return parseBlob();
+        drop(t);
+        return Blob();
+    }
+
+    //* Returns an empty stream on type mismatch.
+    ArgStream array() noexcept
+    {
+        const char t = m_tags.getCharUnchecked();
+        if (t == '[')
+        {
+            const char* tags = m_tags.pos();
+            const char* args = m_args.pos();
+            dropArray();
+            return ArgStream(ReadStream(tags, m_tags.pos() - tags - 1),
+                             ReadStream(args, m_args.pos() - args));
+        }
+        drop(t);
+        return ArgStream();
+    }
+
+private:
+    Blob parseBlob() noexcept
+    {
+        const size_t size = static_cast<size_t>(m_args.getInt32Unchecked());
+        const void*  data = m_args.pos();
+        m_args.skipUnchecked(align(size));
+        return Blob(data, size);
+    }
+
+    void dropAtom(char t) noexcept
+    {
+        switch (t)
+        {
+            case 'i':
+            case 'f':
+                m_args.skipUnchecked(4);
+                break;
+            case 'h':
+            case 'd':
+            case 't':
+                m_args.skipUnchecked(8);
+                break;
+            case 's':
+                m_args.getStringUnchecked();
+                break;
+            case 'b':
+                parseBlob();
+                break;
+        }
+    }
+
+    void dropArray() noexcept
+    {
+        unsigned int level = 0;
+        for (;;)
+        {
+            const char t = m_tags.getCharUnchecked();
+            if (t == ']')
+            {
+                if (level == 0)
+                    break;
+                level--;
+            }
+            else if (t == '[')
+            {
+                level++;
+            }
+            else
+            {
+                dropAtom(t);
+            }
+        }
+    }
+
+    void drop(char t) noexcept
+    {
+        if (t == '[')
+            dropArray();
+        else
+            dropAtom(t);
+    }
+
+    ReadStream m_tags;
+    ReadStream m_args;
+};
+
+class Message
+{
+public:
+    Message(const char* address, const ReadStream& stream) noexcept
+    : m_address(address)
+    , m_args(stream)
+    {}
+
+    const char* address() const noexcept
+    {
+        return m_address;
+    }
+
+    ArgStream args() const noexcept
+    {
+        return m_args;
+    }
+
+private:
+    const char* m_address;
+    ArgStream   m_args;
+};
+
+class PacketStream;
+
+class Bundle
+{
+public:
+    Bundle(uint64_t time, const ReadStream& stream) noexcept
+    : m_time(time)
+    , m_stream(stream)
+    {}
+
+    uint64_t time() const noexcept
+    {
+        return m_time;
+    }
+
+    inline PacketStream packets() const noexcept;
+
+private:
+    uint64_t   m_time;
+    ReadStream m_stream;
+};
+
+class Packet
+{
+public:
+    Packet() noexcept
+    : m_isBundle(false)
+    {}
+
+    //* Construct from a packet that has passed validate().
+    Packet(const void* data, size_t size) noexcept
+    : m_stream(data, size)
+    , m_isBundle(Server::Packet::isBundle(data, size))
+    {}
+
+    const void* data() const noexcept
+    {
+        return m_stream.begin();
+    }
+
+    size_t size() const noexcept
+    {
+        return m_stream.capacity();
+    }
+
+    bool isBundle() const noexcept
+    {
+        return m_isBundle;
+    }
+
+    bool isMessage() const noexcept
+    {
+        return !m_isBundle;
+    }
+
+    //* Precondition: isBundle()
+    Bundle bundle() const noexcept
+    {
+        ReadStream stream(m_stream);
+        stream.skipUnchecked(8); // #bundle
+        const uint64_t time = stream.getUInt64Unchecked();
+        return Bundle(time, stream);
+    }
+
+    //* Precondition: isMessage()
+    Message message() const noexcept
+    {
+        ReadStream  stream(m_stream);
+        const char* address = stream.getStringUnchecked();
+        return Message(address, stream);
+    }
+
+private:
+    ReadStream m_stream;
+    bool       m_isBundle;
+};
+
+class PacketStream
+{
+public:
+    explicit PacketStream(const ReadStream& stream) noexcept
+    : m_stream(stream)
+    {}
+
+    bool atEnd() const noexcept
+    {
+        return m_stream.atEnd();
+    }
+
+    Packet next() noexcept
+    {
+        const size_t size = static_cast<size_t>(m_stream.getInt32Unchecked());
+        const char*  data = m_stream.pos();
+        m_stream.skipUnchecked(size);
+        return Packet(data, size);
+    }
+
+private:
+    ReadStream m_stream;
+};
+
+PacketStream Bundle::packets() const noexcept
+{
+    return PacketStream(m_stream);
+}
+
+} // namespace Unchecked
+
 }} // namespace OSCPP::Server
 
 static inline bool operator==(const OSCPP::Server::Message& msg,
@@ -78,6 +78,26 @@ constexpr size_t blob()
 {
     return 1;
 }
+constexpr size_t int64()
+{
+    return 1;
+}
+constexpr size_t float64()
+{
+    return 1;
+}
+constexpr size_t timeTag()
+{
+    return 1;
+}
+constexpr size_t boolean()
+{
+    return 1;
+}
+constexpr size_t nil()
+{
+    return 1;
+}
 constexpr size_t array(size_t numElems)
 {
     return numElems + 2;
@@ -144,6 +164,27 @@ constexpr size_t float64(size_t n = 1)
     return n * 8;
 }
 
+constexpr size_t int64(size_t n = 1)
+{
+    return n * 8;
+}
+
+constexpr size_t timeTag(size_t n = 1)
+{
+    return n * 8;
+}
+
+// Boolean and nil arguments are carried in the type tag alone.
+constexpr size_t boolean(size_t = 1)
+{
+    return 0;
+}
+
+constexpr size_t nil(size_t = 1)
+{
+    return 0;
+}
+
 constexpr size_t string(size_t n)
 {
     return align(n + 1);
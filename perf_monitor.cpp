@@ -0,0 +1,97 @@
+#include "perf_monitor.hpp"
+#include "metrics.hpp"
+#include <algorithm>
+#include <thread>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+
+namespace {
+
+// User plus kernel time of the whole process
+double ProcessCpuSeconds() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user)) {
+        return -1.0;
+    }
+    auto ticks = [](const FILETIME& t) {
+        return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime;
+    };
+    return (ticks(kernel) + ticks(user)) / 1e7;  // 100 ns units
+#else
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+#endif
+}
+
+float Micros(PerfMonitor::Clock::duration d) {
+    return std::chrono::duration<float, std::micro>(d).count();
+}
+
+} // namespace
+
+PerfMonitor& PerfMonitor::Get() {
+    static PerfMonitor instance;
+    return instance;
+}
+
+void PerfMonitor::ObserveLoop(Clock::duration work, Clock::time_point now) {
+    if (!Enabled()) {
+        audio_active = false;
+        return;
+    }
+    PipelineMetrics& metrics = PipelineMetrics::Get();
+    if (!audio_active) {
+        // Don't flush a bucket that started before the overlay was opened
+        audio_active = true;
+        bucket_start = now;
+        loop_peak = block_peak = queue_peak = 0.0f;
+        osc_sent_at_start = metrics.osc_sent.Value();
+    }
+
+    loop_peak = std::max(loop_peak, Micros(work));
+    queue_peak = std::max(queue_peak, static_cast<float>(metrics.queue_depth.Value()));
+
+    Clock::duration elapsed = now - bucket_start;
+    if (elapsed < kAudioBucket) {
+        return;
+    }
+    uint64_t osc_sent = metrics.osc_sent.Value();
+    loop_us.Push(loop_peak);
+    block_us.Push(block_peak);
+    queue_frames.Push(queue_peak);
+    osc_per_s.Push(static_cast<float>((osc_sent - osc_sent_at_start) / std::chrono::duration<double>(elapsed).count()));
+
+    bucket_start = now;
+    loop_peak = block_peak = queue_peak = 0.0f;
+    osc_sent_at_start = osc_sent;
+}
+
+void PerfMonitor::ObserveBlock(Clock::duration work) {
+    if (audio_active) {
+        block_peak = std::max(block_peak, Micros(work));
+    }
+}
+
+void PerfMonitor::ObserveFrame(Clock::duration work, Clock::time_point now) {
+    if (!Enabled()) {
+        cpu_seconds_at_sample = -1.0;
+        return;
+    }
+    frame_ms.Push(Micros(work) / 1000.0f);
+
+    if (cpu_seconds_at_sample >= 0.0 && now - cpu_sample_time < kCpuInterval) {
+        return;
+    }
+    double cpu_seconds = ProcessCpuSeconds();
+    if (cpu_seconds_at_sample >= 0.0 && cpu_seconds >= 0.0) {
+        double wall = std::chrono::duration<double>(now - cpu_sample_time).count();
+        unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        cpu_percent.Push(static_cast<float>(100.0 * (cpu_seconds - cpu_seconds_at_sample) / (wall * cores)));
+    }
+    cpu_sample_time = now;
+    cpu_seconds_at_sample = cpu_seconds;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Recent history of one value for plotting. One thread pushes, any thread
+// copies; nothing allocates after construction. A copy racing a push may
+// show the newest sample in place of the oldest, which a plot can live with.
+class PerfRing {
+public:
+    static constexpr size_t kCapacity = 240;
+
+    PerfRing() {
+        for (auto& value : values) {
+            value.store(0.0f, std::memory_order_relaxed);
+        }
+    }
+
+    void Push(float value) {
+        uint64_t n = written.load(std::memory_order_relaxed);
+        values[n % kCapacity].store(value, std::memory_order_relaxed);
+        written.store(n + 1, std::memory_order_release);
+    }
+
+    // Oldest first into out[kCapacity]; returns how many were copied
+    size_t Copy(float* out) const {
+        uint64_t n = written.load(std::memory_order_acquire);
+        size_t count = n < kCapacity ? static_cast<size_t>(n) : kCapacity;
+        for (size_t i = 0; i < count; i++) {
+            out[i] = values[(n - count + i) % kCapacity].load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+private:
+    std::array<std::atomic<float>, kCapacity> values;
+    std::atomic<uint64_t> written{0};
+};
+
+// Timing history for the performance overlay. The audio thread and the UI
+// thread each feed their own series; audio-side values are folded into
+// kAudioBucket-long peaks so a fast capture loop still covers several
+// seconds. Does nothing until enabled.
+class PerfMonitor {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr Clock::duration kAudioBucket = std::chrono::milliseconds(50);
+    static constexpr Clock::duration kCpuInterval = std::chrono::milliseconds(250);
+
+    static PerfMonitor& Get();
+
+    void SetEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+    bool Enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Audio thread: one capture loop iteration's work (excluding the wait),
+    // and one analysis block's detection and OSC sends
+    void ObserveLoop(Clock::duration work, Clock::time_point now);
+    void ObserveBlock(Clock::duration work);
+
+    // UI thread: one rendered frame; also samples process CPU
+    void ObserveFrame(Clock::duration work, Clock::time_point now);
+
+    PerfRing loop_us;        // Peak per bucket
+    PerfRing block_us;       // Peak per bucket
+    PerfRing queue_frames;   // Peak capture queue depth per bucket
+    PerfRing osc_per_s;      // OSC messages sent, averaged over the bucket
+    PerfRing frame_ms;       // Every frame
+    PerfRing cpu_percent;    // Whole process, of all cores
+
+private:
+    PerfMonitor() = default;
+
+    std::atomic<bool> enabled{false};
+
+    // Audio thread
+    bool audio_active = false;
+    Clock::time_point bucket_start;
+    float loop_peak = 0.0f;
+    float block_peak = 0.0f;
+    float queue_peak = 0.0f;
+    uint64_t osc_sent_at_start = 0;
+
+    // UI thread
+    Clock::time_point cpu_sample_time;
+    double cpu_seconds_at_sample = -1.0;
+};
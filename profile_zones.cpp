@@ -0,0 +1,153 @@
+#include "profile_zones.hpp"
+
+#ifdef EARPERK_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace profiling {
+
+namespace {
+
+struct ZoneRecord {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> end_ns{0};
+};
+
+// One per thread that ever recorded a zone. Kept after the thread exits
+// so its zones still show up in the export.
+struct ThreadZones {
+    explicit ThreadZones(unsigned id) : id(id), zones(kZonesPerThread) {}
+
+    const unsigned id;
+    std::atomic<const char*> name{nullptr};
+    // begun is bumped before a slot is overwritten and written after, so
+    // an export can tell which of the slots it copied were torn
+    std::atomic<uint64_t> begun{0};
+    std::atomic<uint64_t> written{0};
+    std::vector<ZoneRecord> zones;
+};
+
+std::mutex registry_mutex;
+std::vector<std::unique_ptr<ThreadZones>> registry;
+
+thread_local ThreadZones* current = nullptr;
+
+ThreadZones& Current() {
+    if (!current) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(std::make_unique<ThreadZones>(static_cast<unsigned>(registry.size() + 1)));
+        current = registry.back().get();
+    }
+    return *current;
+}
+
+void WriteJsonString(FILE* file, const char* text) {
+    fputc('"', file);
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+struct CopiedZone {
+    const char* name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+} // namespace
+
+uint64_t NowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void RecordZone(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    ThreadZones& thread = Current();
+    uint64_t n = thread.written.load(std::memory_order_relaxed);
+    thread.begun.store(n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    ZoneRecord& zone = thread.zones[n % kZonesPerThread];
+    zone.name.store(name, std::memory_order_relaxed);
+    zone.start_ns.store(start_ns, std::memory_order_relaxed);
+    zone.end_ns.store(end_ns, std::memory_order_relaxed);
+    thread.written.store(n + 1, std::memory_order_release);
+}
+
+void SetThreadName(const char* name) {
+    Current().name.store(name, std::memory_order_relaxed);
+}
+
+bool WriteChromeTrace(const std::string& path, std::string* error) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        *error = "can't create " + path;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    std::vector<CopiedZone> copied;
+    copied.reserve(kZonesPerThread);
+    bool first = true;
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+    for (const auto& thread : registry) {
+        const char* name = thread->name.load(std::memory_order_relaxed);
+        char fallback[32];
+        if (!name) {
+            snprintf(fallback, sizeof(fallback), "Thread %u", thread->id);
+            name = fallback;
+        }
+        fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+            first ? "" : ",\n", thread->id);
+        WriteJsonString(file, name);
+        fputs("}}", file);
+        first = false;
+
+        // Copy first, then drop whatever the thread overwrote meanwhile
+        uint64_t written = thread->written.load(std::memory_order_acquire);
+        uint64_t oldest = written > kZonesPerThread ? written - kZonesPerThread : 0;
+        copied.clear();
+        for (uint64_t i = oldest; i < written; i++) {
+            const ZoneRecord& zone = thread->zones[i % kZonesPerThread];
+            copied.push_back({ zone.name.load(std::memory_order_relaxed),
+                zone.start_ns.load(std::memory_order_relaxed),
+                zone.end_ns.load(std::memory_order_relaxed) });
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t begun = thread->begun.load(std::memory_order_relaxed);
+
+        for (uint64_t i = oldest; i < written; i++) {
+            if (i + kZonesPerThread < begun) {
+                continue;
+            }
+            const CopiedZone& zone = copied[i - oldest];
+            fputs(",\n{\"ph\":\"X\",\"name\":", file);
+            WriteJsonString(file, zone.name);
+            fprintf(file, ",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", thread->id,
+                zone.start_ns / 1000.0, (zone.end_ns - zone.start_ns) / 1000.0);
+        }
+    }
+    fputs("\n]}\n", file);
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0 || !ok) {
+        *error = "failed writing " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace profiling
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+// Scoped timing zones for looking at a real session in a trace viewer
+// (ui.perfetto.dev or chrome://tracing). Only compiled in when
+// EARPERK_PROFILE is defined; otherwise the macros expand to nothing and
+// the functions below don't exist.
+//
+//   void Decode() {
+//       PROFILE_ZONE("Decode");
+//       ...
+//   }
+//
+// Every thread records into its own ring of its most recent zones, so a
+// zone costs two clock reads and a few stores, with no locking.
+// WriteChromeTrace() exports whatever the rings hold at that moment.
+
+#ifdef EARPERK_PROFILE
+
+#include <cstdint>
+#include <string>
+
+namespace profiling {
+
+// Zones kept per thread; older ones are overwritten
+const size_t kZonesPerThread = 16384;
+
+uint64_t NowNs();
+
+// Name must be a string literal, it is kept by pointer
+void RecordZone(const char* name, uint64_t start_ns, uint64_t end_ns);
+void SetThreadName(const char* name);
+
+// Chrome trace event JSON, which Perfetto opens as is. Safe while zones
+// are being recorded.
+bool WriteChromeTrace(const std::string& path, std::string* error);
+
+class Zone {
+public:
+    explicit Zone(const char* name) : name(name), start_ns(NowNs()) {}
+    ~Zone() { RecordZone(name, start_ns, NowNs()); }
+
+    Zone(const Zone&) = delete;
+    Zone& operator=(const Zone&) = delete;
+
+private:
+    const char* name;
+    uint64_t start_ns;
+};
+
+} // namespace profiling
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// "" name only accepts literals
+#define PROFILE_ZONE(name) ::profiling::Zone PROFILE_CONCAT(profile_zone_, __LINE__)("" name)
+#define PROFILE_THREAD(name) ::profiling::SetThreadName("" name)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+
+#endif
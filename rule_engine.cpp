@@ -0,0 +1,469 @@
+#include "rule_engine.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+
+const int kDefaultCooldownMs = 100;
+const int kDefaultHoldMs = 1000;
+
+struct NamedInput {
+    const char* name;
+    RuleInput input;
+};
+
+const NamedInput kInputs[] = {
+    { "left", InputLeft },
+    { "right", InputRight },
+    { "volume_threshold", InputVolumeThreshold },
+    { "excessive_threshold", InputExcessiveThreshold },
+    { "differential_threshold", InputDifferentialThreshold },
+    { "left_perked", InputLeftPerked },
+    { "right_perked", InputRightPerked },
+    { "overwhelmed", InputOverwhelmed },
+};
+
+enum class TokenType { Word, Number, Symbol, End };
+
+struct Token {
+    TokenType type;
+    std::string text;
+    float number;
+};
+
+// Words, numbers and operators; anything else is an error
+bool Tokenize(const std::string& text, std::vector<Token>* tokens, std::string* error) {
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (std::isspace(c)) {
+            i++;
+        } else if (std::isalpha(c) || c == '_') {
+            size_t start = i;
+            while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_')) i++;
+            tokens->push_back({ TokenType::Word, text.substr(start, i - start), 0.0f });
+        } else if (std::isdigit(c) || c == '.') {
+            char* end = nullptr;
+            float number = std::strtof(text.c_str() + i, &end);
+            size_t length = static_cast<size_t>(end - (text.c_str() + i));
+            if (length == 0) {
+                *error = "bad number at '" + text.substr(i) + "'";
+                return false;
+            }
+            tokens->push_back({ TokenType::Number, text.substr(i, length), number });
+            i += length;
+        } else {
+            static const char* symbols[] = { ">=", "<=", "&&", "||", ">", "<", "+", "-", "*", "/", "(", ")", ",", "!" };
+            bool matched = false;
+            for (const char* symbol : symbols) {
+                size_t length = std::char_traits<char>::length(symbol);
+                if (text.compare(i, length, symbol) == 0) {
+                    tokens->push_back({ TokenType::Symbol, symbol, 0.0f });
+                    i += length;
+                    matched = true;
+                    break;
+                }
+            }
+            if (!matched) {
+                *error = std::string("unexpected '") + text[i] + "'";
+                return false;
+            }
+        }
+    }
+    tokens->push_back({ TokenType::End, "", 0.0f });
+    return true;
+}
+
+} // namespace
+
+// Recursive descent over one condition. Lowest precedence first:
+//   or, and, not, comparison, + -, * /, unary -, operand
+// Each parsed value is a register; operations on numbers alone are folded
+// into a new number instead of emitting an instruction.
+class RuleCompiler {
+public:
+    using Op = RuleSet::Op;
+
+    RuleCompiler(const std::vector<Token>& tokens, size_t position, RuleSet* set)
+        : tokens(tokens), position(position), set(set) {}
+
+    bool Compile(uint16_t* result, std::string* error) {
+        bool ok = ParseOr();
+        if (ok && set->registers.size() > UINT16_MAX) {
+            ok = Fail("too many rules");
+        }
+        if (!ok) {
+            *error = this->error;
+            return false;
+        }
+        *result = operands.back().reg;
+        return true;
+    }
+
+    size_t Position() const { return position; }
+
+private:
+    struct Operand {
+        uint16_t reg;
+        bool constant;
+    };
+
+    const Token& Peek() const { return tokens[position]; }
+
+    bool Accept(const char* text) {
+        const Token& token = Peek();
+        if (token.type != TokenType::End && token.type != TokenType::Number && token.text == text) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    bool Expect(const char* text) {
+        if (Accept(text)) return true;
+        return Fail(std::string("expected '") + text + "'");
+    }
+
+    bool Fail(const std::string& message) {
+        if (error.empty()) {
+            const Token& token = Peek();
+            error = message + (token.type == TokenType::End ? " at the end" : " at '" + token.text + "'");
+        }
+        return false;
+    }
+
+    Operand Pop() {
+        Operand operand = operands.back();
+        operands.pop_back();
+        return operand;
+    }
+
+    void PushConstant(float value) {
+        operands.push_back({ static_cast<uint16_t>(set->registers.size()), true });
+        set->registers.push_back(value);
+    }
+
+    void Emit(Op op, Operand a, Operand b) {
+        uint16_t dst = static_cast<uint16_t>(set->registers.size());
+        set->registers.push_back(0.0f);
+        set->code.push_back({ op, dst, a.reg, b.reg });
+        operands.push_back({ dst, false });
+    }
+
+    void EmitInput(RuleInput input) {
+        operands.push_back({ static_cast<uint16_t>(input), false });
+    }
+
+    void EmitUnary(Op op) {
+        Operand a = Pop();
+        if (a.constant) {
+            set->registers[a.reg] = ApplyUnary(op, set->registers[a.reg]);
+            operands.push_back(a);
+        } else {
+            Emit(op, a, a);
+        }
+    }
+
+    void EmitBinary(Op op) {
+        Operand b = Pop();
+        Operand a = Pop();
+        if (a.constant && b.constant) {
+            set->registers[a.reg] = ApplyBinary(op, set->registers[a.reg], set->registers[b.reg]);
+            operands.push_back(a);
+        } else {
+            Emit(op, a, b);
+        }
+    }
+
+    static float ApplyUnary(Op op, float a) {
+        switch (op) {
+            case Op::Neg: return -a;
+            case Op::Abs: return std::abs(a);
+            default: return static_cast<float>(a == 0.0f);
+        }
+    }
+
+    static float ApplyBinary(Op op, float a, float b) {
+        switch (op) {
+            case Op::Add: return a + b;
+            case Op::Sub: return a - b;
+            case Op::Mul: return a * b;
+            case Op::Div: return a / b;
+            case Op::Min: return std::min(a, b);
+            case Op::Max: return std::max(a, b);
+            case Op::Greater: return static_cast<float>(a > b);
+            case Op::GreaterEqual: return static_cast<float>(a >= b);
+            case Op::Less: return static_cast<float>(a < b);
+            case Op::LessEqual: return static_cast<float>(a <= b);
+            case Op::And: return static_cast<float>((a != 0.0f) & (b != 0.0f));
+            default: return static_cast<float>((a != 0.0f) | (b != 0.0f));
+        }
+    }
+
+    bool ParseOr() {
+        if (++nesting > RuleSet::kMaxNesting) return Fail("condition is nested too deeply");
+        if (!ParseAnd()) return false;
+        while (Accept("or") || Accept("||")) {
+            if (!ParseAnd()) return false;
+            EmitBinary(Op::Or);
+        }
+        nesting--;
+        return true;
+    }
+
+    bool ParseAnd() {
+        if (!ParseNot()) return false;
+        while (Accept("and") || Accept("&&")) {
+            if (!ParseNot()) return false;
+            EmitBinary(Op::And);
+        }
+        return true;
+    }
+
+    bool ParseNot() {
+        if (Accept("not") || Accept("!")) {
+            if (!ParseNot()) return false;
+            EmitUnary(Op::Not);
+            return true;
+        }
+        return ParseComparison();
+    }
+
+    bool ParseComparison() {
+        if (!ParseSum()) return false;
+        static const struct { const char* text; Op op; } comparisons[] = {
+            { ">=", Op::GreaterEqual }, { "<=", Op::LessEqual }, { ">", Op::Greater }, { "<", Op::Less },
+        };
+        for (const auto& comparison : comparisons) {
+            if (Accept(comparison.text)) {
+                if (!ParseSum()) return false;
+                EmitBinary(comparison.op);
+                return true;
+            }
+        }
+        return true;
+    }
+
+    bool ParseSum() {
+        if (!ParseProduct()) return false;
+        while (true) {
+            Op op;
+            if (Accept("+")) op = Op::Add;
+            else if (Accept("-")) op = Op::Sub;
+            else return true;
+            if (!ParseProduct()) return false;
+            EmitBinary(op);
+        }
+    }
+
+    bool ParseProduct() {
+        if (!ParseUnary()) return false;
+        while (true) {
+            Op op;
+            if (Accept("*")) op = Op::Mul;
+            else if (Accept("/")) op = Op::Div;
+            else return true;
+            if (!ParseUnary()) return false;
+            EmitBinary(op);
+        }
+    }
+
+    bool ParseUnary() {
+        if (Accept("-")) {
+            if (!ParseUnary()) return false;
+            EmitUnary(Op::Neg);
+            return true;
+        }
+        return ParseOperand();
+    }
+
+    bool ParseOperand() {
+        const Token& token = Peek();
+        if (token.type == TokenType::Number) {
+            position++;
+            PushConstant(token.number);
+            return true;
+        }
+        if (Accept("(")) {
+            return ParseOr() && Expect(")");
+        }
+        if (token.type != TokenType::Word) {
+            return Fail("expected a value");
+        }
+
+        std::string name = token.text;
+        position++;
+        if (name == "abs") {
+            if (!Expect("(") || !ParseOr() || !Expect(")")) return false;
+            EmitUnary(Op::Abs);
+            return true;
+        }
+        if (name == "min" || name == "max") {
+            if (!Expect("(") || !ParseOr() || !Expect(",") || !ParseOr() || !Expect(")")) return false;
+            EmitBinary(name == "min" ? Op::Min : Op::Max);
+            return true;
+        }
+        for (const auto& input : kInputs) {
+            if (name == input.name) {
+                EmitInput(input.input);
+                return true;
+            }
+        }
+        position--;
+        return Fail("unknown name");
+    }
+
+    const std::vector<Token>& tokens;
+    size_t position;
+    RuleSet* set;
+    std::vector<Operand> operands;
+    int nesting = 0;
+    std::string error;
+};
+
+RuleSet RuleSet::Compile(const std::vector<std::string>& texts, std::vector<std::string>* errors) {
+    RuleSet set;
+    for (size_t n = 0; n < texts.size(); n++) {
+        const std::string& text = texts[n];
+        auto report = [&](const std::string& message) {
+            errors->push_back("rule" + std::to_string(n + 1) + ": " + message);
+        };
+
+        // "<address> if <condition> [cooldown <ms>] [hold <ms>]"
+        size_t start = text.find_first_not_of(" \t");
+        size_t address_end = text.find_first_of(" \t", start);
+        if (start == std::string::npos || text[start] != '/' || address_end == std::string::npos) {
+            report("expected '/address if condition'");
+            continue;
+        }
+        Rule rule;
+        rule.address = text.substr(start, address_end - start);
+
+        std::vector<Token> tokens;
+        std::string error;
+        if (!Tokenize(text.substr(address_end), &tokens, &error)) {
+            report(error);
+            continue;
+        }
+        if (tokens[0].type != TokenType::Word || tokens[0].text != "if") {
+            report("expected 'if' after the address");
+            continue;
+        }
+
+        size_t code_size = set.code.size();
+        size_t register_count = set.registers.size();
+        RuleCompiler compiler(tokens, 1, &set);
+        if (!compiler.Compile(&rule.result, &error)) {
+            set.code.resize(code_size);
+            set.registers.resize(register_count);
+            report(error);
+            continue;
+        }
+
+        int cooldown_ms = kDefaultCooldownMs;
+        int hold_ms = kDefaultHoldMs;
+        size_t position = compiler.Position();
+        bool ok = true;
+        while (ok && tokens[position].type != TokenType::End) {
+            const Token& option = tokens[position];
+            const Token& value = tokens[position + 1];
+            bool is_option = option.type == TokenType::Word && (option.text == "cooldown" || option.text == "hold");
+            if (!is_option || value.type != TokenType::Number || value.number < 0.0f) {
+                report("expected 'cooldown <ms>' or 'hold <ms>' at '" + option.text + "'");
+                ok = false;
+                break;
+            }
+            (option.text == "cooldown" ? cooldown_ms : hold_ms) = static_cast<int>(value.number);
+            position += 2;
+        }
+        if (!ok) {
+            set.code.resize(code_size);
+            set.registers.resize(register_count);
+            continue;
+        }
+
+        rule.cooldown_ms = cooldown_ms;
+        rule.hold_ms = hold_ms;
+        set.rules.push_back(rule);
+    }
+    set.Schedule();
+
+    // Frame timings follow once SetSampleRate() knows the rate. Starting
+    // far past the last trigger lets a rule fire on its first block.
+    set.timing = HysteresisBank(set.rules.size());
+    set.timing.Advance(UINT32_MAX);
+    set.request.resize(set.rules.size());
+    set.events.resize(set.rules.size());
+    return set;
+}
+
+void RuleSet::SetSampleRate(unsigned rate) {
+    if (rate == sample_rate) {
+        return;
+    }
+    sample_rate = rate;
+    for (size_t i = 0; i < rules.size(); i++) {
+        HysteresisBank::Timing rule_timing;
+        rule_timing.cooldown = HysteresisBank::MsToFrames(rules[i].cooldown_ms, rate);
+        rule_timing.hold = HysteresisBank::MsToFrames(rules[i].hold_ms, rate);
+        timing.SetTiming(i, rule_timing);
+    }
+}
+
+void RuleSet::Schedule() {
+    // An instruction's level is one more than the deepest instruction it
+    // reads from; inputs and numbers are level 0. Sorting by level, then
+    // op, keeps every read after its write and makes runs of one op.
+    std::vector<uint16_t> register_level(registers.size(), 0);
+    std::vector<std::pair<uint32_t, Instruction>> leveled;
+    leveled.reserve(code.size());
+    for (const Instruction& in : code) {
+        uint16_t level = static_cast<uint16_t>(std::max(register_level[in.a], register_level[in.b]) + 1);
+        register_level[in.dst] = level;
+        leveled.push_back({ (static_cast<uint32_t>(level) << 8) | static_cast<uint32_t>(in.op), in });
+    }
+    std::stable_sort(leveled.begin(), leveled.end(),
+        [](const auto& x, const auto& y) { return x.first < y.first; });
+
+    code.clear();
+    batches.clear();
+    for (size_t i = 0; i < leveled.size(); i++) {
+        if (i == 0 || leveled[i].first != leveled[i - 1].first) {
+            batches.push_back({ leveled[i].second.op, static_cast<uint32_t>(i), static_cast<uint32_t>(i) });
+        }
+        code.push_back(leveled[i].second);
+        batches.back().end++;
+    }
+}
+
+void RuleSet::Evaluate() {
+    float* regs = registers.data();
+    for (const Batch& batch : batches) {
+        const Instruction* begin = code.data() + batch.begin;
+        const Instruction* end = code.data() + batch.end;
+        auto each = [&](auto op) {
+            for (const Instruction* in = begin; in != end; ++in) {
+                regs[in->dst] = op(regs[in->a], regs[in->b]);
+            }
+        };
+        switch (batch.op) {
+            case Op::Neg: each([](float a, float) { return -a; }); break;
+            case Op::Abs: each([](float a, float) { return std::abs(a); }); break;
+            case Op::Not: each([](float a, float) { return static_cast<float>(a == 0.0f); }); break;
+            case Op::Add: each([](float a, float b) { return a + b; }); break;
+            case Op::Sub: each([](float a, float b) { return a - b; }); break;
+            case Op::Mul: each([](float a, float b) { return a * b; }); break;
+            case Op::Div: each([](float a, float b) { return a / b; }); break;
+            case Op::Min: each([](float a, float b) { return std::min(a, b); }); break;
+            case Op::Max: each([](float a, float b) { return std::max(a, b); }); break;
+            case Op::Greater: each([](float a, float b) { return static_cast<float>(a > b); }); break;
+            case Op::GreaterEqual: each([](float a, float b) { return static_cast<float>(a >= b); }); break;
+            case Op::Less: each([](float a, float b) { return static_cast<float>(a < b); }); break;
+            case Op::LessEqual: each([](float a, float b) { return static_cast<float>(a <= b); }); break;
+            case Op::And: each([](float a, float b) { return static_cast<float>((a != 0.0f) & (b != 0.0f)); }); break;
+            case Op::Or: each([](float a, float b) { return static_cast<float>((a != 0.0f) | (b != 0.0f)); }); break;
+        }
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "hysteresis.hpp"
+
+// Extra OSC booleans defined in config.ini instead of code. Each rule is
+// one line of the [rules] section:
+//
+//   rule1=/avatar/parameters/TailWag if left > 0.3 and left - right > 0.1 cooldown 500 hold 1000
+//
+// The parameter is sent true when the condition holds and the last true
+// was more than `cooldown` ms ago, and false once `hold` ms passed without
+// a new true - the same timing the ears use with timeout_ms and
+// reset_timeout_ms. Left out, they are 100 and 1000 ms. Like the ears,
+// the timing runs on a HysteresisBank counting audio frames.
+//
+// Conditions use the inputs below, numbers, + - * /, comparisons
+// (> >= < <=), and/or/not, abs(x), min(a, b), max(a, b) and parentheses.
+// Every rule is compiled at load time into a few three-address
+// instructions over one flat array of registers. Instructions from all
+// rules are then grouped into batches of the same operation, ordered so
+// each batch only reads results of earlier ones, and a block runs the
+// batches in one pass: a dispatch per batch rather than per instruction,
+// no parsing and no allocation.
+
+// What a condition can refer to, as of the block being evaluated
+enum RuleInput : uint8_t {
+    InputLeft,                   // left: merged left level
+    InputRight,                  // right
+    InputVolumeThreshold,        // volume_threshold, including auto adjustment
+    InputExcessiveThreshold,     // excessive_threshold
+    InputDifferentialThreshold,  // differential_threshold
+    InputLeftPerked,             // left_perked: 1 or 0 after this block's ear decisions
+    InputRightPerked,            // right_perked
+    InputOverwhelmed,            // overwhelmed
+    kRuleInputCount
+};
+
+class RuleSet {
+public:
+    // Deepest a condition may nest in parentheses
+    static const int kMaxNesting = 32;
+
+    RuleSet() = default;
+
+    // Rules that fail to parse are left out; each adds a line to errors
+    static RuleSet Compile(const std::vector<std::string>& rules, std::vector<std::string>* errors);
+
+    size_t Size() const { return rules.size(); }
+    const std::string& Address(size_t index) const { return rules[index].address; }
+    bool IsOn(size_t index) const { return timing.IsOn(index); }
+
+    // Millisecond settings are converted at this rate; cheap to call for
+    // every block
+    void SetSampleRate(unsigned rate);
+
+    // Evaluates every rule for one block, `frames` after the previous one,
+    // and calls send(index, value) for each parameter to send, in rule order
+    template <typename Send>
+    void Process(const float (&inputs)[kRuleInputCount], uint32_t frames, Send&& send) {
+        std::copy(inputs, inputs + kRuleInputCount, registers.begin());
+        Evaluate();
+        timing.Advance(frames);
+        for (size_t i = 0; i < rules.size(); i++) {
+            request[i] = registers[rules[i].result] != 0.0f;
+        }
+        timing.Step(0, rules.size(), request.data(), events.data());
+        for (size_t i = 0; i < rules.size(); i++) {
+            if (events[i] & HysteresisFired) send(i, true);
+            if (events[i] & HysteresisReleased) send(i, false);
+        }
+    }
+
+private:
+    enum class Op : uint8_t {
+        Neg, Abs, Not,
+        Add, Sub, Mul, Div, Min, Max,
+        Greater, GreaterEqual, Less, LessEqual,
+        And, Or
+    };
+
+    // registers[dst] = registers[a] op registers[b]; unary ops ignore b.
+    // Registers hold the inputs, then constants and intermediate results,
+    // each written by exactly one instruction. Booleans are 1.0 / 0.0.
+    struct Instruction {
+        Op op;
+        uint16_t dst;
+        uint16_t a;
+        uint16_t b;
+    };
+
+    // Instructions [begin, end) of code, all with the same op
+    struct Batch {
+        Op op;
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    struct Rule {
+        std::string address;
+        uint16_t result = 0;  // Register holding the condition
+        int cooldown_ms = 0;
+        int hold_ms = 0;
+    };
+
+    friend class RuleCompiler;
+
+    void Schedule();
+    void Evaluate();
+
+    std::vector<Instruction> code;
+    std::vector<Batch> batches;
+    std::vector<float> registers = std::vector<float>(kRuleInputCount);
+    std::vector<Rule> rules;
+
+    // One parameter per rule
+    HysteresisBank timing = HysteresisBank(0);
+    unsigned sample_rate = 0;
+    std::vector<uint8_t> request;
+    std::vector<uint8_t> events;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer, multi-reader sequence lock for small trivially copyable
+// values. The writer never waits; readers retry if they overlap a write.
+// The payload is stored as relaxed atomic words so concurrent access is
+// well defined, and the sequence counter doubles as a version number.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock requires a trivially copyable type");
+
+public:
+    SeqLock() : sequence(0) {
+        for (auto& word : words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    explicit SeqLock(const T& value) : SeqLock() {
+        Store(value);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Publish a new value. Must only be called from one thread.
+    void Store(const T& value) {
+        uint64_t buffer[kWords] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+
+        const uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);  // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; i++) {
+            words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Read a consistent copy of the latest value
+    T Load(uint32_t* version = nullptr) const {
+        uint64_t buffer[kWords];
+        uint32_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; i++) {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        if (version) *version = before;
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+    // Changes on every Store(); cheap to poll for updates
+    uint32_t Version() const {
+        return sequence.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // Own cache line so publishing doesn't disturb neighbouring members
+    alignas(64) std::atomic<uint32_t> sequence;
+    std::atomic<uint64_t> words[kWords];
+};
@@ -0,0 +1,109 @@
+#include "source_pipeline.hpp"
+#include "profile_zones.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const auto kIdleTimeout = std::chrono::milliseconds(100);
+
+size_t MsToFrames(int ms, unsigned sample_rate) {
+    return std::max<size_t>(1, static_cast<size_t>(std::max(ms, 0)) * sample_rate / 1000);
+}
+
+} // namespace
+
+SourcePipeline::SourcePipeline(unsigned sample_rate, int window_ms, int hop_ms, const LevelSettings& level,
+                               float weight, BlockCallback on_block)
+    : sample_rate(sample_rate)
+    , framer(MsToFrames(window_ms, sample_rate), MsToFrames(hop_ms, sample_rate))
+    , level_detector(level.detector)
+    , envelope(level.detector == LevelDetector::Peak ? EnvelopeFollower::Mode::Peak : EnvelopeFollower::Mode::Rms,
+               level.attack_ms, level.release_ms, sample_rate)
+    , hop_duration(framer.Hop() * 1000000 / std::max(1u, sample_rate))
+    , weight(weight)
+    , max_gap_fill(std::max(1u, sample_rate))
+    , on_block(std::move(on_block))
+    , left_level(0.0f)
+    , right_level(0.0f)
+    , block_count(0)
+    , last_packet_time(std::chrono::steady_clock::now())
+    , last_silence_time(last_packet_time)
+{
+}
+
+void SourcePipeline::OnFrames(const float* left, const float* right, size_t frames) {
+    last_packet_time = std::chrono::steady_clock::now();
+    framer.Push(left, right, frames, [this](const float* l, const float* r, size_t n) {
+        OnBlock(l, r, n);
+    });
+}
+
+void SourcePipeline::OnSilence(size_t frames) {
+    last_packet_time = std::chrono::steady_clock::now();
+    framer.PushSilence(frames, [this](const float* l, const float* r, size_t n) {
+        OnBlock(l, r, n);
+    });
+}
+
+void SourcePipeline::OnGap(uint64_t frames_lost) {
+    gaps.gaps++;
+    gaps.frames_lost += frames_lost;
+
+    // Stand in silence for what was lost so the blocks after the gap
+    // stay where they belong in time
+    size_t fill = static_cast<size_t>(std::min<uint64_t>(frames_lost, max_gap_fill));
+    if (fill > 0) {
+        framer.PushSilence(fill, [this](const float* l, const float* r, size_t n) {
+            OnBlock(l, r, n);
+        });
+    }
+}
+
+SourcePipeline::GapCount SourcePipeline::TakeGaps() {
+    GapCount taken = gaps;
+    gaps = GapCount();
+    return taken;
+}
+
+void SourcePipeline::FeedIdle(std::chrono::steady_clock::time_point now) {
+    if (now - last_packet_time < kIdleTimeout) {
+        last_silence_time = now;
+        return;
+    }
+    // Catch up in whole hops; the loop may have slept through several
+    while (now - last_silence_time >= hop_duration) {
+        framer.PushSilence(framer.Hop(), [this](const float* l, const float* r, size_t n) {
+            OnBlock(l, r, n);
+        });
+        last_silence_time += hop_duration;
+    }
+}
+
+void SourcePipeline::OnBlock(const float* left, const float* right, size_t frames) {
+    {
+        PROFILE_ZONE("Block levels");
+        if (level_detector == LevelDetector::Average) {
+            float left_sum = 0.0f;
+            float right_sum = 0.0f;
+            for (size_t i = 0; i < frames; i++) {
+                left_sum += std::abs(left[i]);
+                right_sum += std::abs(right[i]);
+            }
+            left_level = left_sum / frames;
+            right_level = right_sum / frames;
+        } else {
+            // Blocks overlap; the envelope only takes the frames it hasn't
+            // seen, which is all of the first block and the last hop after
+            size_t fresh = block_count == 0 ? frames : std::min(frames, framer.Hop());
+            envelope.Process(left + frames - fresh, right + frames - fresh, fresh);
+            left_level = envelope.Left();
+            right_level = envelope.Right();
+        }
+    }
+    block_count++;
+
+    if (on_block) {
+        on_block();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "block_framer.hpp"
+#include "capture_source.hpp"
+#include "config.hpp"
+#include "envelope_follower.hpp"
+
+// Feature extraction for one capture source: frames its audio into
+// analysis blocks and keeps the level at the end of the latest block,
+// either the block's average or an envelope that runs over every sample.
+// on_block runs on the capture thread after every block.
+class SourcePipeline : public PacketSink {
+public:
+    using BlockCallback = std::function<void()>;
+
+    SourcePipeline(unsigned sample_rate, int window_ms, int hop_ms, const LevelSettings& level,
+                   float weight, BlockCallback on_block);
+
+    void OnFrames(const float* left, const float* right, size_t frames) override;
+    void OnSilence(size_t frames) override;
+    void OnGap(uint64_t frames_lost) override;
+
+    // Loopback streams deliver no packets while nothing is playing. Once
+    // that has lasted a while, keep the blocks coming as silence.
+    void FeedIdle(std::chrono::steady_clock::time_point now);
+
+    float LeftLevel() const { return left_level; }
+    float RightLevel() const { return right_level; }
+    float Weight() const { return weight; }
+    unsigned SampleRate() const { return sample_rate; }
+    size_t WindowFrames() const { return framer.Window(); }
+    size_t HopFrames() const { return framer.Hop(); }
+
+    // Blocks produced so far; a warm standby is ready once this moves
+    uint64_t BlockCount() const { return block_count; }
+
+    // Swap the callback when a standby becomes the active source. Call
+    // from the thread that feeds the pipeline.
+    void SetBlockCallback(BlockCallback callback) { on_block = std::move(callback); }
+
+    // Gaps seen since the last call; call from the thread that feeds
+    // the pipeline
+    struct GapCount {
+        uint64_t gaps = 0;
+        uint64_t frames_lost = 0;
+    };
+    GapCount TakeGaps();
+
+private:
+    void OnBlock(const float* left, const float* right, size_t frames);
+
+    unsigned sample_rate;
+    BlockFramer framer;
+    LevelDetector level_detector;
+    EnvelopeFollower envelope;  // Unused for LevelDetector::Average
+    std::chrono::microseconds hop_duration;
+    float weight;
+    size_t max_gap_fill;  // Longer gaps are a stall, not lost packets
+    BlockCallback on_block;
+
+    float left_level;   // Level of the latest block
+    float right_level;
+    uint64_t block_count;
+    GapCount gaps;
+    std::chrono::steady_clock::time_point last_packet_time;
+    std::chrono::steady_clock::time_point last_silence_time;
+};
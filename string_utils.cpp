@@ -0,0 +1,25 @@
+#include "string_utils.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+
+std::string WideToUtf8(const wchar_t* wide) {
+    if (!wide) return "";
+    // The size includes the terminator, which std::string keeps itself
+    int size_needed = WideCharToMultiByte(CP_UTF8, 0, wide, -1, NULL, 0, NULL, NULL);
+    if (size_needed <= 0) return "";
+    std::string result(size_needed, 0);
+    WideCharToMultiByte(CP_UTF8, 0, wide, -1, &result[0], size_needed, NULL, NULL);
+    result.resize(size_needed - 1);
+    return result;
+}
+
+std::wstring Utf8ToWide(const std::string& utf8) {
+    int size_needed = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, NULL, 0);
+    if (size_needed <= 0) return L"";
+    std::wstring result(size_needed, 0);
+    MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, &result[0], size_needed);
+    result.resize(size_needed - 1);
+    return result;
+}
+#endif
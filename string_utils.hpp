@@ -0,0 +1,9 @@
+#pragma once
+#include <string>
+
+#ifdef _WIN32
+// Conversions between the UTF-8 strings used throughout the app and the
+// UTF-16 strings of the Windows API. Invalid input converts to "".
+std::string WideToUtf8(const wchar_t* wide);  // nullptr converts to ""
+std::wstring Utf8ToWide(const std::string& utf8);
+#endif
@@ -0,0 +1,117 @@
+// Gap detection: GapTracker on its own, and FakeCaptureSource gaps
+// flowing through a SourcePipeline
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "capture_source.hpp"
+#include "check.hpp"
+#include "source_pipeline.hpp"
+
+namespace {
+
+void TestGapTracker() {
+    GapTracker tracker;
+
+    // The first packet after a (re)start is never a gap, flagged or not
+    GapTracker::Gap gap = tracker.OnPacket(1000, 480, true);
+    CHECK(!gap.detected);
+
+    gap = tracker.OnPacket(1480, 480, false);
+    CHECK(!gap.detected);
+    CHECK_EQ(gap.frames_lost, 0);
+
+    // Position jumped: the frames in between were lost
+    gap = tracker.OnPacket(2200, 480, false);
+    CHECK(gap.detected);
+    CHECK_EQ(gap.frames_lost, 2200 - 1960);
+
+    // Discontinuity flag without a position jump: a gap of unknown size
+    gap = tracker.OnPacket(2680, 480, true);
+    CHECK(gap.detected);
+    CHECK_EQ(gap.frames_lost, 0);
+
+    // Overlapping packets aren't a loss
+    gap = tracker.OnPacket(3000, 480, false);
+    CHECK(!gap.detected);
+
+    tracker.Reset();
+    gap = tracker.OnPacket(100000, 480, false);
+    CHECK(!gap.detected);
+}
+
+const unsigned kSampleRate = 48000;
+const size_t kPacketFrames = 480;  // 10 ms, also the block window and hop
+
+// Reads until at least one packet has been delivered
+void ReadPacket(FakeCaptureSource& source, SourcePipeline& pipeline) {
+    uint64_t blocks = pipeline.BlockCount();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (pipeline.BlockCount() == blocks && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        CHECK(source.Read(pipeline) == CaptureSource::ReadStatus::Ok);
+    }
+}
+
+void TestFakeSourceGap() {
+    FakeCaptureSource source("fake", kSampleRate, kPacketFrames);
+    std::vector<float> levels;  // Left level of every block
+    SourcePipeline* pipeline_ptr = nullptr;
+    LevelSettings level;
+    level.detector = LevelDetector::Average;
+    SourcePipeline pipeline(kSampleRate, 10, 10, level, 1.0f, [&] { levels.push_back(pipeline_ptr->LeftLevel()); });
+    pipeline_ptr = &pipeline;
+
+    CHECK(source.Open());
+    CHECK(source.Start());
+    ReadPacket(source, pipeline);
+    CHECK(!levels.empty());
+    SourcePipeline::GapCount gaps = pipeline.TakeGaps();
+    CHECK_EQ(gaps.gaps, 0);
+
+    // Three blocks' worth lost between two packets
+    const size_t before = levels.size();
+    source.InjectGap(3 * kPacketFrames);
+    ReadPacket(source, pipeline);
+    gaps = pipeline.TakeGaps();
+    CHECK_EQ(gaps.gaps, 1);
+    CHECK_EQ(gaps.frames_lost, 3 * kPacketFrames);
+
+    // The lost stretch is filled with silent blocks, then the tone resumes
+    CHECK(levels.size() >= before + 4);
+    if (levels.size() >= before + 4) {
+        CHECK(levels[before] == 0.0f);
+        CHECK(levels[before + 1] == 0.0f);
+        CHECK(levels[before + 2] == 0.0f);
+        CHECK(levels[before + 3] > 0.1f);
+    }
+
+    // Taken once
+    gaps = pipeline.TakeGaps();
+    CHECK_EQ(gaps.gaps, 0);
+    CHECK_EQ(gaps.frames_lost, 0);
+    source.Stop();
+}
+
+void TestRestartIsNotAGap() {
+    FakeCaptureSource source("fake", kSampleRate, kPacketFrames);
+    SourcePipeline pipeline(kSampleRate, 10, 10, LevelSettings(), 1.0f, nullptr);
+    CHECK(source.Start());
+    ReadPacket(source, pipeline);
+    source.Stop();
+    CHECK(source.Read(pipeline) == CaptureSource::ReadStatus::Failed);
+
+    // The stream position moved on while stopped, which isn't lost audio
+    source.InjectGap(kSampleRate);
+    CHECK(source.Start());
+    ReadPacket(source, pipeline);
+    CHECK_EQ(pipeline.TakeGaps().gaps, 0);
+}
+
+} // namespace
+
+int main() {
+    TestGapTracker();
+    TestFakeSourceGap();
+    TestRestartIsNotAGap();
+    return test::Result();
+}
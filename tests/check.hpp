@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdio>
+
+// Checks for the standalone test executables. A failed CHECK reports
+// where it failed and carries on; main() returns test::Result().
+
+namespace test {
+
+inline int& Failures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline int Result() {
+    if (Failures() > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", Failures());
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace test
+
+#define CHECK(condition)                                                                      \
+    do {                                                                                      \
+        if (!(condition)) {                                                                   \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            test::Failures()++;                                                               \
+        }                                                                                     \
+    } while (0)
+
+// For values that print with %llu, so a failure shows both sides
+#define CHECK_EQ(actual, expected)                                                        \
+    do {                                                                                  \
+        unsigned long long actual_value = static_cast<unsigned long long>(actual);        \
+        unsigned long long expected_value = static_cast<unsigned long long>(expected);    \
+        if (actual_value != expected_value) {                                             \
+            std::fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed: %llu != %llu\n",        \
+                         __FILE__, __LINE__, #actual, #expected, actual_value, expected_value); \
+            test::Failures()++;                                                           \
+        }                                                                                 \
+    } while (0)
@@ -0,0 +1,103 @@
+// DeviceSupervisor's reconnect decisions, driven by a FakeDeviceWatcher
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "check.hpp"
+#include "device_watcher.hpp"
+
+namespace {
+
+using Type = DeviceEvent::Type;
+
+// A supervisor attached to a fake watcher, handling events on the test's
+// thread
+struct Fixture {
+    FakeDeviceWatcher watcher;
+    std::atomic<bool> reconnect{ false };
+    DeviceSupervisor supervisor{ watcher, reconnect };
+
+    Fixture(const std::string& current, bool follow_default) {
+        CHECK(supervisor.Attach());
+        supervisor.SetCurrentDevice(current, follow_default);
+    }
+
+    // Delivers the event and returns whether it raised the flag
+    bool Reconnects(Type type, const std::string& device_id, bool active) {
+        reconnect.store(false);
+        watcher.Inject({ type, device_id, active });
+        supervisor.ProcessPendingEvents();
+        return reconnect.load();
+    }
+};
+
+void TestDefaultChange() {
+    Fixture following("speakers", true);
+    CHECK(following.Reconnects(Type::DefaultChanged, "headset", true));
+    CHECK(!following.Reconnects(Type::DefaultChanged, "speakers", true));
+
+    // A chosen device stays put when the default moves
+    Fixture chosen("speakers", false);
+    CHECK(!chosen.Reconnects(Type::DefaultChanged, "headset", true));
+}
+
+void TestCurrentDeviceLost() {
+    Fixture fixture("speakers", false);
+    CHECK(fixture.Reconnects(Type::Removed, "speakers", false));
+    CHECK(fixture.Reconnects(Type::StateChanged, "speakers", false));
+    CHECK(!fixture.Reconnects(Type::StateChanged, "speakers", true));
+    CHECK(!fixture.Reconnects(Type::Removed, "headset", false));
+    CHECK(!fixture.Reconnects(Type::Added, "headset", true));
+}
+
+void TestExtraDevices() {
+    Fixture fixture("speakers", true);
+    fixture.supervisor.SetExtraDevices({ "mic", "voicemeeter" });
+    CHECK(fixture.Reconnects(Type::Removed, "mic", false));
+    CHECK(fixture.Reconnects(Type::Added, "mic", true));
+    CHECK(fixture.Reconnects(Type::StateChanged, "voicemeeter", true));
+    CHECK(!fixture.Reconnects(Type::Added, "headset", true));
+}
+
+void TestNoEventsBeforeAttach() {
+    FakeDeviceWatcher watcher;
+    std::atomic<bool> reconnect{ false };
+    DeviceSupervisor supervisor(watcher, reconnect);
+    supervisor.SetCurrentDevice("speakers", true);
+    watcher.Inject({ Type::DefaultChanged, "headset", true });
+    supervisor.ProcessPendingEvents();
+    CHECK(!reconnect.load());
+}
+
+void TestStoppedSupervisorIgnoresEvents() {
+    Fixture fixture("speakers", true);
+    fixture.supervisor.Stop();
+    CHECK(!fixture.Reconnects(Type::DefaultChanged, "headset", true));
+}
+
+void TestSupervisorThread() {
+    FakeDeviceWatcher watcher;
+    std::atomic<bool> reconnect{ false };
+    DeviceSupervisor supervisor(watcher, reconnect);
+    supervisor.SetCurrentDevice("speakers", true);
+    CHECK(supervisor.Start());
+    watcher.Inject({ Type::DefaultChanged, "headset", true });
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!reconnect.load() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK(reconnect.load());
+    supervisor.Stop();
+}
+
+} // namespace
+
+int main() {
+    TestDefaultChange();
+    TestCurrentDeviceLost();
+    TestExtraDevices();
+    TestNoEventsBeforeAttach();
+    TestStoppedSupervisorIgnoresEvents();
+    TestSupervisorThread();
+    return test::Result();
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <oscpp/client.hpp>
+
+// Packets shaped like VRChat OSC traffic: avatar parameter updates of
+// every type, avatar changes, chatbox and tracker input, and bundles of
+// them, including nested ones. The parse benchmark runs over these, and
+// the fuzzer's seed corpus in corpus/oscpp is written from them.
+
+struct CorpusPacket {
+    std::string name;
+    std::vector<char> bytes;
+};
+
+namespace osc_corpus {
+
+const uint64_t kImmediately = 1;  // OSC time tag for "now"
+
+template <typename Build>
+CorpusPacket Make(const char* name, Build build) {
+    std::vector<char> buffer(8192);
+    OSCPP::Client::Packet packet(buffer.data(), buffer.size());
+    build(packet);
+    buffer.resize(packet.size());
+    return { name, std::move(buffer) };
+}
+
+inline void Parameters(OSCPP::Client::Packet& packet, int count) {
+    static const char* const kNames[] = {
+        "/avatar/parameters/EarPerkLeft", "/avatar/parameters/EarPerkRight",
+        "/avatar/parameters/EarOverwhelm", "/avatar/parameters/VelocityX",
+        "/avatar/parameters/VelocityZ", "/avatar/parameters/GestureLeft",
+        "/avatar/parameters/TailWag", "/avatar/parameters/Voice",
+    };
+    for (int i = 0; i < count; i++) {
+        const char* name = kNames[i % 8];
+        packet.openMessage(name, 1);
+        switch (i % 4) {
+        case 0: packet.int32(i & 1); break;
+        case 1: packet.float32(0.125f * i); break;
+        case 2: packet.boolean(true); break;
+        default: packet.boolean(false); break;
+        }
+        packet.closeMessage();
+    }
+}
+
+} // namespace osc_corpus
+
+inline std::vector<CorpusPacket> VrchatCorpus() {
+    using OSCPP::Client::Packet;
+    std::vector<CorpusPacket> corpus;
+    corpus.push_back(osc_corpus::Make("int_parameter", [](Packet& p) {
+        p.openMessage("/avatar/parameters/EarPerkLeft", 1).int32(1).closeMessage();
+    }));
+    corpus.push_back(osc_corpus::Make("bool_parameter", [](Packet& p) {
+        p.openMessage("/avatar/parameters/EarPerkRight", 1).boolean(true).closeMessage();
+    }));
+    corpus.push_back(osc_corpus::Make("float_parameter", [](Packet& p) {
+        p.openMessage("/avatar/parameters/VelocityX", 1).float32(-0.42f).closeMessage();
+    }));
+    corpus.push_back(osc_corpus::Make("avatar_change", [](Packet& p) {
+        p.openMessage("/avatar/change", 1).string("avtr_7f3c9a4e-1b2d-4c5e-8f90-123456789abc").closeMessage();
+    }));
+    corpus.push_back(osc_corpus::Make("chatbox", [](Packet& p) {
+        p.openMessage("/chatbox/input", 3).string("ears perked").boolean(true).boolean(false).closeMessage();
+    }));
+    corpus.push_back(osc_corpus::Make("tracker", [](Packet& p) {
+        p.openMessage("/tracking/trackers/1/position", 3).float32(0.1f).float32(1.6f).float32(-0.3f).closeMessage();
+    }));
+    corpus.push_back(osc_corpus::Make("wide_types", [](Packet& p) {
+        p.openMessage("/earperk/stats", 4).int64(-1234567890123ll).float64(0.5).timeTag(osc_corpus::kImmediately).nil().closeMessage();
+    }));
+    corpus.push_back(osc_corpus::Make("arrays_and_blob", [](Packet& p) {
+        const float bands[8] = { 0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f, 0.7f, 0.8f };
+        const int32_t counts[3] = { 1, -2, 3 };
+        // [8f] [[3i] f] b
+        p.openMessage("/earperk/bands", (8 + 2) + (3 + 2 + 1 + 2) + 1)
+            .float32Array(bands, 8)
+            .openArray().int32Array(counts, 3).float32(1.0f).closeArray()
+            .float32Blob(bands, 8)
+            .closeMessage();
+    }));
+    corpus.push_back(osc_corpus::Make("no_arguments", [](Packet& p) {
+        p.openMessage("/avatar/parameters/Reset", 0).closeMessage();
+    }));
+    corpus.push_back(osc_corpus::Make("empty_bundle", [](Packet& p) {
+        p.openBundle(osc_corpus::kImmediately).closeBundle();
+    }));
+    corpus.push_back(osc_corpus::Make("parameter_bundle", [](Packet& p) {
+        p.openBundle(osc_corpus::kImmediately);
+        osc_corpus::Parameters(p, 8);
+        p.closeBundle();
+    }));
+    corpus.push_back(osc_corpus::Make("nested_bundle", [](Packet& p) {
+        p.openBundle(osc_corpus::kImmediately);
+        osc_corpus::Parameters(p, 2);
+        p.openBundle(0x83aa7e8000000000ull);
+        osc_corpus::Parameters(p, 4);
+        p.openBundle(osc_corpus::kImmediately);
+        p.openMessage("/avatar/change", 1).string("avtr_nested").closeMessage();
+        p.closeBundle();
+        p.closeBundle();
+        osc_corpus::Parameters(p, 2);
+        p.closeBundle();
+    }));
+    corpus.push_back(osc_corpus::Make("deep_bundle", [](Packet& p) {
+        const int depth = 15;  // Validator::kMaxBundleDepth - 1
+        for (int i = 0; i < depth; i++) {
+            p.openBundle(osc_corpus::kImmediately);
+        }
+        osc_corpus::Parameters(p, 1);
+        for (int i = 0; i < depth; i++) {
+            p.closeBundle();
+        }
+    }));
+    return corpus;
+}
@@ -0,0 +1,118 @@
+// Parse throughput of the oscpp server API over VRChat-style packets.
+//
+//   osc_parse_bench [--iterations N] [--write-corpus DIR]
+//
+// Times, per packet and over the whole corpus, a full read through the
+// checked API, validate() alone, and validate() followed by an Unchecked
+// read. --write-corpus writes the packets out as fuzzer seeds instead.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <oscpp/server.hpp>
+#include "osc_corpus.hpp"
+#include "osc_walk.hpp"
+
+namespace {
+
+const int kDefaultIterations = 200000;
+
+volatile uint64_t sink;  // Keeps the reads from being optimized away
+
+template <typename Read>
+double NsPerCall(int iterations, Read read) {
+    uint64_t hash = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        hash += read();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    sink = hash;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+struct Timings {
+    double checked = 0.0;
+    double validate = 0.0;
+    double unchecked = 0.0;
+};
+
+Timings Measure(const CorpusPacket& packet, int iterations) {
+    const char* data = packet.bytes.data();
+    const size_t size = packet.bytes.size();
+    Timings t;
+    t.checked = NsPerCall(iterations, [&] {
+        return osc_walk::WalkChecked(OSCPP::Server::Packet(data, size));
+    });
+    t.validate = NsPerCall(iterations, [&] {
+        return static_cast<uint64_t>(OSCPP::Server::validate(data, size));
+    });
+    t.unchecked = NsPerCall(iterations, [&] {
+        if (!OSCPP::Server::validate(data, size)) {
+            return uint64_t{ 0 };
+        }
+        return osc_walk::WalkUnchecked(OSCPP::Server::Unchecked::Packet(data, size));
+    });
+    return t;
+}
+
+bool WriteCorpus(const std::vector<CorpusPacket>& corpus, const std::string& directory) {
+    for (const auto& packet : corpus) {
+        std::string path = directory + "/" + packet.name + ".osc";
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(packet.bytes.data(), static_cast<std::streamsize>(packet.bytes.size()));
+        if (!file) {
+            std::fprintf(stderr, "Can't write %s\n", path.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = kDefaultIterations;
+    std::string corpus_dir;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--write-corpus" && i + 1 < argc) {
+            corpus_dir = argv[++i];
+        } else {
+            std::fprintf(stderr, "Usage: osc_parse_bench [--iterations N] [--write-corpus DIR]\n");
+            return 2;
+        }
+    }
+
+    std::vector<CorpusPacket> corpus = VrchatCorpus();
+    if (!corpus_dir.empty()) {
+        return WriteCorpus(corpus, corpus_dir) ? 0 : 1;
+    }
+
+    std::printf("%-18s %6s %12s %12s %12s\n", "packet", "bytes", "checked ns", "validate ns", "val+unch ns");
+    Timings total;
+    size_t bytes = 0;
+    for (const auto& packet : corpus) {
+        if (!OSCPP::Server::validate(packet.bytes.data(), packet.bytes.size())) {
+            std::fprintf(stderr, "%s doesn't validate\n", packet.name.c_str());
+            return 1;
+        }
+        Timings t = Measure(packet, iterations);
+        std::printf("%-18s %6zu %12.1f %12.1f %12.1f\n", packet.name.c_str(), packet.bytes.size(),
+                    t.checked, t.validate, t.unchecked);
+        total.checked += t.checked;
+        total.validate += t.validate;
+        total.unchecked += t.unchecked;
+        bytes += packet.bytes.size();
+    }
+    // bytes per nanosecond is GB/s; * 1000 for MB/s
+    std::printf("%-18s %6zu %9.0f MB/s %7.0f MB/s %7.0f MB/s\n", "corpus", bytes,
+                bytes * 1000.0 / total.checked, bytes * 1000.0 / total.validate, bytes * 1000.0 / total.unchecked);
+    return 0;
+}
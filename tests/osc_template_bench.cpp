@@ -0,0 +1,111 @@
+// Cost of serializing the messages OSCSender sends, rebuilt with
+// Client::Packet for every send versus patched into a MessageTemplate.
+//
+//   osc_template_bench [--iterations N]
+//
+// Each case first checks that both paths produce the same bytes.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <oscpp/client.hpp>
+
+namespace {
+
+const int kDefaultIterations = 10000000;
+// Read from config.ini in the app, so strlen() can't be folded away
+const std::string parameter_address = "/avatar/parameters/EarPerkLeft";
+
+// Marks the packet bytes as used, so the serialization isn't optimized
+// away, without reading them back: a load overlapping the byte a boolean
+// patch just wrote would stall on store forwarding, which a real send
+// much later doesn't
+inline void Consume(const void* data) {
+#ifdef _MSC_VER
+    static const void* volatile escaped;
+    escaped = data;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r"(data) : "memory");
+#endif
+}
+
+// Builds or patches message i
+using Builder = void (*)(OSCPP::Client::Packet& packet, int i);
+
+template <typename Template>
+using Patcher = void (*)(Template& message, int i);
+
+template <typename Template>
+bool RunCase(const char* name, int iterations, Builder build, Patcher<Template> patch) {
+    std::array<char, 256> buffer;
+    OSCPP::Client::Packet packet(buffer.data(), buffer.size());
+    Template message(parameter_address.c_str());
+
+    for (int i = 0; i < 4; i++) {
+        packet.reset();
+        build(packet, i);
+        patch(message, i);
+        if (packet.size() != message.size() || std::memcmp(buffer.data(), message.data(), packet.size()) != 0) {
+            std::fprintf(stderr, "%s: template output differs from Client::Packet\n", name);
+            return false;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        OSCPP::Client::Packet p(buffer.data(), buffer.size());
+        build(p, i);
+        Consume(buffer.data());
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        patch(message, i);
+        Consume(message.data());
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    const double packet_ns = std::chrono::duration<double, std::nano>(middle - start).count() / iterations;
+    const double template_ns = std::chrono::duration<double, std::nano>(end - middle).count() / iterations;
+    std::printf("%-14s %6zu %12.2f %12.2f %8.1fx\n", name, message.size(), packet_ns, template_ns,
+                packet_ns / template_ns);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = kDefaultIterations;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "Usage: osc_template_bench [--iterations N]\n");
+            return 2;
+        }
+    }
+
+    using OSCPP::Client::MessageTemplate;
+    using OSCPP::Client::Packet;
+    std::printf("%-14s %6s %12s %12s %9s\n", "message", "bytes", "packet ns", "template ns", "speedup");
+    bool ok = RunCase<MessageTemplate<'i'>>("int32 bool", iterations,
+        [](Packet& p, int i) { p.openMessage(parameter_address.c_str(), 1).int32(i & 1).closeMessage(); },
+        [](MessageTemplate<'i'>& m, int i) { m.int32<0>(i & 1); });
+    ok &= RunCase<MessageTemplate<'F'>>("T/F bool", iterations,
+        [](Packet& p, int i) { p.openMessage(parameter_address.c_str(), 1).boolean((i & 1) != 0).closeMessage(); },
+        [](MessageTemplate<'F'>& m, int i) { m.boolean<0>((i & 1) != 0); });
+    ok &= RunCase<MessageTemplate<'f'>>("float", iterations,
+        [](Packet& p, int i) { p.openMessage(parameter_address.c_str(), 1).float32(i * 0.25f).closeMessage(); },
+        [](MessageTemplate<'f'>& m, int i) { m.float32<0>(i * 0.25f); });
+    ok &= RunCase<MessageTemplate<'f', 'f', 'f'>>("3 floats", iterations,
+        [](Packet& p, int i) { p.openMessage(parameter_address.c_str(), 3).float32(i * 0.25f).float32(1.0f).float32(-i * 0.5f).closeMessage(); },
+        [](MessageTemplate<'f', 'f', 'f'>& m, int i) { m.float32<0>(i * 0.25f).float32<1>(1.0f).float32<2>(-i * 0.5f); });
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <oscpp/server.hpp>
+
+// Reads every element and argument of an OSC packet, once through the
+// checked Server API and once through Server::Unchecked. Both return a
+// hash of what they read, so the work can't be optimized away and the two
+// can be compared.
+
+namespace osc_walk {
+
+// Packets deeper than this are left partly unread rather than recursing
+// further; the checked API itself has no depth limit
+const size_t kMaxDepth = 64;
+
+inline uint64_t Mix(uint64_t hash, uint64_t value) {
+    return (hash ^ value) * 0x100000001b3ull;
+}
+
+inline uint64_t MixFloat(uint64_t hash, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return Mix(hash, bits);
+}
+
+inline uint64_t MixDouble(uint64_t hash, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return Mix(hash, bits);
+}
+
+// Both APIs return pointers into the packet, so the length says enough
+// without hashing every character
+inline uint64_t MixString(uint64_t hash, const char* value) {
+    return Mix(hash, std::strlen(value));
+}
+
+template <typename Args>
+uint64_t WalkArgs(Args args, uint64_t hash, size_t depth) {
+    while (!args.atEnd()) {
+        const char tag = args.tag();
+        hash = Mix(hash, static_cast<unsigned char>(tag));
+        switch (tag) {
+        case 'i': hash = Mix(hash, static_cast<uint32_t>(args.int32())); break;
+        case 'f': hash = MixFloat(hash, args.float32()); break;
+        case 'h': hash = Mix(hash, static_cast<uint64_t>(args.int64())); break;
+        case 'd': hash = MixDouble(hash, args.float64()); break;
+        case 't': hash = Mix(hash, args.timeTag()); break;
+        case 's': hash = MixString(hash, args.string()); break;
+        case 'b': hash = Mix(hash, args.blob().size()); break;
+        case 'T':
+        case 'F': hash = Mix(hash, args.boolean()); break;
+        case '[':
+            if (depth < kMaxDepth) {
+                hash = WalkArgs(args.array(), hash, depth + 1);
+            } else {
+                args.drop();
+            }
+            break;
+        default: args.drop(); break;
+        }
+    }
+    return hash;
+}
+
+// Throws OSCPP::Error on malformed input, and nothing else
+inline uint64_t WalkChecked(const OSCPP::Server::Packet& packet, uint64_t hash = 0, size_t depth = 0) {
+    if (packet.isMessage()) {
+        OSCPP::Server::Message message(packet);
+        return WalkArgs(message.args(), MixString(hash, message.address()), 0);
+    }
+    OSCPP::Server::Bundle bundle(packet);
+    hash = Mix(hash, bundle.time());
+    if (depth >= kMaxDepth) {
+        return hash;
+    }
+    OSCPP::Server::PacketStream packets(bundle.packets());
+    while (!packets.atEnd()) {
+        hash = WalkChecked(packets.next(), hash, depth + 1);
+    }
+    return hash;
+}
+
+// Only for packets that passed OSCPP::Server::validate()
+inline uint64_t WalkUnchecked(const OSCPP::Server::Unchecked::Packet& packet, uint64_t hash = 0, size_t depth = 0) {
+    if (packet.isMessage()) {
+        OSCPP::Server::Unchecked::Message message = packet.message();
+        return WalkArgs(message.args(), MixString(hash, message.address()), 0);
+    }
+    OSCPP::Server::Unchecked::Bundle bundle = packet.bundle();
+    hash = Mix(hash, bundle.time());
+    if (depth >= kMaxDepth) {
+        return hash;
+    }
+    OSCPP::Server::Unchecked::PacketStream packets(bundle.packets());
+    while (!packets.atEnd()) {
+        hash = WalkUnchecked(packets.next(), hash, depth + 1);
+    }
+    return hash;
+}
+
+} // namespace osc_walk
@@ -0,0 +1,204 @@
+// Fuzz harness for the oscpp parser.
+//
+// LLVMFuzzerTestOneInput treats its input as a received datagram. A
+// packet must either parse through the checked Server API or fail with an
+// OSCPP::Error, never read outside the datagram, and every packet that
+// Server::validate() accepts must read the same through the checked and
+// the Unchecked API.
+//
+// Built with EARPERK_LIBFUZZER (clang -fsanitize=fuzzer) this is a plain
+// libFuzzer target:
+//   oscpp_fuzz tests/corpus/oscpp
+// Otherwise main() below replays the given files or directories, every
+// truncation of them and a fixed set of mutations, so any compiler with
+// AddressSanitizer can run the same checks as a test.
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <oscpp/server.hpp>
+#include "osc_walk.hpp"
+
+namespace {
+
+void Fail(const char* what, const uint8_t* data, size_t size) {
+    std::fprintf(stderr, "%s (%zu byte packet):", what, size);
+    for (size_t i = 0; i < size; i++) {
+        std::fprintf(stderr, " %02x", data[i]);
+    }
+    std::fprintf(stderr, "\n");
+    std::abort();
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    // Exact-size heap copy, so AddressSanitizer catches any read past the
+    // end; new[] keeps it aligned like a receive buffer
+    std::unique_ptr<char[]> packet(new char[size]);
+    if (size > 0) {
+        std::memcpy(packet.get(), data, size);
+    }
+
+    const bool valid = OSCPP::Server::validate(packet.get(), size);
+    bool parsed = true;
+    uint64_t checked = 0;
+    try {
+        checked = osc_walk::WalkChecked(OSCPP::Server::Packet(packet.get(), size));
+    } catch (const OSCPP::Error&) {
+        // Rejected malformed input; any other exception is a bug and
+        // escapes as a crash
+        parsed = false;
+    }
+
+    if (valid) {
+        if (!parsed) {
+            Fail("validate() accepted a packet the checked API rejects", data, size);
+        }
+        if (osc_walk::WalkUnchecked(OSCPP::Server::Unchecked::Packet(packet.get(), size)) != checked) {
+            Fail("Checked and Unchecked reads differ", data, size);
+        }
+    }
+    return 0;
+}
+
+#ifndef EARPERK_LIBFUZZER
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int kDefaultMutations = 2000;
+
+struct Totals {
+    uint64_t inputs = 0;
+    uint64_t valid = 0;
+};
+
+void Run(const std::vector<uint8_t>& input, Totals* totals) {
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+    totals->inputs++;
+    totals->valid += OSCPP::Server::validate(input.data(), input.size()) ? 1 : 0;
+}
+
+// Sizes and counts that tend to break length handling
+const int32_t kInterestingWords[] = {
+    0, 1, 3, 4, 7, 8, 16, 0x7fffffff, -1, -4, INT32_MIN, 0x40000000,
+};
+
+void Mutate(std::vector<uint8_t>* packet, std::mt19937* rng) {
+    std::uniform_int_distribution<int> kind(0, 4);
+    const size_t size = packet->size();
+    auto at = [&](size_t limit) { return std::uniform_int_distribution<size_t>(0, limit)(*rng); };
+    switch (kind(*rng)) {
+    case 0:  // Flip a bit
+        if (size > 0) {
+            (*packet)[at(size - 1)] ^= static_cast<uint8_t>(1u << at(7));
+        }
+        break;
+    case 1:  // Random byte
+        if (size > 0) {
+            (*packet)[at(size - 1)] = static_cast<uint8_t>(at(255));
+        }
+        break;
+    case 2:  // Big-endian word over a size, count or tag field
+        if (size >= 4) {
+            const size_t pos = at(size / 4 - 1) * 4;
+            const uint32_t word = static_cast<uint32_t>(
+                kInterestingWords[at(sizeof(kInterestingWords) / sizeof(kInterestingWords[0]) - 1)]);
+            for (int i = 0; i < 4; i++) {
+                (*packet)[pos + i] = static_cast<uint8_t>(word >> (24 - 8 * i));
+            }
+        }
+        break;
+    case 3:  // Insert bytes
+    {
+        const size_t count = 1 + at(7);
+        packet->insert(packet->begin() + at(size), count, static_cast<uint8_t>(at(255)));
+        break;
+    }
+    default:  // Erase bytes
+        if (size > 0) {
+            const size_t pos = at(size - 1);
+            packet->erase(packet->begin() + pos, packet->begin() + std::min(size, pos + 1 + at(7)));
+        }
+        break;
+    }
+}
+
+void RunSeed(const std::vector<uint8_t>& seed, int mutations, std::mt19937* rng, Totals* totals) {
+    Run(seed, totals);
+    for (size_t n = 0; n < seed.size(); n++) {
+        Run(std::vector<uint8_t>(seed.begin(), seed.begin() + n), totals);
+    }
+    for (int i = 0; i < mutations; i++) {
+        std::vector<uint8_t> packet = seed;
+        const int rounds = 1 + static_cast<int>((*rng)() % 4);
+        for (int r = 0; r < rounds; r++) {
+            Mutate(&packet, rng);
+        }
+        Run(packet, totals);
+    }
+}
+
+bool ReadFile(const std::filesystem::path& path, std::vector<uint8_t>* contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    contents->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int mutations = kDefaultMutations;
+    std::vector<std::filesystem::path> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--mutations" && i + 1 < argc) {
+            mutations = std::atoi(argv[++i]);
+        } else if (std::filesystem::is_directory(arg)) {
+            for (const auto& entry : std::filesystem::directory_iterator(arg)) {
+                if (entry.is_regular_file()) {
+                    files.push_back(entry.path());
+                }
+            }
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.empty()) {
+        std::fprintf(stderr, "Usage: oscpp_fuzz [--mutations N] <file | directory>...\n");
+        return 2;
+    }
+    std::sort(files.begin(), files.end());
+
+    std::mt19937 rng(0x05c0);  // Fixed, so a failure reproduces
+    Totals totals;
+    for (const auto& path : files) {
+        std::vector<uint8_t> seed;
+        if (!ReadFile(path, &seed)) {
+            std::fprintf(stderr, "Can't read %s\n", path.string().c_str());
+            return 2;
+        }
+        if (!OSCPP::Server::validate(seed.data(), seed.size())) {
+            std::fprintf(stderr, "Seed %s is not a valid packet\n", path.string().c_str());
+            return 1;
+        }
+        RunSeed(seed, mutations, &rng, &totals);
+    }
+    std::printf("%zu seeds, %llu packets, %llu valid\n", files.size(),
+                static_cast<unsigned long long>(totals.inputs), static_cast<unsigned long long>(totals.valid));
+    return 0;
+}
+
+#endif
@@ -0,0 +1,96 @@
+// Rule conditions and their cooldown/hold timing, which counts the audio
+// frames passed to Process() rather than wall clock time
+#include <string>
+#include <utility>
+#include <vector>
+#include "check.hpp"
+#include "rule_engine.hpp"
+
+namespace {
+
+const unsigned kSampleRate = 48000;
+const uint32_t kHopFrames = 240;  // 5 ms blocks
+
+struct Sent {
+    size_t index;
+    bool value;
+};
+
+// Runs one block with the given left level and returns what was sent
+std::vector<Sent> Block(RuleSet& rules, float left, uint32_t frames = kHopFrames) {
+    float inputs[kRuleInputCount] = {};
+    inputs[InputLeft] = left;
+    inputs[InputRight] = 0.1f;
+    std::vector<Sent> sent;
+    rules.Process(inputs, frames, [&](size_t index, bool value) { sent.push_back({ index, value }); });
+    return sent;
+}
+
+void TestCompile() {
+    std::vector<std::string> errors;
+    RuleSet rules = RuleSet::Compile({
+        "/avatar/parameters/A if left > 0.3 and left - right > 0.1",
+        "/avatar/parameters/B if left >",
+        "avatar/parameters/C if left > 0.3",
+        "/avatar/parameters/D if max(left, right) >= 0.5 cooldown 20 hold 50",
+    }, &errors);
+    CHECK_EQ(rules.Size(), 2);
+    CHECK_EQ(errors.size(), 2);
+    CHECK(rules.Address(0) == "/avatar/parameters/A");
+    CHECK(rules.Address(1) == "/avatar/parameters/D");
+}
+
+void TestTiming() {
+    std::vector<std::string> errors;
+    RuleSet rules = RuleSet::Compile({ "/avatar/parameters/Loud if left > 0.5 cooldown 20 hold 50" }, &errors);
+    rules.SetSampleRate(kSampleRate);
+
+    // Fires on the very first block, like a rule that was never triggered
+    std::vector<Sent> sent = Block(rules, 0.9f);
+    CHECK_EQ(sent.size(), 1);
+    CHECK(sent.size() == 1 && sent[0].value);
+    CHECK(rules.IsOn(0));
+
+    // Within the 20 ms cooldown nothing is sent again
+    for (int i = 0; i < 4; i++) {
+        CHECK(Block(rules, 0.9f).empty());
+    }
+    // 25 ms after the trigger it fires again
+    sent = Block(rules, 0.9f);
+    CHECK(sent.size() == 1 && sent[0].value);
+
+    // Quiet: on until more than 50 ms have passed since that trigger
+    for (int i = 0; i < 10; i++) {
+        CHECK(Block(rules, 0.0f).empty());
+    }
+    sent = Block(rules, 0.0f);
+    CHECK(sent.size() == 1 && !sent[0].value);
+    CHECK(!rules.IsOn(0));
+}
+
+void TestFramesNotBlocks() {
+    std::vector<std::string> errors;
+    RuleSet rules = RuleSet::Compile({ "/avatar/parameters/Loud if left > 0.5 cooldown 0 hold 100" }, &errors);
+    rules.SetSampleRate(kSampleRate);
+    CHECK_EQ(Block(rules, 0.9f).size(), 1);
+
+    // One long block counts as all of its frames
+    std::vector<Sent> sent = Block(rules, 0.0f, kSampleRate / 5);
+    CHECK(sent.size() == 1 && !sent[0].value);
+
+    // A higher rate makes the same milliseconds more frames
+    RuleSet fast = RuleSet::Compile({ "/avatar/parameters/Loud if left > 0.5 cooldown 0 hold 100" }, &errors);
+    fast.SetSampleRate(2 * kSampleRate);
+    CHECK_EQ(Block(fast, 0.9f).size(), 1);
+    CHECK(Block(fast, 0.0f, kSampleRate / 10).empty());
+    CHECK_EQ(Block(fast, 0.0f, kSampleRate / 5).size(), 1);
+}
+
+} // namespace
+
+int main() {
+    TestCompile();
+    TestTiming();
+    TestFramesNotBlocks();
+    return test::Result();
+}
@@ -0,0 +1,210 @@
+#include "thread_scheduling.hpp"
+#include "logger.hpp"
+#include <algorithm>
+
+#ifdef _WIN32
+#include <avrt.h>
+#pragma comment(lib, "Avrt.lib")
+#else
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+ScopedThreadScheduling::ScopedThreadScheduling(const ThreadScheduling& scheduling)
+    : mode(Mode::Normal)
+    , pinned(false)
+    , mmcss_task(nullptr)
+    , previous_priority(GetThreadPriority(GetCurrentThread()))
+    , previous_affinity(0)
+{
+    if (scheduling.realtime) Elevate();
+    if (scheduling.cpu_core >= 0) Pin(scheduling.cpu_core);
+}
+
+ScopedThreadScheduling::~ScopedThreadScheduling() {
+    if (mmcss_task) {
+        AvRevertMmThreadCharacteristics(mmcss_task);
+    } else if (mode == Mode::Raised) {
+        SetThreadPriority(GetCurrentThread(), previous_priority);
+    }
+    if (pinned) {
+        SetThreadAffinityMask(GetCurrentThread(), previous_affinity);
+    }
+}
+
+void ScopedThreadScheduling::Elevate() {
+    // MMCSS also raises the timer resolution, which is what keeps Sleep(1)
+    // close to a millisecond
+    DWORD task_index = 0;
+    mmcss_task = AvSetMmThreadCharacteristicsW(L"Pro Audio", &task_index);
+    if (mmcss_task) {
+        AvSetMmThreadPriority(mmcss_task, AVRT_PRIORITY_HIGH);
+        mode = Mode::Realtime;
+        LOG_INFO("Capture thread registered with MMCSS (Pro Audio)");
+        return;
+    }
+
+    LOG_WARN_F("MMCSS registration failed (%lu), falling back to time-critical thread priority", GetLastError());
+    if (SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL)) {
+        mode = Mode::Raised;
+    } else {
+        LOG_WARN_F("Failed to raise capture thread priority: %lu", GetLastError());
+    }
+}
+
+void ScopedThreadScheduling::Pin(int cpu_core) {
+    if (cpu_core >= static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+        LOG_WARN_F("CPU core %d is out of range, not pinning capture thread", cpu_core);
+        return;
+    }
+    previous_affinity = SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu_core);
+    if (previous_affinity == 0) {
+        LOG_WARN_F("Failed to pin capture thread to core %d: %lu", cpu_core, GetLastError());
+        return;
+    }
+    pinned = true;
+    LOG_INFO_F("Capture thread pinned to core %d", cpu_core);
+}
+#else
+namespace {
+
+// Low enough to stay below kernel interrupt threads
+const int kRealtimePriority = 10;
+const int kFallbackNice = -10;
+
+pid_t CurrentThreadId() {
+    return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+} // namespace
+
+ScopedThreadScheduling::ScopedThreadScheduling(const ThreadScheduling& scheduling)
+    : mode(Mode::Normal)
+    , pinned(false)
+    , previous_policy(SCHED_OTHER)
+    , previous_param()
+    , previous_nice(0)
+{
+    pthread_getschedparam(pthread_self(), &previous_policy, &previous_param);
+    CPU_ZERO(&previous_affinity);
+
+    if (scheduling.realtime) Elevate();
+    if (scheduling.cpu_core >= 0) Pin(scheduling.cpu_core);
+}
+
+ScopedThreadScheduling::~ScopedThreadScheduling() {
+    if (mode == Mode::Realtime) {
+        pthread_setschedparam(pthread_self(), previous_policy, &previous_param);
+    } else if (mode == Mode::Raised) {
+        setpriority(PRIO_PROCESS, CurrentThreadId(), previous_nice);
+    }
+    if (pinned) {
+        pthread_setaffinity_np(pthread_self(), sizeof(previous_affinity), &previous_affinity);
+    }
+}
+
+void ScopedThreadScheduling::Elevate() {
+    for (int policy : { SCHED_FIFO, SCHED_RR }) {
+        sched_param param = {};
+        param.sched_priority = std::clamp(kRealtimePriority,
+            sched_get_priority_min(policy), sched_get_priority_max(policy));
+        int result = pthread_setschedparam(pthread_self(), policy, &param);
+        if (result == 0) {
+            mode = Mode::Realtime;
+            LOG_INFO_F("Capture thread running with %s priority %d",
+                policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", param.sched_priority);
+            return;
+        }
+        LOG_DEBUG_F("Failed to set %s: %s",
+            policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", strerror(result));
+    }
+
+    // Without CAP_SYS_NICE or an RLIMIT_RTPRIO, a lower nice value is the
+    // best we can do
+    errno = 0;
+    previous_nice = getpriority(PRIO_PROCESS, CurrentThreadId());
+    if (errno == 0 && setpriority(PRIO_PROCESS, CurrentThreadId(), kFallbackNice) == 0) {
+        mode = Mode::Raised;
+        LOG_WARN_F("Real-time scheduling not permitted, capture thread running at nice %d instead", kFallbackNice);
+    } else {
+        LOG_WARN("Real-time scheduling not permitted, capture thread running at normal priority");
+    }
+}
+
+void ScopedThreadScheduling::Pin(int cpu_core) {
+    if (cpu_core >= CPU_SETSIZE) {
+        LOG_WARN_F("CPU core %d is out of range, not pinning capture thread", cpu_core);
+        return;
+    }
+    pthread_getaffinity_np(pthread_self(), sizeof(previous_affinity), &previous_affinity);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu_core, &set);
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0) {
+        LOG_WARN_F("Failed to pin capture thread to core %d: %s", cpu_core, strerror(result));
+        return;
+    }
+    pinned = true;
+    LOG_INFO_F("Capture thread pinned to core %d", cpu_core);
+}
+#endif
+
+const char* ScopedThreadScheduling::ModeName(Mode mode) {
+    switch (mode) {
+        case Mode::Realtime: return "real-time";
+        case Mode::Raised: return "raised priority";
+        default: return "normal priority";
+    }
+}
+
+WakeupJitter::WakeupJitter()
+    : count(0)
+    , total_us(0.0)
+    , max_us(0.0)
+{
+    histogram.fill(0);
+}
+
+void WakeupJitter::Record(std::chrono::steady_clock::duration requested,
+                          std::chrono::steady_clock::duration actual) {
+    double late_us = std::chrono::duration<double, std::micro>(actual - requested).count();
+    late_us = std::max(late_us, 0.0);
+
+    size_t bucket = std::min(static_cast<size_t>(late_us / kBucketUs), kBuckets - 1);
+    histogram[bucket]++;
+    count++;
+    total_us += late_us;
+    max_us = std::max(max_us, late_us);
+}
+
+WakeupJitter::Stats WakeupJitter::TakeStats() {
+    Stats stats;
+    stats.wakeups = count;
+    if (count > 0) {
+        stats.mean_us = total_us / count;
+        stats.max_us = max_us;
+
+        uint64_t target = count - count / 100;  // 99th percentile rank
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBuckets; i++) {
+            seen += histogram[i];
+            if (seen >= target) {
+                stats.p99_us = static_cast<double>((i + 1) * kBucketUs);
+                break;
+            }
+        }
+    }
+
+    histogram.fill(0);
+    count = 0;
+    total_us = 0.0;
+    max_us = 0.0;
+    return stats;
+}
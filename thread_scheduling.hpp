@@ -0,0 +1,86 @@
+#pragma once
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sched.h>
+#endif
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Scheduling requested for the capture thread
+struct ThreadScheduling {
+    bool realtime = false;  // MMCSS "Pro Audio" on Windows, SCHED_FIFO/SCHED_RR elsewhere
+    int cpu_core = -1;      // Core to pin to, -1 to let the OS decide
+};
+
+// Applies scheduling to the calling thread and reverts it when destroyed.
+// Failures are logged and leave the thread at normal priority.
+class ScopedThreadScheduling {
+public:
+    // What the thread actually got
+    enum class Mode {
+        Normal,
+        Raised,   // Higher priority without real-time scheduling: nice on Linux, time-critical priority on Windows
+        Realtime  // MMCSS, SCHED_FIFO or SCHED_RR
+    };
+
+    explicit ScopedThreadScheduling(const ThreadScheduling& scheduling);
+    ~ScopedThreadScheduling();
+
+    ScopedThreadScheduling(const ScopedThreadScheduling&) = delete;
+    ScopedThreadScheduling& operator=(const ScopedThreadScheduling&) = delete;
+
+    Mode GetMode() const { return mode; }
+    bool IsRealtime() const { return mode == Mode::Realtime; }
+
+    // "real-time", "raised priority" or "normal priority", for logs
+    static const char* ModeName(Mode mode);
+
+private:
+    void Elevate();
+    void Pin(int cpu_core);
+
+    Mode mode;
+    bool pinned;
+#ifdef _WIN32
+    HANDLE mmcss_task;
+    int previous_priority;
+    DWORD_PTR previous_affinity;
+#else
+    int previous_policy;
+    sched_param previous_param;
+    int previous_nice;
+    cpu_set_t previous_affinity;
+#endif
+};
+
+// How late a thread wakes up, compared to when a timed sleep should have
+// ended or when its data was ready, summarized periodically.
+// Record() does not allocate and is cheap enough for the capture loop.
+class WakeupJitter {
+public:
+    struct Stats {
+        uint64_t wakeups = 0;
+        double mean_us = 0.0;
+        double p99_us = 0.0;  // Upper edge of the histogram bucket
+        double max_us = 0.0;
+    };
+
+    WakeupJitter();
+
+    void Record(std::chrono::steady_clock::duration requested,
+                std::chrono::steady_clock::duration actual);
+
+    // Statistics since the previous call, then start over
+    Stats TakeStats();
+
+private:
+    static constexpr int kBucketUs = 100;
+    static constexpr size_t kBuckets = 200;  // 20 ms; later wakeups land in the last bucket
+
+    std::array<uint32_t, kBuckets> histogram;
+    uint64_t count;
+    double total_us;
+    double max_us;
+};
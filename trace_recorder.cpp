@@ -0,0 +1,201 @@
+#include "trace_recorder.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// How often the writer thread empties the queue
+const auto kWriteInterval = std::chrono::milliseconds(250);
+
+const char kSchema[] =
+    "record=dt:u16,kind_state:u8,decisions:u8,a:u16,b:u16\n"
+    "kind_state=kind:bits0-2,state:bits3-5\n"
+    "kind0=block,a=left_level,b=right_level,decisions=decision_bits\n"
+    "kind1=thresholds,a=volume_threshold,b=excessive_volume_threshold\n"
+    "kind2=analyzer,a=mean,b=stddev\n"
+    "kind3=clock,a=dt_low,b=dt_high\n"
+    "kind4=framing,a=window_ms,b=hop_ms\n"
+    "decision_bits=left_perk,left_reset,right_perk,right_reset,overwhelm_on,overwhelm_off,suppressed\n"
+    "state_bits=left_perked,right_perked,overwhelmed\n";
+
+uint16_t Quantize(float level) {
+    float raw = std::round(level / trace::kLevelScale);
+    return static_cast<uint16_t>(std::min(65535.0f, std::max(0.0f, raw)));
+}
+
+} // namespace
+
+TraceRecorder::TraceRecorder(const std::string& path, int window_ms, int hop_ms)
+    : path(path)
+    , window_ms(window_ms)
+    , hop_ms(hop_ms)
+    , file(nullptr)
+    , frame_residue(0)
+    , pending_dt(0)
+    , framing{ static_cast<uint16_t>(window_ms), static_cast<uint16_t>(hop_ms) }
+    , last_framing{ static_cast<uint16_t>(window_ms), static_cast<uint16_t>(hop_ms) }
+    , last_thresholds{ 0, 0 }
+    , last_analyzer{ 0, 0 }
+    , queue(kQueueSize)
+    , head(0)
+    , tail(0)
+    , dropped(0)
+    , running(false)
+{
+}
+
+TraceRecorder::~TraceRecorder() {
+    Stop();
+}
+
+bool TraceRecorder::Start() {
+    if (running) return true;
+
+    file = fopen(path.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR_F("Failed to create trace file %s", path.c_str());
+        return false;
+    }
+
+    trace::TraceHeader header = {};
+    std::memcpy(header.magic, trace::kMagic, sizeof(header.magic));
+    header.version = trace::kVersion;
+    header.schema_size = sizeof(kSchema);
+    // Keep the records 8-byte aligned in the file
+    header.header_size = static_cast<uint32_t>((sizeof(header) + sizeof(kSchema) + 7) / 8 * 8);
+    header.record_size = sizeof(trace::TraceRecord);
+    header.time_unit_us = trace::kTimeUnitUs;
+    header.start_unix_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header.window_ms = static_cast<uint32_t>(window_ms);
+    header.hop_ms = static_cast<uint32_t>(hop_ms);
+    header.level_scale = trace::kLevelScale;
+
+    char padding[8] = {};
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(kSchema, sizeof(kSchema), 1, file);
+    fwrite(padding, header.header_size - sizeof(header) - sizeof(kSchema), 1, file);
+
+    LOG_INFO_F("Recording a detection trace to %s", path.c_str());
+    running = true;
+    thread = std::thread(&TraceRecorder::Run, this);
+    return true;
+}
+
+void TraceRecorder::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    cv.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    fclose(file);
+    file = nullptr;
+}
+
+void TraceRecorder::SetFraming(int window_ms, int hop_ms) {
+    framing[0] = static_cast<uint16_t>(window_ms);
+    framing[1] = static_cast<uint16_t>(hop_ms);
+}
+
+void TraceRecorder::RecordBlock(uint32_t frames, unsigned sample_rate, const BlockFeatures& features) {
+    // Whole time units only; the remainder carries over so the clock
+    // doesn't drift over hours
+    uint64_t rate = std::max(sample_rate, 1u);
+    frame_residue += static_cast<uint64_t>(frames) * (1000000 / trace::kTimeUnitUs);
+    pending_dt += static_cast<uint32_t>(frame_residue / rate);
+    frame_residue %= rate;
+
+    // The last_* values only move once their record is queued, so a
+    // dropped record is retried on the next block
+    if (framing[0] != last_framing[0] || framing[1] != last_framing[1]) {
+        if (Push(trace::Kind::Framing, features.state, 0, framing[0], framing[1])) {
+            last_framing[0] = framing[0];
+            last_framing[1] = framing[1];
+        }
+    }
+
+    uint16_t thresholds[2] = { Quantize(features.volume_threshold), Quantize(features.excessive_threshold) };
+    if (thresholds[0] != last_thresholds[0] || thresholds[1] != last_thresholds[1]) {
+        if (Push(trace::Kind::Thresholds, features.state, 0, thresholds[0], thresholds[1])) {
+            last_thresholds[0] = thresholds[0];
+            last_thresholds[1] = thresholds[1];
+        }
+    }
+
+    uint16_t analyzer[2] = { Quantize(features.analyzer_mean), Quantize(features.analyzer_stddev) };
+    if (analyzer[0] != last_analyzer[0] || analyzer[1] != last_analyzer[1]) {
+        if (Push(trace::Kind::Analyzer, features.state, 0, analyzer[0], analyzer[1])) {
+            last_analyzer[0] = analyzer[0];
+            last_analyzer[1] = analyzer[1];
+        }
+    }
+
+    Push(trace::Kind::Block, features.state, features.decisions,
+        Quantize(features.left_level), Quantize(features.right_level));
+}
+
+bool TraceRecorder::Push(trace::Kind kind, uint8_t state, uint8_t decisions, uint16_t a, uint16_t b) {
+    uint64_t h = head.load(std::memory_order_relaxed);
+    bool needs_clock = pending_dt > 0xFFFF;
+    if (h + (needs_clock ? 2 : 1) - tail.load(std::memory_order_acquire) > kQueueSize) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;  // pending_dt is kept, so the timeline stays right
+    }
+
+    if (needs_clock) {
+        // A gap longer than dt can hold, e.g. while the queue was full
+        trace::TraceRecord& clock = queue[h++ % kQueueSize];
+        clock.dt = 0;
+        clock.kind_state = static_cast<uint8_t>(trace::Kind::Clock);
+        clock.decisions = 0;
+        clock.a = static_cast<uint16_t>(pending_dt & 0xFFFF);
+        clock.b = static_cast<uint16_t>(pending_dt >> 16);
+        pending_dt = 0;
+    }
+
+    trace::TraceRecord& record = queue[h++ % kQueueSize];
+    record.dt = static_cast<uint16_t>(pending_dt);
+    record.kind_state = static_cast<uint8_t>(static_cast<uint8_t>(kind) | (state << 3));
+    record.decisions = decisions;
+    record.a = a;
+    record.b = b;
+    pending_dt = 0;
+
+    head.store(h, std::memory_order_release);
+    return true;
+}
+
+void TraceRecorder::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        cv.wait_for(lock, kWriteInterval, [this] { return !running; });
+        lock.unlock();
+        Drain();
+        lock.lock();
+    }
+}
+
+void TraceRecorder::Drain() {
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    uint64_t h = head.load(std::memory_order_acquire);
+
+    // At most two runs, split where the queue wraps around
+    while (t < h) {
+        size_t start = static_cast<size_t>(t % kQueueSize);
+        size_t count = static_cast<size_t>(std::min<uint64_t>(h - t, kQueueSize - start));
+        fwrite(&queue[start], sizeof(trace::TraceRecord), count, file);
+        t += count;
+    }
+    tail.store(t, std::memory_order_release);
+    fflush(file);
+
+    if (uint64_t lost = dropped.exchange(0, std::memory_order_relaxed)) {
+        LOG_WARN_F("Trace writer fell behind, %llu records dropped", static_cast<unsigned long long>(lost));
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "detector.hpp"
+
+// Binary trace of what the detector saw and did, for tuning thresholds
+// offline. The file is a TraceHeader, the schema text, then fixed-size
+// TraceRecords up to the end of the file, so it can be mapped and read
+// as an array. All values are little-endian.
+//
+// Every analysis block writes a Block record. Thresholds, analyzer
+// statistics and the block framing change far less often and only get a
+// record when their quantized value changes; the header holds the framing
+// the trace started with. Time is stream time, counted from the audio
+// frames between blocks, so a replay sees the spacing the detector saw.
+// At the default 5 ms hop that is about
+// 1.6 KB/s, around 6 MB per hour.
+namespace trace {
+
+const char kMagic[8] = { 'E', 'P', 'T', 'R', 'A', 'C', 'E', '\0' };
+const uint32_t kVersion = 2;
+const uint32_t kTimeUnitUs = 100;          // Unit of TraceRecord::dt
+const float kLevelScale = 1.0f / 32768.0f; // Level = raw * kLevelScale, so 0..2
+
+enum class Kind : uint8_t {
+    Block = 0,       // a: left level, b: right level, decisions: EarDecision bits
+    Thresholds = 1,  // a: volume threshold, b: excessive volume threshold
+    Analyzer = 2,    // a: mean, b: standard deviation of the volume analyzer
+    Clock = 3,       // a | b << 16: more time units before the next record
+    Framing = 4      // a: window_ms, b: hop_ms of the blocks that follow
+};
+
+#pragma pack(push, 1)
+struct TraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;   // Records start at this offset
+    uint32_t record_size;
+    uint32_t time_unit_us;
+    int64_t start_unix_us;  // Wall clock time of the first record's time base
+    uint32_t window_ms;
+    uint32_t hop_ms;
+    float level_scale;
+    uint32_t schema_size;   // Schema text follows the header
+};
+
+struct TraceRecord {
+    uint16_t dt;          // Time units since the previous record
+    uint8_t kind_state;   // Kind in bits 0-2, EarState in bits 3-5
+    uint8_t decisions;
+    uint16_t a;
+    uint16_t b;
+
+    Kind GetKind() const { return static_cast<Kind>(kind_state & 0x7); }
+    uint8_t GetState() const { return static_cast<uint8_t>(kind_state >> 3); }
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TraceRecord) == 8, "Trace records must stay 8 bytes");
+
+} // namespace trace
+
+// Writes the trace on its own thread. The capture thread only quantizes
+// and queues records; if the queue is full they are dropped and counted.
+class TraceRecorder {
+public:
+    struct BlockFeatures {
+        float left_level = 0.0f;
+        float right_level = 0.0f;
+        float analyzer_mean = 0.0f;
+        float analyzer_stddev = 0.0f;
+        float volume_threshold = 0.0f;
+        float excessive_threshold = 0.0f;
+        uint8_t decisions = 0;  // EarDecision bits
+        uint8_t state = 0;      // EarState bits
+    };
+
+    TraceRecorder(const std::string& path, int window_ms, int hop_ms);
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder&) = delete;
+    TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+    // Creates the file and writes the header
+    bool Start();
+    void Stop();
+
+    // Capture thread only, or while it is stopped. SetFraming() takes
+    // effect from the next block.
+    void SetFraming(int window_ms, int hop_ms);
+    // One block, `frames` at `sample_rate` after the previous one
+    void RecordBlock(uint32_t frames, unsigned sample_rate, const BlockFeatures& features);
+
+private:
+    static const size_t kQueueSize = 8192;
+
+    // False if the queue was full and the record was dropped
+    bool Push(trace::Kind kind, uint8_t state, uint8_t decisions, uint16_t a, uint16_t b);
+    void Run();
+    void Drain();
+
+    std::string path;
+    int window_ms;
+    int hop_ms;
+    FILE* file;
+
+    // Capture thread state
+    uint64_t frame_residue;  // Time not yet in pending_dt, in 1/sample_rate units
+    uint32_t pending_dt;
+    uint16_t framing[2];
+    uint16_t last_framing[2];
+    uint16_t last_thresholds[2];
+    uint16_t last_analyzer[2];
+
+    // Single producer (capture thread), single consumer (writer thread)
+    std::vector<trace::TraceRecord> queue;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool running;
+    std::thread thread;
+};
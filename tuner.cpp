@@ -0,0 +1,366 @@
+#include "tuner.hpp"
+#include "block_framer.hpp"
+#include "detector.hpp"
+#include "source_pipeline.hpp"
+#include "trace_recorder.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Replayed time resolution, in detector frames per second
+const unsigned kReplayRate = 1000000;
+
+// Read-only view of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path) {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) return false;
+        size = static_cast<size_t>(file_size.QuadPart);
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) return false;
+        data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) return false;
+        size = static_cast<size_t>(st.st_size);
+        void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = view == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(view);
+#endif
+        return data != nullptr;
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (data) munmap(const_cast<uint8_t*>(data), size);
+        if (fd >= 0) close(fd);
+        fd = -1;
+#endif
+        data = nullptr;
+        size = 0;
+    }
+
+    const uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+template <typename T>
+T ReadLE(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// "take.wav" -> "take.txt"
+std::string LabelPath(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return path + ".txt";
+    }
+    return path.substr(0, dot) + ".txt";
+}
+
+std::vector<TunerLabel> LoadLabels(const std::string& path) {
+    std::vector<TunerLabel> labels;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        TunerLabel label;
+        std::string text;
+        if (!(fields >> label.start_s >> label.end_s)) {
+            continue;  // Audacity's frequency lines start with a backslash
+        }
+        std::getline(fields >> std::ws, text);
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        bool left = text.find("left") != std::string::npos;
+        bool right = text.find("right") != std::string::npos;
+        if (!left && !right) {
+            left = right = true;  // "both" or anything else
+        }
+        label.ears = static_cast<uint8_t>((left ? LeftPerked : 0) | (right ? RightPerked : 0));
+        labels.push_back(label);
+    }
+    std::sort(labels.begin(), labels.end(), [](const TunerLabel& a, const TunerLabel& b) {
+        return a.start_s < b.start_s;
+    });
+    return labels;
+}
+
+} // namespace
+
+void ReplayResult::Add(const ReplayResult& other) {
+    duration_s += other.duration_s;
+    perks += other.perks;
+    flaps += other.flaps;
+    suppressed += other.suppressed;
+    overwhelms += other.overwhelms;
+    labels += other.labels;
+    detected += other.detected;
+    unexpected += other.unexpected;
+    latency_sum_ms += other.latency_sum_ms;
+    latency_max_ms = std::max(latency_max_ms, other.latency_max_ms);
+}
+
+bool LoadWav(const std::string& path, Recording* recording, std::string* error) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        *error = "can't open " + path;
+        return false;
+    }
+    const uint8_t* data = file.Data();
+    size_t size = file.Size();
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        *error = path + " is not a WAV file";
+        return false;
+    }
+
+    SampleFormat format;
+    const uint8_t* samples = nullptr;
+    size_t sample_bytes = 0;
+    for (size_t offset = 12; offset + 8 <= size;) {
+        uint32_t chunk_size = ReadLE<uint32_t>(data + offset + 4);
+        const uint8_t* chunk = data + offset + 8;
+        size_t available = std::min<size_t>(chunk_size, size - offset - 8);
+
+        if (std::memcmp(data + offset, "fmt ", 4) == 0 && available >= 16) {
+            uint16_t tag = ReadLE<uint16_t>(chunk);
+            uint16_t bits = ReadLE<uint16_t>(chunk + 14);
+            if (tag == 0xFFFE && available >= 26) {
+                tag = ReadLE<uint16_t>(chunk + 24);  // WAVE_FORMAT_EXTENSIBLE: start of the subformat GUID
+            }
+            format.channels = ReadLE<uint16_t>(chunk + 2);
+            format.sample_rate = ReadLE<uint32_t>(chunk + 4);
+            format.bytes_per_frame = ReadLE<uint16_t>(chunk + 12);
+            if (tag == 3 && bits == 32) {
+                format.encoding = SampleFormat::Encoding::Float32;
+            } else if (tag == 1 && bits == 16) {
+                format.encoding = SampleFormat::Encoding::Int16;
+            } else if (tag == 1 && bits == 24) {
+                format.encoding = SampleFormat::Encoding::Int24;
+            } else if (tag == 1 && bits == 32) {
+                format.encoding = SampleFormat::Encoding::Int32;
+            }
+        } else if (std::memcmp(data + offset, "data", 4) == 0) {
+            samples = chunk;
+            sample_bytes = available;
+        }
+        offset += 8 + static_cast<size_t>(chunk_size) + (chunk_size & 1);  // Chunks are word aligned
+    }
+
+    if (format.encoding == SampleFormat::Encoding::Unsupported || format.bytes_per_frame == 0 ||
+        format.sample_rate == 0 || !samples) {
+        *error = path + ": unsupported WAV format (16/24/32-bit PCM or 32-bit float only)";
+        return false;
+    }
+
+    size_t frames = sample_bytes / format.bytes_per_frame;
+    recording->name = path;
+    recording->sample_rate = format.sample_rate;
+    recording->left.resize(frames);
+    recording->right.resize(frames);
+    DecodeStereo(format, samples, frames, recording->left.data(), recording->right.data());
+    recording->labels = LoadLabels(LabelPath(path));
+    return true;
+}
+
+bool LoadTrace(const std::string& path, LevelTrack* track, std::string* error) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        *error = "can't open " + path;
+        return false;
+    }
+
+    trace::TraceHeader header;
+    if (file.Size() < sizeof(header)) {
+        *error = path + " is not a trace file";
+        return false;
+    }
+    std::memcpy(&header, file.Data(), sizeof(header));
+    if (std::memcmp(header.magic, trace::kMagic, sizeof(header.magic)) != 0 ||
+        header.record_size != sizeof(trace::TraceRecord) || header.header_size > file.Size()) {
+        *error = path + " is not a trace file";
+        return false;
+    }
+    if (header.version != trace::kVersion) {
+        *error = path + ": unsupported trace version " + std::to_string(header.version);
+        return false;
+    }
+
+    // The records are aligned in the file, so the mapping is the array
+    const trace::TraceRecord* records = reinterpret_cast<const trace::TraceRecord*>(file.Data() + header.header_size);
+    size_t count = (file.Size() - header.header_size) / sizeof(trace::TraceRecord);
+
+    track->name = path;
+    track->window_ms = static_cast<int>(header.window_ms);
+    track->hop_ms = static_cast<int>(header.hop_ms);
+    double unit_s = header.time_unit_us / 1e6;
+    uint64_t time_units = 0;
+    for (size_t i = 0; i < count; i++) {
+        const trace::TraceRecord& record = records[i];
+        time_units += record.dt;
+        switch (record.GetKind()) {
+            case trace::Kind::Block:
+                track->time_s.push_back(time_units * unit_s);
+                track->left.push_back(record.a * header.level_scale);
+                track->right.push_back(record.b * header.level_scale);
+                break;
+            case trace::Kind::Clock:
+                time_units += record.a | (static_cast<uint64_t>(record.b) << 16);
+                break;
+            case trace::Kind::Framing:
+                track->framing_changes++;
+                break;
+            case trace::Kind::Thresholds:
+            case trace::Kind::Analyzer:
+                break;  // Recomputed by the replay
+        }
+    }
+    track->labels = LoadLabels(LabelPath(path));
+    return true;
+}
+
+LevelTrack ComputeLevels(const Recording& recording, int window_ms, int hop_ms, const LevelSettings& level) {
+    LevelTrack track;
+    track.name = recording.name;
+    track.window_ms = window_ms;
+    track.hop_ms = hop_ms;
+    track.labels = recording.labels;
+
+    SourcePipeline* pipeline_ptr = nullptr;
+    SourcePipeline pipeline(recording.sample_rate, window_ms, hop_ms, level, 1.0f, [&] {
+        track.left.push_back(pipeline_ptr->LeftLevel());
+        track.right.push_back(pipeline_ptr->RightLevel());
+    });
+    pipeline_ptr = &pipeline;
+
+    size_t frames = recording.left.size();
+    size_t capacity = frames >= pipeline.WindowFrames()
+        ? (frames - pipeline.WindowFrames()) / pipeline.HopFrames() + 1 : 0;
+    track.left.reserve(capacity);
+    track.right.reserve(capacity);
+    pipeline.OnFrames(recording.left.data(), recording.right.data(), frames);
+
+    // Block k ends after window + k * hop frames
+    track.time_s.resize(track.left.size());
+    for (size_t k = 0; k < track.time_s.size(); k++) {
+        track.time_s[k] = static_cast<double>(pipeline.WindowFrames() + k * pipeline.HopFrames()) / recording.sample_rate;
+    }
+    return track;
+}
+
+ReplayResult Replay(const LevelTrack& track, const DetectionParams& params) {
+    ReplayResult result;
+    result.labels = track.labels.size();
+    if (!track.time_s.empty()) {
+        result.duration_s = track.time_s.back();
+    }
+
+    // Tracks from traces only have block times, so the detector counts
+    // microseconds as its frames; for WAV input that is exact to within one
+    EarDetector detector(params, kReplayRate);
+    uint64_t replayed = 0;
+
+    std::vector<bool> label_detected(track.labels.size(), false);
+    size_t first_label = 0;
+    double last_reset[2] = { -1e9, -1e9 };
+
+    for (size_t k = 0; k < track.time_s.size(); k++) {
+        double t = track.time_s[k];
+        uint64_t position = static_cast<uint64_t>(std::llround(t * kReplayRate));
+        uint32_t frames = static_cast<uint32_t>(std::min<uint64_t>(position - std::min(position, replayed), UINT32_MAX));
+        replayed = std::max(replayed, position);
+        bool was_overwhelmed = detector.IsOverwhelmed();
+        uint8_t decisions = detector.Process(track.left[k], track.right[k], frames);
+
+        if ((decisions & OverwhelmOn) && !was_overwhelmed) {
+            result.overwhelms++;
+        }
+        if (decisions & Suppressed) {
+            result.suppressed++;
+        }
+        if (decisions & LeftReset) last_reset[0] = t;
+        if (decisions & RightReset) last_reset[1] = t;
+
+        const uint8_t perk_bits[2] = { LeftPerk, RightPerk };
+        const uint8_t ear_bits[2] = { LeftPerked, RightPerked };
+        for (int ear = 0; ear < 2; ear++) {
+            if (!(decisions & perk_bits[ear])) continue;
+            result.perks++;
+            if (t - last_reset[ear] < kFlapWindowS) {
+                result.flaps++;
+            }
+            if (track.labels.empty()) continue;
+
+            // Labels that can no longer match are skipped for good
+            while (first_label < track.labels.size() &&
+                   std::max(track.labels[first_label].end_s, track.labels[first_label].start_s + kReactionWindowS) < t) {
+                first_label++;
+            }
+            bool expected = false;
+            for (size_t i = first_label; i < track.labels.size() && track.labels[i].start_s <= t; i++) {
+                const TunerLabel& label = track.labels[i];
+                if (!(label.ears & ear_bits[ear])) continue;
+                if (t <= std::max(label.end_s, label.start_s + kReactionWindowS)) {
+                    expected = true;
+                }
+                if (!label_detected[i] && t - label.start_s <= kReactionWindowS) {
+                    label_detected[i] = true;
+                    double latency_ms = (t - label.start_s) * 1000.0;
+                    result.detected++;
+                    result.latency_sum_ms += latency_ms;
+                    result.latency_max_ms = std::max(result.latency_max_ms, latency_ms);
+                }
+            }
+            if (!expected) {
+                result.unexpected++;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "config.hpp"
+
+// Offline replay of recorded audio through EarDetector, for finding good
+// detection settings without trial and error in the live UI.
+
+// A stretch of a recording where an ear should perk, e.g. from an
+// Audacity label track: "start<TAB>end<TAB>left|right|both"
+struct TunerLabel {
+    double start_s = 0.0;
+    double end_s = 0.0;
+    uint8_t ears = 0;  // EarState LeftPerked / RightPerked bits
+};
+
+// Decoded audio, shared read-only by every replay of it
+struct Recording {
+    std::string name;
+    unsigned sample_rate = 0;
+    std::vector<float> left;
+    std::vector<float> right;
+    std::vector<TunerLabel> labels;
+};
+
+// Block levels as the detector sees them, either computed from a
+// Recording for one window/hop and level detector, or read back from a
+// trace file
+struct LevelTrack {
+    std::string name;
+    int window_ms = 0;
+    int hop_ms = 0;
+    int framing_changes = 0;     // Traces only: reloads that changed window/hop
+    std::vector<double> time_s;  // End of each block
+    std::vector<float> left;
+    std::vector<float> right;
+    std::vector<TunerLabel> labels;
+};
+
+// 16/24/32-bit PCM or 32-bit float WAV. Labels are read from a .txt file
+// of the same name if there is one.
+bool LoadWav(const std::string& path, Recording* recording, std::string* error);
+
+// A file written by TraceRecorder, mapped rather than read. Its window
+// and hop are the ones it started with.
+bool LoadTrace(const std::string& path, LevelTrack* track, std::string* error);
+
+// Frames the recording exactly like the capture pipeline does
+LevelTrack ComputeLevels(const Recording& recording, int window_ms, int hop_ms, const LevelSettings& level);
+
+// One point of the sweep
+struct ParamSet {
+    DetectionParams params;
+    int window_ms = 0;
+    int hop_ms = 0;
+    LevelSettings level = {};
+};
+
+struct ReplayResult {
+    double duration_s = 0.0;
+    uint64_t perks = 0;         // Perk messages, left and right counted separately
+    uint64_t flaps = 0;         // Perks less than kFlapWindow after that ear was reset
+    uint64_t suppressed = 0;
+    uint64_t overwhelms = 0;    // Times overwhelm switched on
+    uint64_t labels = 0;
+    uint64_t detected = 0;      // Labels answered by a perk of the right ear in time
+    uint64_t unexpected = 0;    // Perks outside every label (when there are labels)
+    double latency_sum_ms = 0.0;
+    double latency_max_ms = 0.0;
+
+    void Add(const ReplayResult& other);
+};
+
+// A perk this soon after the same ear was reset counts as flapping
+const double kFlapWindowS = 1.0;
+
+// How long after a label starts a perk still counts as the reaction
+const double kReactionWindowS = 1.0;
+
+ReplayResult Replay(const LevelTrack& track, const DetectionParams& params);
@@ -0,0 +1,360 @@
+// EarPerkTuner: replays recordings through the ear detector for many
+// settings at once and reports how each one behaves.
+//
+//   EarPerkTuner [options] <file.wav | file.trace>...
+//
+//   --config PATH       Base settings (default: the app's config.ini)
+//   --set KEY=VALUES    Values to try for one setting, either a,b,c or
+//                       start:stop:step. Repeat for more settings.
+//   --random N          Try N random combinations instead of all of them
+//   --seed N            Seed for --random (default 1)
+//   --threads N         Worker threads (default: one per core)
+//   --output PATH       Write the CSV here instead of to stdout
+//
+// Keys are the config.ini names: differential_threshold, volume_threshold,
+// excessive_volume_threshold, timeout_ms, reset_timeout_ms,
+// volume_threshold_multiplier, excessive_threshold_multiplier,
+// auto_volume_threshold, auto_excessive_threshold, window_ms, hop_ms,
+// attack_ms and release_ms.
+//
+// Labels in <recording>.txt (Audacity label format, text "left", "right"
+// or "both") add detection and reaction latency columns.
+#include "config.hpp"
+#include "tuner.hpp"
+#include "work_stealing_pool.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+namespace {
+
+struct SweepKey {
+    const char* name;
+    std::function<void(ParamSet&, double)> apply;
+};
+
+const std::vector<SweepKey>& SweepKeys() {
+    static const std::vector<SweepKey> keys = {
+        { "differential_threshold", [](ParamSet& s, double v) { s.params.differential_threshold = static_cast<float>(v); } },
+        { "volume_threshold", [](ParamSet& s, double v) { s.params.volume_threshold = static_cast<float>(v); } },
+        { "excessive_volume_threshold", [](ParamSet& s, double v) { s.params.excessive_volume_threshold = static_cast<float>(v); } },
+        { "timeout_ms", [](ParamSet& s, double v) { s.params.timeout_ms = static_cast<int>(v); } },
+        { "reset_timeout_ms", [](ParamSet& s, double v) { s.params.reset_timeout_ms = static_cast<int>(v); } },
+        { "volume_threshold_multiplier", [](ParamSet& s, double v) { s.params.volume_threshold_multiplier = static_cast<float>(v); } },
+        { "excessive_threshold_multiplier", [](ParamSet& s, double v) { s.params.excessive_threshold_multiplier = static_cast<float>(v); } },
+        { "auto_volume_threshold", [](ParamSet& s, double v) { s.params.auto_volume_threshold = v != 0.0; } },
+        { "auto_excessive_threshold", [](ParamSet& s, double v) { s.params.auto_excessive_threshold = v != 0.0; } },
+        { "window_ms", [](ParamSet& s, double v) { s.window_ms = static_cast<int>(v); } },
+        { "hop_ms", [](ParamSet& s, double v) { s.hop_ms = static_cast<int>(v); } },
+        { "attack_ms", [](ParamSet& s, double v) { s.level.attack_ms = static_cast<int>(v); } },
+        { "release_ms", [](ParamSet& s, double v) { s.level.release_ms = static_cast<int>(v); } },
+    };
+    return keys;
+}
+
+// Everything block levels depend on; each distinct one is computed once
+// per recording
+struct LevelKey {
+    int window_ms;
+    int hop_ms;
+    LevelSettings level;
+
+    bool operator<(const LevelKey& other) const {
+        return std::tie(window_ms, hop_ms, level.detector, level.attack_ms, level.release_ms)
+            < std::tie(other.window_ms, other.hop_ms, other.level.detector, other.level.attack_ms, other.level.release_ms);
+    }
+};
+
+LevelKey KeyOf(const ParamSet& set) {
+    return { set.window_ms, set.hop_ms, set.level };
+}
+
+struct Sweep {
+    const SweepKey* key;
+    std::vector<double> values;
+};
+
+bool ParseValue(const std::string& text, double* value) {
+    if (text == "true") { *value = 1.0; return true; }
+    if (text == "false") { *value = 0.0; return true; }
+    char* end = nullptr;
+    *value = std::strtod(text.c_str(), &end);
+    return end && *end == '\0' && end != text.c_str();
+}
+
+// "timeout_ms=100,200,500" or "differential_threshold=0.05:0.3:0.05"
+bool ParseSweep(const std::string& arg, Sweep* sweep, std::string* error) {
+    size_t equals = arg.find('=');
+    std::string name = arg.substr(0, equals);
+    sweep->key = nullptr;
+    for (const auto& key : SweepKeys()) {
+        if (name == key.name) sweep->key = &key;
+    }
+    if (!sweep->key || equals == std::string::npos) {
+        *error = "unknown setting in --set " + arg;
+        return false;
+    }
+
+    std::string values = arg.substr(equals + 1);
+    std::vector<std::string> parts;
+    char separator = values.find(':') != std::string::npos ? ':' : ',';
+    std::stringstream stream(values);
+    for (std::string part; std::getline(stream, part, separator);) {
+        parts.push_back(part);
+    }
+
+    std::vector<double> numbers(parts.size());
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (!ParseValue(parts[i], &numbers[i])) {
+            *error = "bad value '" + parts[i] + "' in --set " + arg;
+            return false;
+        }
+    }
+
+    if (separator == ':') {
+        if (numbers.size() != 3 || numbers[2] <= 0.0 || numbers[1] < numbers[0]) {
+            *error = "ranges are start:stop:step, in --set " + arg;
+            return false;
+        }
+        // Half a step of slack so 0.1:0.3:0.1 includes 0.3
+        for (double v = numbers[0]; v <= numbers[1] + numbers[2] / 2; v += numbers[2]) {
+            sweep->values.push_back(v);
+        }
+    } else {
+        sweep->values = numbers;
+    }
+    return !sweep->values.empty();
+}
+
+std::string Describe(const ParamSet& set) {
+    const DetectionParams& p = set.params;
+    std::ostringstream out;
+    out << p.differential_threshold << ',' << p.volume_threshold << ',' << p.excessive_volume_threshold << ','
+        << p.timeout_ms << ',' << p.reset_timeout_ms << ','
+        << p.volume_threshold_multiplier << ',' << p.excessive_threshold_multiplier << ','
+        << (p.auto_volume_threshold ? "true" : "false") << ',' << (p.auto_excessive_threshold ? "true" : "false") << ','
+        << set.window_ms << ',' << set.hop_ms << ','
+        << LevelDetectorToString(set.level.detector) << ',' << set.level.attack_ms << ',' << set.level.release_ms;
+    return out.str();
+}
+
+bool IsTrace(const std::string& path) {
+    return path.size() >= 6 && path.compare(path.size() - 6, 6, ".trace") == 0;
+}
+
+int Usage() {
+    std::cerr << "Usage: EarPerkTuner [--config PATH] [--set KEY=VALUES]... [--random N] [--seed N]\n"
+                 "                    [--threads N] [--output PATH] <file.wav | file.trace>...\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string config_path;
+    std::string output_path;
+    std::vector<Sweep> sweeps;
+    std::vector<std::string> inputs;
+    size_t random_count = 0;
+    unsigned seed = 1;
+    unsigned threads = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--config" && has_value) {
+            config_path = argv[++i];
+        } else if (arg == "--set" && has_value) {
+            Sweep sweep;
+            std::string error;
+            if (!ParseSweep(argv[++i], &sweep, &error)) {
+                std::cerr << error << "\n";
+                return 2;
+            }
+            sweeps.push_back(sweep);
+        } else if (arg == "--random" && has_value) {
+            random_count = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--seed" && has_value) {
+            seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--threads" && has_value) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--output" && has_value) {
+            output_path = argv[++i];
+        } else if (!arg.empty() && arg[0] == '-') {
+            return Usage();
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        return Usage();
+    }
+
+    // Start from the saved settings; LoadFromFile would create a missing file
+    Config base;
+    std::string base_path = config_path.empty() ? Config::GetDefaultConfigPath() : config_path;
+    if (std::ifstream(base_path).good()) {
+        base.LoadFromFile(base_path);
+    } else if (!config_path.empty()) {
+        std::cerr << "Can't read " << config_path << "\n";
+        return 1;
+    }
+    ParamSet base_set;
+    base_set.params = base.GetDetectionParams();
+    base_set.window_ms = base.window_ms;
+    base_set.hop_ms = base.hop_ms;
+    base_set.level = base.GetLevelSettings();
+
+    // The grid, or a random sample of it
+    std::vector<ParamSet> sets;
+    size_t grid_size = 1;
+    for (const auto& sweep : sweeps) {
+        grid_size *= sweep.values.size();
+    }
+    if (random_count > 0) {
+        std::mt19937 rng(seed);
+        for (size_t n = 0; n < random_count; n++) {
+            ParamSet set = base_set;
+            for (const auto& sweep : sweeps) {
+                std::uniform_int_distribution<size_t> pick(0, sweep.values.size() - 1);
+                sweep.key->apply(set, sweep.values[pick(rng)]);
+            }
+            sets.push_back(set);
+        }
+    } else {
+        for (size_t n = 0; n < grid_size; n++) {
+            ParamSet set = base_set;
+            size_t index = n;
+            for (const auto& sweep : sweeps) {
+                sweep.key->apply(set, sweep.values[index % sweep.values.size()]);
+                index /= sweep.values.size();
+            }
+            sets.push_back(set);
+        }
+    }
+
+    WorkStealingPool pool(threads);
+    std::cerr << "Replaying " << inputs.size() << " file(s) with " << sets.size()
+              << " setting(s) on " << pool.Size() << " thread(s)\n";
+
+    // Decode every file once; all replays share the result read-only
+    std::vector<std::shared_ptr<const Recording>> recordings(inputs.size());
+    std::vector<std::shared_ptr<const LevelTrack>> traces(inputs.size());
+    std::vector<std::string> errors(inputs.size());
+    for (size_t f = 0; f < inputs.size(); f++) {
+        pool.Submit([&, f] {
+            if (IsTrace(inputs[f])) {
+                auto track = std::make_shared<LevelTrack>();
+                if (LoadTrace(inputs[f], track.get(), &errors[f])) traces[f] = track;
+            } else {
+                auto recording = std::make_shared<Recording>();
+                if (LoadWav(inputs[f], recording.get(), &errors[f])) recordings[f] = recording;
+            }
+        });
+    }
+    pool.Wait();
+    for (size_t f = 0; f < inputs.size(); f++) {
+        if (!errors[f].empty()) {
+            std::cerr << errors[f] << "\n";
+            return 1;
+        }
+    }
+
+    // Block levels only depend on window, hop and the level detector, so
+    // each geometry is computed once per recording; traces keep the levels
+    // they were recorded with
+    std::set<LevelKey> geometry_set;
+    for (const auto& set : sets) {
+        geometry_set.insert(KeyOf(set));
+    }
+    std::vector<LevelKey> geometries(geometry_set.begin(), geometry_set.end());
+    std::map<LevelKey, size_t> geometry_index;
+    for (size_t g = 0; g < geometries.size(); g++) {
+        geometry_index[geometries[g]] = g;
+    }
+
+    for (size_t f = 0; f < inputs.size(); f++) {
+        if (traces[f] && traces[f]->framing_changes > 0) {
+            std::cerr << inputs[f] << " changed window_ms/hop_ms " << traces[f]->framing_changes
+                      << " time(s) while recording; its blocks don't all share one framing\n";
+        }
+        if (traces[f] && geometries.size() > 1) {
+            std::cerr << inputs[f] << " was recorded with window_ms=" << traces[f]->window_ms
+                      << " hop_ms=" << traces[f]->hop_ms << "; window_ms/hop_ms/attack_ms/release_ms sweeps don't apply to it\n";
+        }
+    }
+
+    std::vector<std::vector<std::shared_ptr<const LevelTrack>>> tracks(
+        inputs.size(), std::vector<std::shared_ptr<const LevelTrack>>(geometries.size()));
+    for (size_t f = 0; f < inputs.size(); f++) {
+        for (size_t g = 0; g < geometries.size(); g++) {
+            if (traces[f]) {
+                tracks[f][g] = traces[f];
+                continue;
+            }
+            pool.Submit([&, f, g] {
+                tracks[f][g] = std::make_shared<LevelTrack>(
+                    ComputeLevels(*recordings[f], geometries[g].window_ms, geometries[g].hop_ms, geometries[g].level));
+            });
+        }
+    }
+    pool.Wait();
+    recordings.clear();  // Only the levels are needed from here on
+
+    // Every setting against every file; each task owns its result slot
+    std::vector<std::vector<ReplayResult>> results(sets.size(), std::vector<ReplayResult>(inputs.size()));
+    for (size_t s = 0; s < sets.size(); s++) {
+        size_t g = geometry_index[KeyOf(sets[s])];
+        for (size_t f = 0; f < inputs.size(); f++) {
+            pool.Submit([&, s, f, g] {
+                results[s][f] = Replay(*tracks[f][g], sets[s].params);
+            });
+        }
+    }
+    pool.Wait();
+
+    std::ofstream file;
+    if (!output_path.empty()) {
+        file.open(output_path);
+        if (!file) {
+            std::cerr << "Can't write " << output_path << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = output_path.empty() ? std::cout : file;
+
+    out << "differential_threshold,volume_threshold,excessive_volume_threshold,timeout_ms,reset_timeout_ms,"
+           "volume_threshold_multiplier,excessive_threshold_multiplier,auto_volume_threshold,auto_excessive_threshold,"
+           "window_ms,hop_ms,level_detector,attack_ms,release_ms,perks_per_min,flaps_per_min,suppressed,overwhelms,labels,detected,unexpected,"
+           "mean_latency_ms,max_latency_ms\n";
+    for (size_t s = 0; s < sets.size(); s++) {
+        ReplayResult total;
+        for (const auto& result : results[s]) {
+            total.Add(result);
+        }
+        double minutes = std::max(total.duration_s / 60.0, 1e-9);
+        char line[256];
+        std::snprintf(line, sizeof(line), ",%.2f,%.2f,%llu,%llu,%llu,%llu,%llu,",
+            total.perks / minutes, total.flaps / minutes,
+            static_cast<unsigned long long>(total.suppressed), static_cast<unsigned long long>(total.overwhelms),
+            static_cast<unsigned long long>(total.labels), static_cast<unsigned long long>(total.detected),
+            static_cast<unsigned long long>(total.unexpected));
+        out << Describe(sets[s]) << line;
+        if (total.detected > 0) {
+            std::snprintf(line, sizeof(line), "%.1f,%.1f", total.latency_sum_ms / total.detected, total.latency_max_ms);
+            out << line;
+        } else {
+            out << ",";
+        }
+        out << "\n";
+    }
+    return 0;
+}
@@ -92,8 +92,7 @@ public:
         return {volume_threshold, excessive_threshold};
     }
 
-    bool ShouldUpdate() const {
-        auto now = std::chrono::steady_clock::now();
+    bool ShouldUpdate(std::chrono::steady_clock::time_point now) const {
         auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_update).count();
         
         // Calculate current mean
@@ -141,8 +140,8 @@ public:
         return elapsed >= adjusted_interval;
     }
 
-    void UpdateTimestamp() {
-        last_update = std::chrono::steady_clock::now();
+    void UpdateTimestamp(std::chrono::steady_clock::time_point now) {
+        last_update = now;
     }
 
 private:
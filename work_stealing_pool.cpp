@@ -0,0 +1,127 @@
+#include "work_stealing_pool.hpp"
+#include <algorithm>
+
+namespace {
+
+// Which pool and worker the current thread is, if any
+thread_local const WorkStealingPool* current_pool = nullptr;
+thread_local unsigned current_index = 0;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned thread_count)
+    : next_queue(0)
+    , queued(0)
+    , pending(0)
+    , stopping(false)
+{
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < thread_count; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < thread_count; i++) {
+        workers.emplace_back(&WorkStealingPool::Run, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::Submit(Task task) {
+    unsigned index = current_pool == this
+        ? current_index
+        : next_queue.fetch_add(1, std::memory_order_relaxed) % Size();
+    // Counted first, so a worker can never finish it before it's counted
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued++;
+        pending++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    work_cv.notify_one();
+}
+
+void WorkStealingPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait(lock, [this] { return pending == 0; });
+    if (first_error) {
+        std::exception_ptr error = first_error;
+        first_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkStealingPool::Run(unsigned index) {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+        Task task;
+        if (TryPop(index, &task) || TrySteal(index, &task)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                queued--;
+            }
+
+            std::exception_ptr error;
+            try {
+                task();
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (error && !first_error) {
+                first_error = error;
+            }
+            if (--pending == 0) {
+                done_cv.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        work_cv.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            break;
+        }
+    }
+}
+
+bool WorkStealingPool::TryPop(unsigned index, Task* task) {
+    Queue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    *task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::TrySteal(unsigned thief, Task* task) {
+    // Start with the next worker so thieves spread out
+    for (unsigned offset = 1; offset < Size(); offset++) {
+        Queue& queue = *queues[(thief + offset) % Size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            *task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
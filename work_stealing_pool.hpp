@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads, each with its own deque of tasks. A
+// worker runs its newest task first and, once it runs dry, steals the
+// oldest task of another worker, so a mix of long and short tasks still
+// keeps every core busy without one shared queue everybody fights over.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // 0 threads means one per core
+    explicit WorkStealingPool(unsigned thread_count = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // From any thread; a task submitted from inside a task goes to the
+    // submitting worker's own deque
+    void Submit(Task task);
+
+    // Blocks until every submitted task has run. Rethrows the first
+    // exception a task threw. Not from inside a task.
+    void Wait();
+
+    unsigned Size() const { return static_cast<unsigned>(queues.size()); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void Run(unsigned index);
+    bool TryPop(unsigned index, Task* task);
+    bool TrySteal(unsigned thief, Task* task);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> next_queue;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    size_t queued;    // Submitted, not yet taken by a worker
+    size_t pending;   // Submitted, not yet finished
+    bool stopping;
+    std::exception_ptr first_error;
+};